@@ -7,6 +7,7 @@
 #include <matplot/axes_objects/bars.h>
 #include <matplot/core/axes.h>
 #include <matplot/util/common.h>
+#include <matplot/util/text_writer.h>
 #include <sstream>
 
 namespace matplot {
@@ -140,18 +141,18 @@ namespace matplot {
     }
 
     std::string bars::data_string() {
-        std::stringstream ss;
+        text_writer out(text_data_precision());
         double m = x_minimum_difference();
         double cw = cluster_width();
         for (size_t bar_group = 0; bar_group < ys_.size(); ++bar_group) {
             for (size_t i = 0; i < ys_[bar_group].size(); ++i) {
                 // <box center>    <box height>    <box width>
-                ss << "    " << x_end_point(bar_group, i) << " "
-                   << ys_[bar_group][i] << " " << m * cw << "\n";
+                out << "    " << x_end_point(bar_group, i) << " "
+                    << ys_[bar_group][i] << " " << m * cw << "\n";
             }
-            ss << "e\n";
+            out << "e\n";
         }
-        return ss.str();
+        return out.str();
     }
 
     bool bars::requires_colormap() { return false; }
@@ -330,4 +331,32 @@ namespace matplot {
         return *this;
     }
 
+    void bars::run_draw_commands() {
+        if (!visible_ || ys_.empty()) {
+            return;
+        }
+        maybe_update_face_colors();
+        const double half_width =
+            x_minimum_difference() * cluster_width() / 2.;
+        for (size_t bar_group = 0; bar_group < ys_.size(); ++bar_group) {
+            const color_array &face_color =
+                face_colors_[std::min(bar_group, face_colors_.size() - 1)];
+            std::vector<double> edge_x;
+            std::vector<double> edge_y;
+            for (size_t i = 0; i < ys_[bar_group].size(); ++i) {
+                const double x = x_end_point(bar_group, i);
+                const double y = ys_[bar_group][i];
+                if (!std::isfinite(x) || !std::isfinite(y)) {
+                    continue;
+                }
+                const double x1 = x - half_width;
+                const double x2 = x + half_width;
+                parent_->draw_rectangle(x1, x2, 0., y, face_color);
+                edge_x.insert(edge_x.end(), {x1, x1, x2, x2, x1, NaN});
+                edge_y.insert(edge_y.end(), {0., y, y, 0., 0., NaN});
+            }
+            parent_->draw_path(edge_x, edge_y, edge_color_);
+        }
+    }
+
 } // namespace matplot
\ No newline at end of file
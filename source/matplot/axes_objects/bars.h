@@ -36,6 +36,7 @@ namespace matplot {
 
       public /* xlim object virtual functions */:
         // std::string set_variables_string() override;
+        void run_draw_commands() override;
         std::string plot_string() override;
         std::string legend_string(const std::string &title) override;
         std::string data_string() override;
@@ -2,12 +2,29 @@
 // Created by Alan Freitas on 13/07/20.
 //
 
+#include <algorithm>
+#include <cmath>
+#include <iterator>
 #include <limits>
 #include <matplot/axes_objects/box_chart.h>
 #include <matplot/core/axes.h>
 #include <matplot/core/axes_object.h>
+#include <matplot/util/text_writer.h>
 #include <sstream>
 
+namespace {
+    /// Quantile of sorted values with linear interpolation
+    double sorted_quantile(const std::vector<double> &values, double p) {
+        const double position = p * (values.size() - 1);
+        const size_t i = static_cast<size_t>(position);
+        if (i + 1 >= values.size()) {
+            return values.back();
+        }
+        const double t = position - i;
+        return values[i] + t * (values[i + 1] - values[i]);
+    }
+} // namespace
+
 namespace matplot {
     box_chart::box_chart(class axes *parent) : axes_object(parent) {}
 
@@ -125,24 +142,52 @@ namespace matplot {
             x_data_ = std::vector<double>(y_data_.size(), 1.0);
         }
         std::vector<double> unique_groups = unique(x_data_);
-        std::stringstream ss;
+        text_writer out(text_data_precision());
         // for each group
         for (size_t i = 0; i < unique_groups.size(); ++i) {
             // for each point
             for (size_t j = 0; j < y_data_.size(); ++j) {
                 // if point is part of this group
                 if (unique_groups[i] == x_data_[j]) {
-                    ss << "    " << unique_groups[i] << "  " << y_data_[j]
-                       << "  " << box_width_ << "\n";
+                    out << "    " << unique_groups[i] << "  " << y_data_[j]
+                        << "  " << box_width_ << "\n";
                 }
             }
-            ss << "e\n";
+            out << "e\n";
         }
-        return ss.str();
+        return out.str();
     }
 
     bool box_chart::requires_colormap() { return false; }
 
+    double box_chart::xmax() {
+        if (x_data_.empty()) {
+            return 1. + box_width_ / 2.;
+        }
+        return *std::max_element(x_data_.begin(), x_data_.end()) +
+               box_width_ / 2.;
+    }
+
+    double box_chart::xmin() {
+        if (x_data_.empty()) {
+            return 1. - box_width_ / 2.;
+        }
+        return *std::min_element(x_data_.begin(), x_data_.end()) -
+               box_width_ / 2.;
+    }
+
+    double box_chart::ymax() {
+        return y_data_.empty()
+                   ? axes_object::ymax()
+                   : *std::max_element(y_data_.begin(), y_data_.end());
+    }
+
+    double box_chart::ymin() {
+        return y_data_.empty()
+                   ? axes_object::ymin()
+                   : *std::min_element(y_data_.begin(), y_data_.end());
+    }
+
     enum axes_object::axes_category box_chart::axes_category() {
         return axes_object::axes_category::two_dimensional;
     }
@@ -264,4 +309,69 @@ namespace matplot {
         return *this;
     }
 
+    void box_chart::run_draw_commands() {
+        maybe_update_face_color();
+        if (x_data_.empty()) {
+            x_data_ = std::vector<double>(y_data_.size(), 1.0);
+        }
+        std::vector<double> unique_groups = unique(x_data_);
+        const double half_width = box_width_ / 2.;
+        const double half_cap = half_width * cap_size_ / 6.;
+        std::vector<double> edge_x;
+        std::vector<double> edge_y;
+        std::vector<double> outlier_x;
+        std::vector<double> outlier_y;
+        for (const double group : unique_groups) {
+            std::vector<double> values;
+            for (size_t j = 0; j < y_data_.size(); ++j) {
+                if (x_data_[j] == group && std::isfinite(y_data_[j])) {
+                    values.emplace_back(y_data_[j]);
+                }
+            }
+            if (values.empty()) {
+                continue;
+            }
+            std::sort(values.begin(), values.end());
+            // Same quartiles and whiskers as gnuplot boxplots
+            const double q1 = sorted_quantile(values, 0.25);
+            const double q2 = sorted_quantile(values, 0.5);
+            const double q3 = sorted_quantile(values, 0.75);
+            const double range = 1.5 * (q3 - q1);
+            auto first_inside = std::lower_bound(values.begin(), values.end(),
+                                                 q1 - range);
+            auto last_inside =
+                std::upper_bound(values.begin(), values.end(), q3 + range);
+            const double lower_whisker = *first_inside;
+            const double upper_whisker = *std::prev(last_inside);
+            for (auto it = values.begin(); it != first_inside; ++it) {
+                outlier_x.emplace_back(group);
+                outlier_y.emplace_back(*it);
+            }
+            for (auto it = last_inside; it != values.end(); ++it) {
+                outlier_x.emplace_back(group);
+                outlier_y.emplace_back(*it);
+            }
+
+            const double left = group - half_width;
+            const double right = group + half_width;
+            if (box_style_ == box_chart::box_style_option::filled) {
+                parent_->draw_rectangle(left, right, q1, q3, face_color_);
+            }
+            edge_x.insert(edge_x.end(),
+                          {left, right, right, left, left, NaN, left, right,
+                           NaN, group, group, NaN, group, group, NaN,
+                           group - half_cap, group + half_cap, NaN,
+                           group - half_cap, group + half_cap, NaN});
+            edge_y.insert(edge_y.end(),
+                          {q1, q1, q3, q3, q1, NaN, q2, q2, NaN, q1,
+                           lower_whisker, NaN, q3, upper_whisker, NaN,
+                           lower_whisker, lower_whisker, NaN, upper_whisker,
+                           upper_whisker, NaN});
+        }
+        parent_->draw_path(edge_x, edge_y, edge_color_);
+        parent_->draw_markers(outlier_x, outlier_y, whisker_style_,
+                              6.f * whisker_size_, edge_color_,
+                              whisker_face_, edge_color_);
+    }
+
 } // namespace matplot
\ No newline at end of file
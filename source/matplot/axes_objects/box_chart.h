@@ -47,15 +47,16 @@ namespace matplot {
 
       public /* xlim object virtual functions */:
         std::string set_variables_string() override;
+        void run_draw_commands() override;
         std::string plot_string() override;
         // std::string legend_string(const std::string& title) override;
         std::string data_string() override;
         std::string unset_variables_string() override;
         bool requires_colormap() override;
-        // double xmax() override;
-        // double xmin() override;
-        // double ymax() override;
-        // double ymin() override;
+        double xmax() override;
+        double xmin() override;
+        double ymax() override;
+        double ymin() override;
         enum axes_object::axes_category axes_category() override;
 
       public /* useful functions for box_charts */:
@@ -7,6 +7,7 @@
 #include <matplot/axes_objects/labels.h>
 #include <matplot/core/axes.h>
 #include <matplot/util/common.h>
+#include <matplot/util/text_writer.h>
 #include <sstream>
 
 namespace matplot {
@@ -19,12 +20,16 @@ namespace matplot {
         : axes_object(parent), x_(x), y_(y), radius_(radius),
           start_angle_(start_angle), end_angle_(end_angle), color_(color) {}
 
-    std::string circles::plot_string() {
+    void circles::maybe_update_circles_color() {
         if (!user_face_color_ && color_.empty()) {
             // if user didn't set the color, get color from xlim
             face_color_ = parent_->get_color_and_bump();
             user_face_color_ = true;
         }
+    }
+
+    std::string circles::plot_string() {
+        maybe_update_circles_color();
         std::string str = " '-' with circles linecolor ";
         str += color_.empty() ? "\"" + to_string(face_color_) + "\""
                               : " variable ";
@@ -44,7 +49,7 @@ namespace matplot {
     }
 
     std::string circles::data_string() {
-        std::stringstream ss;
+        text_writer out(text_data_precision());
         for (size_t i = 0; i < x_.size(); ++i) {
             auto value_or_default = [](const std::vector<double> &v,
                                        size_t index, double default_value) {
@@ -57,23 +62,23 @@ namespace matplot {
                 }
             };
             if (color_.empty()) {
-                ss << "    " << x_[i] << " " << y_[i] << " "
-                   << value_or_default(radius_, i, 1) << " "
-                   << value_or_default(start_angle_, i, 0) << " "
-                   << value_or_default(end_angle_, i, 360) << "\n";
+                out << "    " << x_[i] << " " << y_[i] << " "
+                    << value_or_default(radius_, i, 1) << " "
+                    << value_or_default(start_angle_, i, 0) << " "
+                    << value_or_default(end_angle_, i, 360) << "\n";
             } else {
-                ss << "    " << x_[i] << " " << y_[i] << " "
-                   << value_or_default(radius_, i, 1) << " "
-                   << value_or_default(start_angle_, i, 0) << " "
-                   << value_or_default(end_angle_, i, 360) << " "
-                   << value_or_default(color_, i, 1) << "\n";
+                out << "    " << x_[i] << " " << y_[i] << " "
+                    << value_or_default(radius_, i, 1) << " "
+                    << value_or_default(start_angle_, i, 0) << " "
+                    << value_or_default(end_angle_, i, 360) << " "
+                    << value_or_default(color_, i, 1) << "\n";
             }
         }
-        ss << "e\n";
+        out << "e\n";
         if (labels_) {
-            ss << labels_->data_string();
+            out << labels_->data_string();
         }
-        return ss.str();
+        return out.str();
     }
 
     bool circles::requires_colormap() { return true; }
@@ -230,4 +235,80 @@ namespace matplot {
         return *this;
     }
 
+    void circles::run_draw_commands() {
+        if (!visible_) {
+            return;
+        }
+        maybe_update_circles_color();
+        auto value_or_default = [](const std::vector<double> &v, size_t index,
+                                   double default_value) {
+            if (v.size() > index) {
+                return v[index];
+            } else if (!v.empty()) {
+                return v[0];
+            } else {
+                return default_value;
+            }
+        };
+
+        // The radius is in units of the x axis, like in gnuplot, so
+        // we scale it in the y axis for the circles to be round
+        const auto [x_pixel, y_pixel] = parent_->pixel_size();
+        const double y_scale = y_pixel / x_pixel;
+
+        std::pair<double, double> color_range{0., 1.};
+        if (!color_.empty()) {
+            auto [min_it, max_it] =
+                std::minmax_element(color_.begin(), color_.end());
+            color_range = parent_->colormap_range(*min_it, *max_it);
+        }
+
+        const size_t n = std::min(x_.size(), y_.size());
+        for (size_t i = 0; i < n; ++i) {
+            const double r = value_or_default(radius_, i, 1);
+            const double start = value_or_default(start_angle_, i, 0);
+            const double end = value_or_default(end_angle_, i, 360);
+            const double span = std::min(end - start, 360.);
+            if (!std::isfinite(x_[i]) || !std::isfinite(y_[i]) ||
+                !std::isfinite(r) || !(span > 0.)) {
+                continue;
+            }
+            const bool full_circle = span >= 360.;
+
+            // Points of the arc
+            const size_t n_arc =
+                std::max<size_t>(2, static_cast<size_t>(std::ceil(span / 6.)));
+            std::vector<double> arc_x(n_arc + 1);
+            std::vector<double> arc_y(n_arc + 1);
+            for (size_t j = 0; j <= n_arc; ++j) {
+                const double a = (start + span * j / n_arc) * pi / 180.;
+                arc_x[j] = x_[i] + r * std::cos(a);
+                arc_y[j] = y_[i] + r * y_scale * std::sin(a);
+            }
+
+            // Fan of triangles from the center
+            std::vector<double> fill_x;
+            std::vector<double> fill_y;
+            for (size_t j = 0; j < n_arc; ++j) {
+                fill_x.insert(fill_x.end(), {x_[i], arc_x[j], arc_x[j + 1]});
+                fill_y.insert(fill_y.end(), {y_[i], arc_y[j], arc_y[j + 1]});
+            }
+            const color_array c =
+                color_.empty() ? face_color_
+                               : parent_->colormap_interpolation(
+                                     value_or_default(color_, i, 1),
+                                     color_range.first, color_range.second);
+            parent_->draw_triangles(fill_x, fill_y, c);
+
+            // Border, through the center if this is a sector
+            if (!full_circle) {
+                arc_x.insert(arc_x.begin(), x_[i]);
+                arc_y.insert(arc_y.begin(), y_[i]);
+                arc_x.emplace_back(x_[i]);
+                arc_y.emplace_back(y_[i]);
+            }
+            parent_->draw_path(arc_x, arc_y, line_color_);
+        }
+    }
+
 } // namespace matplot
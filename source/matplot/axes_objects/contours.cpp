@@ -3,17 +3,79 @@
 //
 
 #include <algorithm>
+#include <array>
 #include <cmath>
 #include <matplot/axes_objects/contours.h>
 #include <matplot/axes_objects/histogram.h>
 #include <matplot/core/axes.h>
 #include <matplot/freestanding/plot.h>
 #include <matplot/util/common.h>
+#include <matplot/util/text_writer.h>
 #include <numeric>
 #include <regex>
 #include <sstream>
 #include <unordered_set>
 
+namespace {
+    /// Clip a triangle to the region where lower <= z < upper and
+    /// append the result to x and y as triangles
+    void clip_triangle_to_band(const std::array<double, 3> &x,
+                               const std::array<double, 3> &y,
+                               const std::array<double, 3> &z, double lower,
+                               double upper, std::vector<double> &out_x,
+                               std::vector<double> &out_y) {
+        if (!std::isfinite(z[0]) || !std::isfinite(z[1]) ||
+            !std::isfinite(z[2])) {
+            return;
+        }
+        const auto [z_min, z_max] = std::minmax({z[0], z[1], z[2]});
+        if (z_max < lower || z_min >= upper) {
+            return;
+        }
+        // Clip the polygon against one level at a time. The result
+        // is a convex polygon with at most 5 vertices.
+        struct vertex {
+            double x;
+            double y;
+            double z;
+        };
+        std::vector<vertex> polygon{{x[0], y[0], z[0]},
+                                    {x[1], y[1], z[1]},
+                                    {x[2], y[2], z[2]}};
+        auto clip = [&](double level, bool keep_above) {
+            std::vector<vertex> clipped;
+            auto inside = [&](const vertex &v) {
+                return keep_above ? v.z >= level : v.z <= level;
+            };
+            for (size_t i = 0; i < polygon.size(); ++i) {
+                const vertex &a = polygon[i];
+                const vertex &b = polygon[(i + 1) % polygon.size()];
+                if (inside(a)) {
+                    clipped.emplace_back(a);
+                }
+                if (inside(a) != inside(b)) {
+                    const double t = (level - a.z) / (b.z - a.z);
+                    clipped.emplace_back(vertex{a.x + t * (b.x - a.x),
+                                                a.y + t * (b.y - a.y), level});
+                }
+            }
+            polygon = std::move(clipped);
+        };
+        if (z_min < lower) {
+            clip(lower, true);
+        }
+        if (z_max > upper) {
+            clip(upper, false);
+        }
+        for (size_t i = 1; i + 1 < polygon.size(); ++i) {
+            out_x.insert(out_x.end(),
+                         {polygon[0].x, polygon[i].x, polygon[i + 1].x});
+            out_y.insert(out_y.end(),
+                         {polygon[0].y, polygon[i].y, polygon[i + 1].y});
+        }
+    }
+} // namespace
+
 namespace matplot {
     contours::contours(class axes *parent, const vector_2d &X,
                        const vector_2d &Y, const vector_2d &Z,
@@ -762,7 +824,7 @@ namespace matplot {
 
         auto [lower_levels, upper_levels] = get_lowers_and_uppers();
 
-        std::stringstream ss;
+        text_writer out(text_data_precision());
         if (filled_) {
             // Plot the line segments
             // Create one filled curve for each segment of a contour.
@@ -783,17 +845,17 @@ namespace matplot {
                                                 ? lower_levels[level_index]
                                                 : upper_levels[level_index];
                 // Plot background polygon
-                ss << "    " << _xmin << "  " << _ymin << "  "
-                   << background_z_level << "\n";
-                ss << "    " << _xmin << "  " << _ymax << "  "
-                   << background_z_level << "\n";
-                ss << "    " << _xmax << "  " << _ymax << "  "
-                   << background_z_level << "\n";
-                ss << "    " << _xmax << "  " << _ymin << "  "
-                   << background_z_level << "\n";
-                ss << "    " << _xmin << "  " << _ymin << "  "
-                   << background_z_level << "\n";
-                ss << "    e\n";
+                out << "    " << _xmin << "  " << _ymin << "  "
+                    << background_z_level << "\n";
+                out << "    " << _xmin << "  " << _ymax << "  "
+                    << background_z_level << "\n";
+                out << "    " << _xmax << "  " << _ymax << "  "
+                    << background_z_level << "\n";
+                out << "    " << _xmax << "  " << _ymin << "  "
+                    << background_z_level << "\n";
+                out << "    " << _xmin << "  " << _ymin << "  "
+                    << background_z_level << "\n";
+                out << "    e\n";
             }
 
             for (size_t i = 0; i < line_segments_.size(); ++i) {
@@ -811,8 +873,8 @@ namespace matplot {
                         is_lower_level(line_index, begin_index, end_index);
                     double segment_z_level = is_ll ? lower_levels[line_index]
                                                    : upper_levels[line_index];
-                    ss << "    " << x << "  " << y << "  " << segment_z_level
-                       << "\n";
+                    out << "    " << x << "  " << y << "  " << segment_z_level
+                        << "\n";
 
                     // work-around for edge cases
                     bool is_one_before_last = j == end_index - 2;
@@ -845,20 +907,20 @@ namespace matplot {
                                 } else if (index_closest == 3) {
                                     y = _ymin;
                                 }
-                                ss << "    " << x << "  " << y << "  "
-                                   << segment_z_level << "\n";
+                                out << "    " << x << "  " << y << "  "
+                                    << segment_z_level << "\n";
                                 auto [xs, ys] = fill_border_jump(
                                     x, y, next_x, next_y, _xmin, _xmax, _ymin,
                                     _ymax, true);
                                 for (size_t k = 0; k < xs.size(); ++k) {
-                                    ss << "    " << xs[k] << "  " << ys[k]
-                                       << "  " << segment_z_level << "\n";
+                                    out << "    " << xs[k] << "  " << ys[k]
+                                        << "  " << segment_z_level << "\n";
                                 }
                             }
                         }
                     }
                 }
-                ss << "    e\n";
+                out << "    e\n";
                 // Send data for child/hole polygons
                 auto &child_segments = std::get<1>(parent_and_children);
                 for (size_t j = 0; j < child_segments.size(); ++j) {
@@ -876,8 +938,8 @@ namespace matplot {
                         double segment_z_level =
                             is_ll ? lower_levels[child_line_index]
                                   : upper_levels[child_line_index];
-                        ss << "    " << x << "  " << y << "  "
-                           << segment_z_level << "\n";
+                        out << "    " << x << "  " << y << "  "
+                            << segment_z_level << "\n";
                         if (k != child_end_index - 1) {
                             double next_x =
                                 filled_lines_[child_line_index].first[k + 1];
@@ -888,13 +950,13 @@ namespace matplot {
                                     x, y, next_x, next_y, _xmin, _xmax, _ymin,
                                     _ymax, true);
                                 for (size_t l = 0; l < xs.size(); ++l) {
-                                    ss << "    " << xs[l] << "  " << ys[l]
-                                       << "  " << segment_z_level << "\n";
+                                    out << "    " << xs[l] << "  " << ys[l]
+                                        << "  " << segment_z_level << "\n";
                                 }
                             }
                         }
                     }
-                    ss << "    e\n";
+                    out << "    e\n";
                 }
             }
 
@@ -953,11 +1015,11 @@ namespace matplot {
                     double yend = end_line < Y_data_.size() - 1
                                       ? Y_data_[end_line + 1][0]
                                       : _ymax;
-                    ss << "    " << _xmin << "  " << ybegin << "\n";
-                    ss << "    " << _xmin << "  " << yend << "\n";
-                    ss << "    " << _xmax << "  " << yend << "\n";
-                    ss << "    " << _xmax << "  " << ybegin << "\n";
-                    ss << "    " << _xmin << "  " << ybegin << "\n";
+                    out << "    " << _xmin << "  " << ybegin << "\n";
+                    out << "    " << _xmin << "  " << yend << "\n";
+                    out << "    " << _xmax << "  " << yend << "\n";
+                    out << "    " << _xmax << "  " << ybegin << "\n";
+                    out << "    " << _xmin << "  " << ybegin << "\n";
                     // jump the lines we are plotting already
                     i = end_line;
                 }
@@ -978,15 +1040,15 @@ namespace matplot {
                     double xend = end_col < X_data_[0].size() - 1
                                       ? X_data_[0][end_col + 1]
                                       : _xmax;
-                    ss << "    " << xbegin << "  " << _ymin << "\n";
-                    ss << "    " << xbegin << "  " << _ymax << "\n";
-                    ss << "    " << xend << "  " << _ymax << "\n";
-                    ss << "    " << xend << "  " << _ymin << "\n";
-                    ss << "    " << xbegin << "  " << _ymin << "\n";
+                    out << "    " << xbegin << "  " << _ymin << "\n";
+                    out << "    " << xbegin << "  " << _ymax << "\n";
+                    out << "    " << xend << "  " << _ymax << "\n";
+                    out << "    " << xend << "  " << _ymin << "\n";
+                    out << "    " << xbegin << "  " << _ymin << "\n";
                     // jump the lines we are plotting already
                     i = end_col;
                 }
-                ss << "    e\n";
+                out << "    e\n";
             }
         }
 
@@ -1005,14 +1067,14 @@ namespace matplot {
                 if (!is_separator(lines_[i].first[j], lines_[i].second[j])) {
                     double x = lines_[i].first[j];
                     double y = lines_[i].second[j];
-                    ss << "    " << x << "  " << y;
+                    out << "    " << x << "  " << y;
                     if (!line_spec_.user_color()) {
                         if (!filled_ || colormap_line_when_filled_) {
                             // plot palette colors
-                            ss << "  " << levels_[i];
+                            out << "  " << levels_[i];
                         }
                     }
-                    ss << "\n";
+                    out << "\n";
                 } else {
                     // Skip the next nans separating parents and children
                     // to avoid extra useless empty lines in case there is
@@ -1023,11 +1085,11 @@ namespace matplot {
                     }
                     // Include an empty line to indicate this polygon or line
                     // segment is over
-                    ss << "  \n";
+                    out << "  \n";
                     continue;
                 }
             }
-            ss << "e\n";
+            out << "e\n";
         }
 
         if (contour_text_) {
@@ -1150,25 +1212,25 @@ namespace matplot {
             // Send command for all labels at once
             for (size_t i = 0; i < labels_xs.size(); ++i) {
                 for (size_t j = 0; j < labels_xs[i].size(); ++j) {
-                    ss << "    " << labels_xs[i][j] << "  " << labels_ys[i][j]
-                       << " \"";
+                    out << "    " << labels_xs[i][j] << "  " << labels_ys[i][j]
+                        << " \"";
                     if (iequals(font_weight_, "bold")) {
-                        ss << "{/:Bold " << _levels[i] << "}";
+                        out << "{/:Bold " << _levels[i] << "}";
                     } else {
-                        ss << levels_[i];
+                        out << levels_[i];
                     }
-                    ss << "\"";
-                    ss << " " << labels_degrees[i][j];
-                    ss << "\n";
+                    out << "\"";
+                    out << " " << labels_degrees[i][j];
+                    out << "\n";
                 }
                 if (labels_xs[i].empty()) {
-                    ss << "\n";
+                    out << "\n";
                 }
-                ss << "e\n";
+                out << "e\n";
             }
         }
 
-        return ss.str();
+        return out.str();
     }
 
     bool contours::requires_colormap() { return true; }
@@ -1590,14 +1652,12 @@ namespace matplot {
         codes_.clear();
         if (filled_) {
             auto [lowers, uppers] = get_lowers_and_uppers();
-            for (size_t i = 0; i < lowers.size(); ++i) {
-                double level = lowers[i];
-                double level_upper = uppers[i];
-                auto [vertices, kinds] =
-                    contour_generator_.create_filled_contour(level,
-                                                             level_upper);
-                filled_lines_.emplace_back(vertices);
-                codes_.emplace_back(kinds);
+            // The levels are contoured in parallel
+            auto filled_contours =
+                contour_generator_.create_filled_contours(lowers, uppers);
+            for (auto &[vertices, kinds] : filled_contours) {
+                filled_lines_.emplace_back(std::move(vertices));
+                codes_.emplace_back(std::move(kinds));
             }
             // Identify line segments
             line_segments_.clear();
@@ -1688,9 +1748,8 @@ namespace matplot {
         }
         // Generate normal lines
         // Do not use the extended levels we used for the filled lines
-        for (const double &level : levels_) {
-            auto vertices = contour_generator_.create_contour(level);
-            lines_.emplace_back(vertices);
+        for (auto &vertices : contour_generator_.create_contours(levels_)) {
+            lines_.emplace_back(std::move(vertices));
         }
     }
 
@@ -1705,4 +1764,100 @@ namespace matplot {
         return *this;
     }
 
+    void contours::run_draw_commands() {
+        if (!visible_) {
+            return;
+        }
+        make_sure_data_is_preprocessed();
+        if (levels_.empty()) {
+            return;
+        }
+        auto [min_it, max_it] =
+            std::minmax_element(levels_.begin(), levels_.end());
+        const double contour_min_level = *min_it;
+        const double contour_max_level = *max_it;
+
+        if (filled_) {
+            // Fill the bands between levels, one cell triangle at a time.
+            // Each triangle only goes to the bands its z range overlaps,
+            // so we visit each cell once rather than once per band.
+            auto [lower_levels, upper_levels] = get_lowers_and_uppers();
+            const size_t n_bands = lower_levels.size();
+            const bool sorted =
+                std::is_sorted(lower_levels.begin(), lower_levels.end()) &&
+                std::is_sorted(upper_levels.begin(), upper_levels.end());
+            std::vector<std::vector<double>> band_x(n_bands);
+            std::vector<std::vector<double>> band_y(n_bands);
+            auto fill_triangle = [&](const std::array<double, 3> &tx,
+                                     const std::array<double, 3> &ty,
+                                     const std::array<double, 3> &tz) {
+                if (!std::isfinite(tz[0]) || !std::isfinite(tz[1]) ||
+                    !std::isfinite(tz[2])) {
+                    return;
+                }
+                const auto [z_min, z_max] = std::minmax({tz[0], tz[1], tz[2]});
+                // First band whose upper level is above the triangle
+                size_t k = 0;
+                if (sorted) {
+                    k = std::upper_bound(upper_levels.begin(),
+                                         upper_levels.end(), z_min) -
+                        upper_levels.begin();
+                }
+                for (; k < n_bands; ++k) {
+                    if (sorted && lower_levels[k] > z_max) {
+                        break;
+                    }
+                    clip_triangle_to_band(tx, ty, tz, lower_levels[k],
+                                          upper_levels[k], band_x[k],
+                                          band_y[k]);
+                }
+            };
+            for (size_t i = 0; i + 1 < Z_data_.size(); ++i) {
+                for (size_t j = 0; j + 1 < Z_data_[i].size(); ++j) {
+                    const std::array<size_t, 4> rows{i, i, i + 1, i + 1};
+                    const std::array<size_t, 4> cols{j, j + 1, j + 1, j};
+                    std::array<double, 4> cx{};
+                    std::array<double, 4> cy{};
+                    std::array<double, 4> cz{};
+                    for (size_t c = 0; c < 4; ++c) {
+                        cx[c] = X_data_[rows[c]][cols[c]];
+                        cy[c] = Y_data_[rows[c]][cols[c]];
+                        cz[c] = Z_data_[rows[c]][cols[c]];
+                    }
+                    fill_triangle({cx[0], cx[1], cx[2]}, {cy[0], cy[1], cy[2]},
+                                  {cz[0], cz[1], cz[2]});
+                    fill_triangle({cx[0], cx[2], cx[3]}, {cy[0], cy[2], cy[3]},
+                                  {cz[0], cz[2], cz[3]});
+                }
+            }
+            for (size_t k = 0; k < n_bands; ++k) {
+                parent_->draw_triangles(
+                    band_x[k], band_y[k],
+                    parent_->colormap_interpolation(lower_levels[k],
+                                                    contour_min_level,
+                                                    contour_max_level));
+            }
+        }
+
+        // plot normal contour lines
+        if (!line_spec_.has_line()) {
+            return;
+        }
+        for (size_t i = 0; i < lines_.size(); ++i) {
+            if (lines_[i].first.empty()) {
+                continue;
+            }
+            color_array c = line_spec_.color();
+            if (!line_spec_.user_color()) {
+                if (!filled_ || colormap_line_when_filled_) {
+                    c = parent_->colormap_interpolation(
+                        levels_[i], contour_min_level, contour_max_level);
+                } else {
+                    c = {0, 0, 0, 0};
+                }
+            }
+            parent_->draw_path(lines_[i].first, lines_[i].second, c);
+        }
+    }
+
 } // namespace matplot
\ No newline at end of file
@@ -5,6 +5,7 @@
 #include <matplot/axes_objects/error_bar.h>
 #include <matplot/core/axes.h>
 #include <matplot/util/common.h>
+#include <matplot/util/text_writer.h>
 #include <sstream>
 
 namespace matplot {
@@ -40,6 +41,7 @@ namespace matplot {
                                 : std::vector<double>({})) {}
 
     std::string error_bar::plot_string() {
+        merge_appended_points();
         // plot errorbar behind the line
         std::string res;
         const bool has_y_bar = !y_negative_delta_.empty();
@@ -74,47 +76,53 @@ namespace matplot {
     }
 
     std::string error_bar::data_string() {
+        merge_appended_points();
         // send data once more for the bar
         const bool has_y_bar = !y_negative_delta_.empty();
         const bool has_x_bar = !x_negative_delta_.empty();
         const bool has_xy_bar = has_y_bar && has_x_bar;
-        std::stringstream ss;
+        text_writer out(text_data_precision());
         if (has_xy_bar) {
             for (size_t i = 0; i < y_data_.size(); ++i) {
-                ss << "    " << x_data_[i] << " " << y_data_[i] << " "
-                   << x_data_[i] - x_negative_delta_[i] << " "
-                   << x_data_[i] + x_positive_delta_[i] << " "
-                   << y_data_[i] - y_negative_delta_[i] << " "
-                   << y_data_[i] + y_positive_delta_[i] << "\n";
+                out << "    " << x_data_[i] << " " << y_data_[i] << " "
+                    << x_data_[i] - x_negative_delta_[i] << " "
+                    << x_data_[i] + x_positive_delta_[i] << " "
+                    << y_data_[i] - y_negative_delta_[i] << " "
+                    << y_data_[i] + y_positive_delta_[i] << "\n";
             }
-            ss << "    e\n";
+            out << "    e\n";
         } else if (has_x_bar) {
             for (size_t i = 0; i < y_data_.size(); ++i) {
-                ss << "    " << x_data_[i] << " " << y_data_[i] << " "
-                   << x_data_[i] - x_negative_delta_[i] << " "
-                   << x_data_[i] + x_positive_delta_[i] << "\n";
+                out << "    " << x_data_[i] << " " << y_data_[i] << " "
+                    << x_data_[i] - x_negative_delta_[i] << " "
+                    << x_data_[i] + x_positive_delta_[i] << "\n";
             }
-            ss << "    e\n";
+            out << "    e\n";
         } else if (has_y_bar) {
             if (!filled_curve_) {
                 for (size_t i = 0; i < y_data_.size(); ++i) {
-                    ss << "    " << x_data_[i] << " " << y_data_[i] << " "
-                       << y_data_[i] - y_negative_delta_[i] << " "
-                       << y_data_[i] + y_positive_delta_[i] << "\n";
+                    out << "    " << x_data_[i] << " " << y_data_[i] << " "
+                        << y_data_[i] - y_negative_delta_[i] << " "
+                        << y_data_[i] + y_positive_delta_[i] << "\n";
                 }
-                ss << "    e\n";
+                out << "    e\n";
             } else {
                 for (size_t i = 0; i < y_data_.size(); ++i) {
-                    ss << "    " << x_data_[i] << " "
-                       << y_data_[i] + y_positive_delta_[i] << " "
-                       << y_data_[i] - y_negative_delta_[i] << "\n";
+                    out << "    " << x_data_[i] << " "
+                        << y_data_[i] + y_positive_delta_[i] << " "
+                        << y_data_[i] - y_negative_delta_[i] << "\n";
                 }
-                ss << "    e\n";
+                out << "    e\n";
             }
         }
         // send data for foreground line as usual
-        ss << line::data_string();
-        return ss.str();
+        out << line::data_string();
+        return out.str();
+    }
+
+    bool error_bar::supports_binary_data() {
+        // The error bars are sent in the same blocks as the line data
+        return false;
     }
 
     bool error_bar::requires_colormap() { return line::requires_colormap(); }
@@ -206,4 +214,74 @@ namespace matplot {
         return *this;
     }
 
+    void error_bar::run_draw_commands() {
+        merge_appended_points();
+        if (!visible_) {
+            return;
+        }
+        maybe_update_line_spec();
+        const bool has_y_bar = !y_negative_delta_.empty();
+        const bool has_x_bar = !x_negative_delta_.empty();
+        const size_t n = std::min(x_data_.size(), y_data_.size());
+        auto delta = [](const std::vector<double> &v, size_t i) {
+            return i < v.size() ? v[i] : 0.;
+        };
+
+        if (has_y_bar && !has_x_bar && filled_curve_) {
+            // Band between the lower and upper errors
+            color_array c = line_spec_.color();
+            c[0] = filled_curve_alpha_;
+            std::vector<double> fill_x;
+            std::vector<double> fill_y;
+            for (size_t i = 0; i + 1 < n; ++i) {
+                const double x1 = x_data_[i];
+                const double x2 = x_data_[i + 1];
+                const double low1 = y_data_[i] - delta(y_negative_delta_, i);
+                const double low2 =
+                    y_data_[i + 1] - delta(y_negative_delta_, i + 1);
+                const double high1 = y_data_[i] + delta(y_positive_delta_, i);
+                const double high2 =
+                    y_data_[i + 1] + delta(y_positive_delta_, i + 1);
+                fill_x.insert(fill_x.end(), {x1, x2, x2, x1, x2, x1});
+                fill_y.insert(fill_y.end(),
+                              {low1, low2, high2, low1, high2, high1});
+            }
+            parent_->draw_triangles(fill_x, fill_y, c);
+        } else if (has_x_bar || has_y_bar) {
+            // Bars with caps, whose size is in pixels
+            const auto [x_pixel, y_pixel] = parent_->pixel_size();
+            const double x_cap = cap_size_ * x_pixel;
+            const double y_cap = cap_size_ * y_pixel;
+            std::vector<double> bars_x;
+            std::vector<double> bars_y;
+            for (size_t i = 0; i < n; ++i) {
+                const double x = x_data_[i];
+                const double y = y_data_[i];
+                if (has_y_bar) {
+                    const double low = y - delta(y_negative_delta_, i);
+                    const double high = y + delta(y_positive_delta_, i);
+                    bars_x.insert(bars_x.end(), {x, x, NaN, x - x_cap,
+                                                 x + x_cap, NaN, x - x_cap,
+                                                 x + x_cap, NaN});
+                    bars_y.insert(bars_y.end(),
+                                  {low, high, NaN, low, low, NaN, high, high,
+                                   NaN});
+                }
+                if (has_x_bar) {
+                    const double left = x - delta(x_negative_delta_, i);
+                    const double right = x + delta(x_positive_delta_, i);
+                    bars_x.insert(bars_x.end(), {left, right, NaN, left, left,
+                                                 NaN, right, right, NaN});
+                    bars_y.insert(bars_y.end(), {y, y, NaN, y - y_cap,
+                                                 y + y_cap, NaN, y - y_cap,
+                                                 y + y_cap, NaN});
+                }
+            }
+            parent_->draw_path(bars_x, bars_y, line_spec_.color());
+        }
+
+        // plot line over the errorbar
+        line::run_draw_commands();
+    }
+
 } // namespace matplot
\ No newline at end of file
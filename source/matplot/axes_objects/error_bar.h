@@ -41,8 +41,10 @@ namespace matplot {
 
       public /* override the plotting function for error_bar */:
         std::string set_variables_string() override;
+        void run_draw_commands() override;
         std::string plot_string() override;
         std::string data_string() override;
+        bool supports_binary_data() override;
         bool requires_colormap() override;
         std::string unset_variables_string() override;
         enum axes_object::axes_category axes_category() override;
@@ -5,6 +5,7 @@
 #include <cmath>
 #include <matplot/axes_objects/filled_area.h>
 #include <matplot/core/axes.h>
+#include <matplot/util/text_writer.h>
 #include <sstream>
 
 namespace matplot {
@@ -34,6 +35,7 @@ namespace matplot {
     }
 
     std::string filled_area::plot_string() {
+        merge_appended_points();
         // we get the fill color and not the line spec from the xlim
         maybe_update_face_color();
 
@@ -56,80 +58,106 @@ namespace matplot {
     }
 
     std::string filled_area::data_string() {
-        std::stringstream ss;
+        merge_appended_points();
+        text_writer out(text_data_precision());
 
         std::vector<double> stacked_data;
+        // Points we send if the area is decimated (all points if empty)
+        std::vector<size_t> indices;
+        auto n_points = [&]() {
+            return indices.empty() ? y_data_.size() : indices.size();
+        };
+        auto index_of = [&](size_t j) {
+            return indices.empty() ? j : indices[j];
+        };
         if (!stacked_) {
             // send data for filled curve
-            for (size_t i = 0; i < y_data_.size(); ++i) {
+            indices = decimate(y_data_);
+            for (size_t j = 0; j < n_points(); ++j) {
+                const size_t i = index_of(j);
                 if (std::isfinite(y_data_[i])) {
-                    double base_value = base_data_.empty() ? 0.0
-                                        : base_data_.size() == 1
-                                            ? base_data_[0]
-                                            : base_data_[i];
-                    ss << "    " << x_data_[i] << " " << base_value << " "
-                       << y_data_[i] << "\n";
+                    out << "    " << x_data_[i] << " " << base_value(i) << " "
+                        << y_data_[i] << "\n";
                 } else {
-                    ss << "    \n";
+                    out << "    \n";
                 }
             }
-            ss << "    e\n";
+            out << "    e\n";
         } else {
-            // If the area is stacked, the data for filled curve needs
-            // to consider previous area plots in the xlim. Also,
-            // the sooner it comes in the xlim, the more in the background.
-            // So we stack the y_values with all y_values that come *after*
-            // the area in the xlim
-            stacked_data = y_data_;
-            for (auto children_it = parent_->children().rbegin();
-                 children_it != parent_->children().rend(); ++children_it) {
-                const auto &child = *children_it;
-                auto ptr = dynamic_cast<filled_area *>(child.get());
-                if (ptr != nullptr) {
-                    if (ptr != this) {
-                        size_t n =
-                            std::min(stacked_data.size(), ptr->y_data_.size());
-                        for (size_t i = 0; i < n; ++i) {
-                            stacked_data[i] += ptr->y_data_[i];
-                        }
-                    } else {
-                        break;
-                    }
-                }
-            }
+            stacked_data = stacked_y_data();
             // send data
-            for (size_t i = 0; i < stacked_data.size(); ++i) {
-                double base_value = base_data_.empty()       ? 0.0
-                                    : base_data_.size() == 1 ? base_data_[0]
-                                                             : base_data_[i];
-                ss << "    " << x_data_[i] << " " << base_value << " "
-                   << stacked_data[i] << "\n";
+            indices = decimate(stacked_data);
+            for (size_t j = 0; j < n_points(); ++j) {
+                const size_t i = index_of(j);
+                out << "    " << x_data_[i] << " " << base_value(i) << " "
+                    << stacked_data[i] << "\n";
             }
-            ss << "    e\n";
+            out << "    e\n";
         }
 
         // send data for base line
-        for (size_t i = 0; i < y_data_.size(); ++i) {
-            double base_value = base_data_.empty()       ? 0.0
-                                : base_data_.size() == 1 ? base_data_[0]
-                                                         : base_data_[i];
-            if (std::isfinite(base_value) && std::isfinite(x_data_[i])) {
-                ss << "    " << x_data_[i] << " " << base_value << "\n";
+        for (size_t j = 0; j < n_points(); ++j) {
+            const size_t i = index_of(j);
+            const double base = base_value(i);
+            if (std::isfinite(base) && std::isfinite(x_data_[i])) {
+                out << "    " << x_data_[i] << " " << base << "\n";
             } else {
-                ss << "    \n";
+                out << "    \n";
             }
         }
-        ss << "    e\n";
+        out << "    e\n";
 
         // send data for foreground line as usual
         if (!stacked_) {
-            ss << line::data_string();
+            out << line::data_string();
         } else {
             std::swap(y_data_, stacked_data);
-            ss << line::data_string();
+            out << line::data_string();
             std::swap(y_data_, stacked_data);
         }
-        return ss.str();
+        return out.str();
+    }
+
+    std::vector<double> filled_area::stacked_y_data() {
+        // If the area is stacked, the data for filled curve needs
+        // to consider previous area plots in the xlim. Also,
+        // the sooner it comes in the xlim, the more in the background.
+        // So we stack the y_values with all y_values that come *after*
+        // the area in the xlim
+        std::vector<double> stacked_data = y_data_;
+        for (auto children_it = parent_->children().rbegin();
+             children_it != parent_->children().rend(); ++children_it) {
+            const auto &child = *children_it;
+            auto ptr = dynamic_cast<filled_area *>(child.get());
+            if (ptr != nullptr) {
+                if (ptr != this) {
+                    size_t n =
+                        std::min(stacked_data.size(), ptr->y_data_.size());
+                    for (size_t i = 0; i < n; ++i) {
+                        stacked_data[i] += ptr->y_data_[i];
+                    }
+                } else {
+                    break;
+                }
+            }
+        }
+        return stacked_data;
+    }
+
+    double filled_area::base_value(size_t i) const {
+        return base_data_.empty()       ? 0.0
+               : base_data_.size() == 1 ? base_data_[0]
+                                        : base_data_[i];
+    }
+
+    bool filled_area::supports_binary_data() {
+        // The data for this object is not the line data
+        return false;
+    }
+
+    bool filled_area::data_is_self_contained() {
+        // Stacked areas depend on the other objects in the axes
+        return false;
     }
 
     enum axes_object::axes_category filled_area::axes_category() {
@@ -176,4 +204,47 @@ namespace matplot {
         return *this;
     }
 
+    void filled_area::run_draw_commands() {
+        merge_appended_points();
+        if (!visible_ || x_data_.empty()) {
+            return;
+        }
+        maybe_update_face_color();
+        std::vector<double> top = stacked_ ? stacked_y_data() : y_data_;
+        const size_t n = std::min(x_data_.size(), top.size());
+
+        // Two triangles between each pair of points and the base
+        std::vector<double> fill_x;
+        std::vector<double> fill_y;
+        std::vector<double> base(n);
+        for (size_t i = 0; i < n; ++i) {
+            base[i] = base_value(i);
+        }
+        for (size_t i = 0; i + 1 < n; ++i) {
+            const double x1 = x_data_[i];
+            const double x2 = x_data_[i + 1];
+            if (!std::isfinite(x1) || !std::isfinite(x2) ||
+                !std::isfinite(top[i]) || !std::isfinite(top[i + 1]) ||
+                !std::isfinite(base[i]) || !std::isfinite(base[i + 1])) {
+                continue;
+            }
+            fill_x.insert(fill_x.end(), {x1, x2, x2, x1, x2, x1});
+            fill_y.insert(fill_y.end(), {base[i], base[i + 1], top[i + 1],
+                                         base[i], top[i + 1], top[i]});
+        }
+        parent_->draw_triangles(fill_x, fill_y, face_color_);
+
+        // plot base line
+        if (plot_base_line_ && line_spec_.has_line()) {
+            parent_->draw_path(std::vector<double>(x_data_.begin(),
+                                                   x_data_.begin() + n),
+                               base, line_spec_.color());
+        }
+
+        // plot line as usual
+        std::swap(y_data_, top);
+        line::run_draw_commands();
+        std::swap(y_data_, top);
+    }
+
 } // namespace matplot
\ No newline at end of file
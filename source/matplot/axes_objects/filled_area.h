@@ -30,8 +30,11 @@ namespace matplot {
             : filled_area(parent.get(), args...) {}
 
       public /* override the plotting function for filled_area */:
+        void run_draw_commands() override;
         std::string plot_string() override;
         std::string data_string() override;
+        bool supports_binary_data() override;
+        bool data_is_self_contained() override;
         enum axes_object::axes_category axes_category() override;
 
       public /* methods for filled_area only */:
@@ -53,6 +56,13 @@ namespace matplot {
       private:
         void maybe_update_face_color();
 
+        /// The y values of this area on top of the areas that
+        /// come after it in the axes
+        std::vector<double> stacked_y_data();
+
+        /// Value of the base at index i
+        double base_value(size_t i) const;
+
       protected:
         bool stacked_{true};
 
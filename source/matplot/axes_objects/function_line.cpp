@@ -2,7 +2,9 @@
 // Created by Alan Freitas on 10/07/20.
 //
 
+#include <algorithm>
 #include <matplot/axes_objects/function_line.h>
+#include <matplot/util/adaptive_curve.h>
 #include <matplot/util/common.h>
 
 namespace matplot {
@@ -42,7 +44,7 @@ namespace matplot {
             return t_range_[1];
         } else {
             make_sure_data_is_preprocessed();
-            return line::xmax();
+            return clamp_to_window(0, line::xmax());
         }
     }
 
@@ -51,18 +53,18 @@ namespace matplot {
             return t_range_[0];
         } else {
             make_sure_data_is_preprocessed();
-            return line::xmin();
+            return clamp_to_window(0, line::xmin());
         }
     }
 
     double function_line::ymin() {
         make_sure_data_is_preprocessed();
-        return line::ymin();
+        return clamp_to_window(1, line::ymin());
     }
 
     double function_line::ymax() {
         make_sure_data_is_preprocessed();
-        return line::ymax();
+        return clamp_to_window(1, line::ymax());
     }
 
     enum axes_object::axes_category function_line::axes_category() {
@@ -82,19 +84,19 @@ namespace matplot {
     class function_line &
     function_line::fn(const std::function<double(double)> &fn) {
         fn_x_ = fn;
-        touch();
+        invalidate_data();
         return *this;
     }
 
     class function_line &function_line::tmin(double x) {
         t_range_[0] = x;
-        touch();
+        invalidate_data();
         return *this;
     }
 
     class function_line &function_line::tmax(double x) {
         t_range_[1] = x;
-        touch();
+        invalidate_data();
         return *this;
     }
 
@@ -109,7 +111,7 @@ namespace matplot {
     class function_line &
     function_line::t_range(const std::array<double, 2> &t_range) {
         t_range_ = t_range;
-        touch();
+        invalidate_data();
         return *this;
     }
 
@@ -118,48 +120,44 @@ namespace matplot {
     }
 
     void function_line::make_sure_data_is_preprocessed() {
-        if (fn_x_ && !fn_y_) {
-            bool mesh_is_ok =
-                automatic_mesh_density_ ||
-                (!automatic_mesh_density_ && x_data().size() == mesh_density_);
-            // put the t_data directly in x_data as they are equal anyway
-            if (!mesh_is_ok || x_data_.empty() ||
-                x_data_.front() != t_range_[0] ||
-                x_data_.back() != t_range_[1]) {
-                x_data_ =
-                    linspace(t_range_[0], t_range_[1],
-                             automatic_mesh_density_ ? 500 : mesh_density_);
-                y_data_ = transform(x_data_, fn_x_);
-            }
-        } else if ((fn_x_ && !fn_z_)) {
-            // proprocess t_data and use it to calculate x and y data
-            bool mesh_is_ok =
-                automatic_mesh_density_ ||
-                (!automatic_mesh_density_ && t_data_.size() == mesh_density_);
-            if (!mesh_is_ok || t_data_.empty() ||
-                t_data_.front() != t_range_[0] ||
-                t_data_.back() != t_range_[1]) {
-                t_data_ =
-                    linspace(t_range_[0], t_range_[1],
-                             automatic_mesh_density_ ? 500 : mesh_density_);
-                x_data_ = transform(t_data_, fn_x_);
-                y_data_ = transform(t_data_, fn_y_);
-            }
+        if (data_is_up_to_date_ || !fn_x_) {
+            return;
+        }
+        // Functions of x are curves of (x, f(x))
+        std::vector<adaptive_curve::function_type> fns;
+        if (!fn_y_) {
+            fns = {[](double x) { return x; }, fn_x_};
+        } else if (!fn_z_) {
+            fns = {fn_x_, fn_y_};
         } else {
-            bool mesh_is_ok =
-                automatic_mesh_density_ ||
-                (!automatic_mesh_density_ && t_data_.size() == mesh_density_);
-            if (!mesh_is_ok || t_data_.empty() ||
-                t_data_.front() != t_range_[0] ||
-                t_data_.back() != t_range_[1]) {
-                t_data_ =
-                    linspace(t_range_[0], t_range_[1],
-                             automatic_mesh_density_ ? 500 : mesh_density_);
-                x_data_ = transform(t_data_, fn_x_);
-                y_data_ = transform(t_data_, fn_y_);
-                z_data_ = transform(t_data_, fn_z_);
-            }
+            fns = {fn_x_, fn_y_, fn_z_};
+        }
+        adaptive_curve curve(
+            fns, t_range_, automatic_mesh_density_ ? 65 : mesh_density_,
+            automatic_mesh_density_ ? 10 : 0, parallel_evaluation_);
+        t_data_ = curve.t();
+        x_data_ = curve.values(0);
+        y_data_ = curve.values(1);
+        if (fn_z_) {
+            z_data_ = curve.values(2);
+        }
+        windows_.clear();
+        if (curve.has_asymptotes()) {
+            windows_ = {curve.window(0), curve.window(1)};
+        }
+        data_is_up_to_date_ = true;
+    }
+
+    void function_line::invalidate_data() {
+        data_is_up_to_date_ = false;
+        touch();
+    }
+
+    double function_line::clamp_to_window(size_t k, double bound) const {
+        if (windows_.empty() || polar_) {
+            return bound;
         }
+        return std::clamp(bound, windows_[k].first, windows_[k].second);
     }
 
     size_t function_line::mesh_density() const { return mesh_density_; }
@@ -168,7 +166,7 @@ namespace matplot {
         if (mesh_density != mesh_density_ || automatic_mesh_density_) {
             mesh_density_ = mesh_density;
             automatic_mesh_density_ = false;
-            touch();
+            invalidate_data();
         }
         return *this;
     }
@@ -179,11 +177,21 @@ namespace matplot {
 
     class function_line &
     function_line::automatic_mesh_density(bool automatic_mesh_density) {
-        if (automatic_mesh_density_ == automatic_mesh_density) {
+        if (automatic_mesh_density_ != automatic_mesh_density) {
             automatic_mesh_density_ = automatic_mesh_density;
-            touch();
+            invalidate_data();
         }
         return *this;
     }
 
+    bool function_line::parallel_evaluation() const {
+        return parallel_evaluation_;
+    }
+
+    class function_line &
+    function_line::parallel_evaluation(bool parallel_evaluation) {
+        parallel_evaluation_ = parallel_evaluation;
+        return *this;
+    }
+
 } // namespace matplot
\ No newline at end of file
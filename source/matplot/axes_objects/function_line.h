@@ -9,6 +9,8 @@
 #include <matplot/core/line_spec.h>
 #include <matplot/util/handle_types.h>
 #include <string>
+#include <utility>
+#include <vector>
 
 namespace matplot {
     class function_line : public line {
@@ -63,18 +65,36 @@ namespace matplot {
         size_t mesh_density() const;
         class function_line &mesh_density(size_t mesh_density);
 
+        /// With an automatic mesh density, we sample more where the
+        /// curve bends and break it at asymptotes. Otherwise, we use
+        /// mesh_density uniform samples.
         bool automatic_mesh_density() const;
         class function_line &
         automatic_mesh_density(bool automatic_mesh_density);
 
+        /// Evaluate the functions from several threads at once
+        /// The functions should then be safe to call concurrently.
+        bool parallel_evaluation() const;
+        class function_line &parallel_evaluation(bool parallel_evaluation);
+
       private:
         void make_sure_data_is_preprocessed();
 
+        /// Sample the data again the next time we need it
+        void invalidate_data();
+
+        /// Limit the bounds of dimension k to its window
+        double clamp_to_window(size_t k, double bound) const;
+
       private:
         std::array<double, 2> t_range_;
         std::vector<double> t_data_{};
         size_t mesh_density_{30};
         bool automatic_mesh_density_{true};
+        bool parallel_evaluation_{false};
+        bool data_is_up_to_date_{false};
+        /// Range where most of x and y are, if the curve has asymptotes
+        std::vector<std::pair<double, double>> windows_;
         function_type fn_x_{nullptr};
         function_type fn_y_{nullptr};
         function_type fn_z_{nullptr};
@@ -4,12 +4,87 @@
 
 #include <algorithm>
 #include <cmath>
+#include <limits>
 #include <matplot/axes_objects/histogram.h>
 #include <matplot/core/axes.h>
 #include <matplot/util/common.h>
+#include <matplot/util/text_writer.h>
+#include <matplot/util/thread_pool.h>
 #include <sstream>
 
 namespace matplot {
+    namespace {
+        // Values each task of a parallel pass reads
+        constexpr size_t values_per_task = size_t(1) << 20;
+
+        // Run worker(first, last, w) over ranges of n values, with one
+        // worker per thread if there are many values. Each worker w
+        // takes every n_workers-th range, so workers can keep their
+        // own partial results and we only combine n_workers of them.
+        template <class Worker>
+        size_t for_each_range(size_t n, Worker worker) {
+            const size_t n_ranges =
+                (n + values_per_task - 1) / values_per_task;
+            thread_pool &pool = thread_pool::shared();
+            const size_t n_workers = std::min(n_ranges, pool.n_threads() + 1);
+            if (n_workers <= 1) {
+                worker(0, n, 0);
+                return 1;
+            }
+            pool.run_all(n_workers, [&](size_t w) {
+                for (size_t r = w; r < n_ranges; r += n_workers) {
+                    worker(r * values_per_task,
+                           std::min(n, (r + 1) * values_per_task), w);
+                }
+            });
+            return n_workers;
+        }
+
+        // Lowest and highest values in one pass, ignoring NaN
+        std::pair<double, double> data_limits(const std::vector<double> &x) {
+            std::vector<std::pair<double, double>> partial(
+                thread_pool::shared().n_threads() + 1,
+                {std::numeric_limits<double>::infinity(),
+                 -std::numeric_limits<double>::infinity()});
+            const size_t n_workers =
+                for_each_range(x.size(), [&](size_t first, size_t last,
+                                             size_t w) {
+                    double lowest = partial[w].first;
+                    double highest = partial[w].second;
+                    for (size_t i = first; i < last; ++i) {
+                        lowest = x[i] < lowest ? x[i] : lowest;
+                        highest = x[i] > highest ? x[i] : highest;
+                    }
+                    partial[w] = {lowest, highest};
+                });
+            std::pair<double, double> limits = partial[0];
+            for (size_t w = 1; w < n_workers; ++w) {
+                limits.first = std::min(limits.first, partial[w].first);
+                limits.second = std::max(limits.second, partial[w].second);
+            }
+            if (limits.first > limits.second) {
+                return {NaN, NaN};
+            }
+            return limits;
+        }
+
+        // True if the edges are equally spaced, so we can find the bin
+        // of a value with arithmetic rather than a binary search
+        bool has_uniform_bins(const std::vector<double> &edges) {
+            const size_t n_bins = edges.size() - 1;
+            const double width = (edges.back() - edges.front()) / n_bins;
+            if (!(width > 0.) || !std::isfinite(width)) {
+                return false;
+            }
+            for (size_t i = 1; i < n_bins; ++i) {
+                const double expected = edges.front() + i * width;
+                if (std::abs(edges[i] - expected) > 1e-6 * width) {
+                    return false;
+                }
+            }
+            return true;
+        }
+    } // namespace
 
     histogram::histogram(class axes *parent) : axes_object(parent) {
         if (parent_->y_axis().limits_mode_auto()) {
@@ -84,15 +159,15 @@ namespace matplot {
 
     std::string histogram::data_string() {
         make_sure_data_is_preprocessed();
-        std::stringstream ss;
+        text_writer out(text_data_precision());
         if (!is_polar()) {
             for (size_t i = 0; i < values_.size(); ++i) {
                 // <box center>    <box height>    <box width>
-                ss << "    " << (bin_edges_[i] + bin_edges_[i + 1]) * 0.5 << " "
-                   << values_[i] << " "
-                   << (bin_edges_[i + 1] - bin_edges_[i]) * bar_width_ << "\n";
+                out << "    " << (bin_edges_[i] + bin_edges_[i + 1]) * 0.5
+                    << " " << values_[i] << " "
+                    << (bin_edges_[i + 1] - bin_edges_[i]) * bar_width_ << "\n";
             }
-            ss << "e\n";
+            out << "e\n";
 
         } else {
             // resolutions of the petals
@@ -106,14 +181,14 @@ namespace matplot {
                     // theta = edge_begin           rho = bin_value
                     // theta = edge_end             rho = bin_value
                     // theta = edge_end             rho = 0
-                    ss << "    " << bin_edges_[i] << "  " << 0 << "\n";
+                    out << "    " << bin_edges_[i] << "  " << 0 << "\n";
                     auto arc_between_edges = linspace(
                         bin_edges_[i], bin_edges_[i + 1], ceil(points_per_bin));
                     for (size_t j = 0; j < arc_between_edges.size(); ++j) {
-                        ss << "    " << arc_between_edges[j] << "  "
-                           << values_[i] << "\n";
+                        out << "    " << arc_between_edges[j] << "  "
+                            << values_[i] << "\n";
                     }
-                    ss << "    " << bin_edges_[i + 1] << "  " << 0 << "\n";
+                    out << "    " << bin_edges_[i + 1] << "  " << 0 << "\n";
                 }
             } else {
                 for (size_t i = 0; i < values_.size(); ++i) {
@@ -124,17 +199,17 @@ namespace matplot {
                     auto arc_between_edges = linspace(
                         bin_edges_[i], bin_edges_[i + 1], ceil(points_per_bin));
                     for (size_t j = 0; j < arc_between_edges.size(); ++j) {
-                        ss << "    " << arc_between_edges[j] << "  "
-                           << values_[i] << "\n";
+                        out << "    " << arc_between_edges[j] << "  "
+                            << values_[i] << "\n";
                     }
-                    ss << "    " << bin_edges_[i + 1] << "  "
-                       << values_[(i + 1) % values_.size()] << "\n";
+                    out << "    " << bin_edges_[i + 1] << "  "
+                        << values_[(i + 1) % values_.size()] << "\n";
                 }
             }
 
-            ss << "e\n";
+            out << "e\n";
         }
-        return ss.str();
+        return out.str();
     }
 
     double histogram::xmax() {
@@ -204,8 +279,7 @@ namespace matplot {
         if (!data_is_ok) {
             switch (binning_mode_) {
             case binning_mode_type::use_algorithm: {
-                double minx = *std::min_element(data_.begin(), data_.end());
-                double maxx = *std::max_element(data_.begin(), data_.end());
+                auto [minx, maxx] = data_limits(data_);
                 bin_edges_ =
                     histogram_edges(data_, minx, maxx, algorithm_, false);
                 break;
@@ -216,16 +290,14 @@ namespace matplot {
                 break;
             }
             case binning_mode_type::use_fixed_num_bins: {
-                double minx = *std::min_element(data_.begin(), data_.end());
-                double maxx = *std::max_element(data_.begin(), data_.end());
+                auto [minx, maxx] = data_limits(data_);
                 double xrange = maxx - minx;
                 bin_edges_ =
                     bin_picker(minx, maxx, num_bins_, xrange / num_bins_);
                 break;
             }
             case binning_mode_type::use_fixed_bin_width: {
-                double minx = *std::min_element(data_.begin(), data_.end());
-                double maxx = *std::max_element(data_.begin(), data_.end());
+                auto [minx, maxx] = data_limits(data_);
                 double xrange = maxx - minx;
                 double left_edge = bin_width_ * floor(minx / bin_width_);
                 size_t nbins = std::max(
@@ -362,8 +434,7 @@ namespace matplot {
         if (!hard_limits) {
             return bin_picker(minx, maxx, 0, binwidth);
         } else {
-            double max_x = *std::max_element(x.begin(), x.end());
-            double min_x = *std::min_element(x.begin(), x.end());
+            auto [min_x, max_x] = data_limits(x);
             return bin_pickerbl(min_x, max_x, minx, maxx, binwidth);
         }
     }
@@ -372,8 +443,8 @@ namespace matplot {
                                            double minx, double maxx,
                                            bool hard_limits) {
         size_t n = x.size();
-        double xrange = *std::max_element(x.begin(), x.end()) -
-                        *std::min_element(x.begin(), x.end());
+        auto [min_x, max_x] = data_limits(x);
+        double xrange = max_x - min_x;
         double bin_width = 1.0;
         bool iqr_not_too_small = n > 1;
         if (iqr_not_too_small) {
@@ -391,8 +462,6 @@ namespace matplot {
         if (!hard_limits) {
             return bin_picker(minx, maxx, 0, bin_width);
         } else {
-            double max_x = *std::max_element(x.begin(), x.end());
-            double min_x = *std::min_element(x.begin(), x.end());
             return bin_pickerbl(min_x, max_x, minx, maxx, bin_width);
         }
     }
@@ -407,8 +476,8 @@ namespace matplot {
             std::vector abs_x =
                 transform(x, [](double x) { return std::abs(x); });
             double xscale = *std::max_element(abs_x.begin(), abs_x.end());
-            xrange = *std::max_element(x.begin(), x.end()) -
-                     *std::min_element(x.begin(), x.end());
+            auto [min_x, max_x] = data_limits(x);
+            xrange = max_x - min_x;
             if (xrange > max_num_of_bins) {
                 binwidth = pow(10, ceil(log10(xrange / max_num_of_bins)));
             } else if (nextafter(xscale, xscale + 1) - xscale > 1.) {
@@ -516,17 +585,57 @@ namespace matplot {
     std::vector<size_t>
     histogram::histogram_count(const std::vector<double> &data,
                                const std::vector<double> &edges) {
-        std::vector<size_t> bin_counts(edges.size() - 1, 0);
-        for (const double &v : data) {
-            // find first edge that does not compare less than v
-            auto it = std::lower_bound(edges.begin(), edges.end(), v);
-            bool out_of_range = it == edges.begin() || it == edges.end();
-            if (!out_of_range) {
-                ++bin_counts[it - edges.begin() - 1];
-            } else if (it == edges.begin()) {
-                if (v == *it) {
-                    ++bin_counts[0];
+        // Bins are (edges[i], edges[i + 1]], and the first bin also
+        // includes edges[0]
+        if (edges.size() < 2) {
+            return {};
+        }
+        const size_t n_bins = edges.size() - 1;
+        const bool uniform = has_uniform_bins(edges);
+        const double first_edge = edges.front();
+        const double last_edge = edges.back();
+        const double bins_per_unit = n_bins / (last_edge - first_edge);
+
+        // Each worker counts into its own bins
+        std::vector<std::vector<size_t>> partial(
+            thread_pool::shared().n_threads() + 1);
+        const size_t n_workers = for_each_range(
+            data.size(), [&](size_t first, size_t last, size_t w) {
+                std::vector<size_t> &bin_counts = partial[w];
+                bin_counts.resize(n_bins, 0);
+                for (size_t i = first; i < last; ++i) {
+                    const double v = data[i];
+                    if (!(v >= first_edge && v <= last_edge)) {
+                        continue;
+                    }
+                    size_t bin = 0;
+                    if (uniform) {
+                        // The estimate is off by one at most, when v is
+                        // on an edge or the edges are rounded
+                        bin = std::min(static_cast<size_t>(
+                                           (v - first_edge) * bins_per_unit),
+                                       n_bins - 1);
+                        while (bin + 1 < n_bins && v > edges[bin + 1]) {
+                            ++bin;
+                        }
+                        while (bin > 0 && v <= edges[bin]) {
+                            --bin;
+                        }
+                    } else {
+                        // find first edge that does not compare less than v
+                        auto it = std::lower_bound(edges.begin(), edges.end(),
+                                                   v);
+                        bin = it == edges.begin() ? 0 : it - edges.begin() - 1;
+                    }
+                    ++bin_counts[bin];
                 }
+            });
+
+        std::vector<size_t> bin_counts = std::move(partial[0]);
+        bin_counts.resize(n_bins, 0);
+        for (size_t w = 1; w < n_workers; ++w) {
+            for (size_t i = 0; i < n_bins; ++i) {
+                bin_counts[i] += partial[w][i];
             }
         }
         return bin_counts;
@@ -828,4 +937,32 @@ namespace matplot {
         return this->num_bins();
     }
 
+    void histogram::run_draw_commands() {
+        if (!visible_) {
+            return;
+        }
+        make_sure_data_is_preprocessed();
+        maybe_update_face_color();
+        if (is_polar()) {
+            // Polar histograms need the polar projection of the axes
+            return;
+        }
+        std::vector<double> edge_x;
+        std::vector<double> edge_y;
+        for (size_t i = 0; i < values_.size(); ++i) {
+            const double center = (bin_edges_[i] + bin_edges_[i + 1]) * 0.5;
+            const double half_width =
+                (bin_edges_[i + 1] - bin_edges_[i]) * bar_width_ * 0.5;
+            const double x1 = center - half_width;
+            const double x2 = center + half_width;
+            if (!stairs_only_) {
+                parent_->draw_rectangle(x1, x2, 0., values_[i], face_color_);
+            }
+            edge_x.insert(edge_x.end(), {x1, x1, x2, x2, x1, NaN});
+            edge_y.insert(edge_y.end(),
+                          {0., values_[i], values_[i], 0., 0., NaN});
+        }
+        parent_->draw_path(edge_x, edge_y, edge_color_);
+    }
+
 } // namespace matplot
\ No newline at end of file
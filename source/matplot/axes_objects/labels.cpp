@@ -7,6 +7,7 @@
 #include <matplot/axes_objects/labels.h>
 #include <matplot/core/axes.h>
 #include <matplot/util/common.h>
+#include <matplot/util/text_writer.h>
 #include <sstream>
 
 namespace matplot {
@@ -97,26 +98,26 @@ namespace matplot {
             double yrange_increase = yrange / 34;
             font_size_factor = (xrange_increase + yrange_increase) / 2.;
         }
-        std::stringstream ss;
+        text_writer out(text_data_precision());
         const bool custom_sizes = !sizes_.empty();
         const bool custom_colors = !colors_.empty();
         for (size_t i = 0; i < labels_.size(); ++i) {
-            ss << "    " << x_[i] << "  " << y_[i] << "  \"";
+            out << "    " << x_[i] << "  " << y_[i] << "  \"";
             if (custom_sizes) {
-                ss << "{/=" << round(sizes_[i] / font_size_factor) << " ";
+                out << "{/=" << round(sizes_[i] / font_size_factor) << " ";
             }
-            ss << escape(labels_[i]);
+            out << escape(labels_[i]);
             if (custom_sizes) {
-                ss << "}";
+                out << "}";
             }
-            ss << "\"  ";
+            out << "\"  ";
             if (custom_colors) {
-                ss << colors_[i];
+                out << colors_[i];
             }
-            ss << "\n";
+            out << "\n";
         }
-        ss << "e\n";
-        return ss.str();
+        out << "e\n";
+        return out.str();
     }
 
     std::string labels::unset_variables_string() {
@@ -169,6 +170,44 @@ namespace matplot {
         return axes_object::axes_category::two_dimensional;
     }
 
+    void labels::run_draw_commands() {
+        // The rectangles behind the words are not drawn yet
+        if (!visible_ || labels_.empty()) {
+            return;
+        }
+        // Relative sizes are heights in data units, as in the
+        // rectangles of set_variables_string(), and we convert
+        // them to points. Screens have 96 pixels per inch.
+        const double points_per_data_unit =
+            height_factor / parent_->pixel_size()[1] * 72. / 96.;
+        std::pair<double, double> color_range{0., 1.};
+        if (!colors_.empty()) {
+            auto [min_it, max_it] =
+                std::minmax_element(colors_.begin(), colors_.end());
+            color_range = parent_->colormap_range(*min_it, *max_it);
+        }
+        const double horizontal_alignment =
+            alignment_ == alignment::left    ? 0.
+            : alignment_ == alignment::right ? 1.
+                                             : 0.5;
+        const size_t n = std::min({x_.size(), y_.size(), labels_.size()});
+        for (size_t i = 0; i < n; ++i) {
+            double size = font_size_;
+            if (i < sizes_.size()) {
+                size = absolute_size_ ? sizes_[i]
+                                      : round(sizes_[i]) * points_per_data_unit;
+            }
+            const color_array c =
+                i < colors_.size()
+                    ? parent_->colormap_interpolation(
+                          colors_[i], color_range.first, color_range.second)
+                    : color_;
+            parent_->draw_text(x_[i], y_[i], labels_[i],
+                               static_cast<float>(size), c,
+                               horizontal_alignment, 0.5);
+        }
+    }
+
     bool labels::rectangles() const { return rectangles_; }
 
     class labels &labels::rectangles(bool rectangles) {
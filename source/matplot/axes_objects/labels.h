@@ -48,6 +48,7 @@ namespace matplot {
         double ymax() override;
         double ymin() override;
         enum axes_object::axes_category axes_category() override;
+        void run_draw_commands() override;
 
       public /* getters and setters */:
         bool rectangles() const;
@@ -6,6 +6,7 @@
 #include <matplot/axes_objects/line.h>
 #include <matplot/core/axes.h>
 #include <matplot/util/common.h>
+#include <matplot/util/text_writer.h>
 #include <regex>
 #include <sstream>
 
@@ -88,6 +89,7 @@ namespace matplot {
     }
 
     std::string line::plot_string() {
+        merge_appended_points();
         maybe_update_line_spec();
         std::string res;
         bool first = true;
@@ -99,16 +101,15 @@ namespace matplot {
             const bool we_are_plotting_marker =
                 style != line_spec::style_to_plot::plot_line_only;
 
-            std::string str;
+            std::string str = " " + inline_data_string(style);
             if (impulse_ && style == line_spec::style_to_plot::plot_line_only) {
-                str =
-                    " '-' with impulse " + line_spec_.plot_string(style, false);
+                str += " with impulse " + line_spec_.plot_string(style, false);
             } else if (fill_ &&
                        style == line_spec::style_to_plot::plot_line_only) {
-                str = " '-' with filledcurves " +
-                      line_spec_.plot_string(style, false);
+                str += " with filledcurves " +
+                       line_spec_.plot_string(style, false);
             } else {
-                str = " '-' " + line_spec_.plot_string(style, true);
+                str += " " + line_spec_.plot_string(style, true);
             }
             if (marker_size_is_variable && we_are_plotting_marker) {
                 str = std::regex_replace(str,
@@ -152,6 +153,7 @@ namespace matplot {
     }
 
     std::string line::data_string() {
+        merge_appended_points();
         const bool markers_are_automatic = marker_indices_.empty();
         const bool has_line_and_marker =
             line_spec_.has_line() && line_spec_.has_non_custom_marker();
@@ -164,7 +166,7 @@ namespace matplot {
         size_t repetitions = 1 + needs_to_plot_twice;
         const bool x_is_manual = !x_data_.empty();
 
-        std::stringstream ss;
+        text_writer out(text_data_precision());
         for (const auto &style : styles_to_plot()) {
             if (visible_) {
                 const bool data_is_for_markers =
@@ -172,9 +174,11 @@ namespace matplot {
                     style == line_spec::style_to_plot::plot_marker_face_only;
                 const bool only_at_marker_indices =
                     !markers_are_automatic && data_is_for_markers;
-                const size_t n_points = only_at_marker_indices
-                                            ? marker_indices_.size()
-                                            : y_data_.size();
+                const size_t n_points = n_points_to_plot(style);
+                const std::vector<size_t> &decimated = decimated_indices();
+                const bool use_decimated =
+                    style == line_spec::style_to_plot::plot_line_only &&
+                    !decimated.empty();
 
                 const bool marker_size_is_variable = !marker_sizes_.empty();
                 const bool we_are_plotting_markers =
@@ -191,38 +195,178 @@ namespace matplot {
                     color_is_variable && we_are_plotting_markers;
 
                 for (size_t i = 0; i < n_points; ++i) {
-                    size_t index =
-                        only_at_marker_indices ? marker_indices_[i] : i;
+                    size_t index = only_at_marker_indices ? marker_indices_[i]
+                                   : use_decimated        ? decimated[i]
+                                                          : i;
 
                     double x_value = x_is_manual ? x_data_[index] : index + 1;
-                    if (!std::isfinite(x_value) || !std::isfinite(y_data_[i])) {
-                        ss << "    \n";
+                    if (!std::isfinite(x_value) ||
+                        !std::isfinite(y_data_[index])) {
+                        out << "    \n";
                         continue;
                     }
-                    ss << "    " << x_value;
+                    out << "    " << x_value;
 
-                    ss << "  " << y_data_[index];
+                    out << "  " << y_data_[index];
 
                     if (is_3d()) {
-                        ss << "  " << z_data_[index];
+                        out << "  " << z_data_[index];
                     }
 
                     if (include_marker_size) {
-                        ss << "  "
-                           << marker_sizes_[index] / marker_size_denominator;
+                        out << "  "
+                            << marker_sizes_[index] / marker_size_denominator;
                     }
 
                     if (include_marker_color) {
-                        ss << "  " << marker_colors_[index];
+                        out << "  " << marker_colors_[index];
                     }
 
-                    ss << "  \n";
+                    out << "  \n";
                 }
             }
-            ss << "    "
-               << "e\n";
+            out << "    "
+                << "e\n";
         }
-        return ss.str();
+        return out.str();
+    }
+
+    bool line::supports_binary_data() {
+        merge_appended_points();
+        return visible_ && !y_data_.empty();
+    }
+
+    bool line::data_is_self_contained() { return true; }
+
+    std::string line::data_cache_key() {
+        merge_appended_points();
+        std::array<double, 2> x_range{};
+        size_t n_columns = 0;
+        if (!decimation_grid(x_range, n_columns)) {
+            return "";
+        }
+        return num2str(x_range[0], "%.17g") + " " +
+               num2str(x_range[1], "%.17g") + " " + num2str(n_columns) +
+               (parent_->x_axis().scale() == axis::axis_scale::log ? " log"
+                                                                    : "");
+    }
+
+    std::string line::binary_data_string() {
+        merge_appended_points();
+        const bool single_precision = binary_data_single_precision();
+        const bool markers_are_automatic = marker_indices_.empty();
+        const bool x_is_manual = !x_data_.empty();
+        const bool marker_size_is_variable = !marker_sizes_.empty();
+        const bool color_is_variable = !marker_colors_.empty();
+        const size_t value_size =
+            single_precision ? sizeof(float) : sizeof(double);
+
+        std::string data;
+        for (const auto &style : styles_to_plot()) {
+            const bool data_is_for_markers =
+                style == line_spec::style_to_plot::plot_marker_only ||
+                style == line_spec::style_to_plot::plot_marker_face_only;
+            const bool only_at_marker_indices =
+                !markers_are_automatic && data_is_for_markers;
+            const size_t n_points = n_points_to_plot(style);
+            const std::vector<size_t> &decimated = decimated_indices();
+            const bool use_decimated =
+                style == line_spec::style_to_plot::plot_line_only &&
+                !decimated.empty();
+            data.reserve(data.size() +
+                         n_points * n_columns_to_plot(style) * value_size);
+
+            const bool we_are_plotting_markers =
+                style != line_spec::style_to_plot::plot_line_only;
+            const bool include_marker_size =
+                marker_size_is_variable && we_are_plotting_markers;
+            const double marker_size_denominator =
+                style == line_spec::style_to_plot::plot_marker_face_only ? 10
+                                                                         : 6;
+            const bool include_marker_color =
+                color_is_variable && we_are_plotting_markers;
+
+            // Non-finite values are sent as they are. Gnuplot treats
+            // them as undefined points and breaks the line there, like
+            // the empty lines we send in text mode.
+            for (size_t i = 0; i < n_points; ++i) {
+                size_t index = only_at_marker_indices ? marker_indices_[i]
+                               : use_decimated        ? decimated[i]
+                                                      : i;
+                double x_value = x_is_manual ? x_data_[index] : index + 1;
+                append_binary_value(data, x_value, single_precision);
+                append_binary_value(data, y_data_[index], single_precision);
+                if (is_3d()) {
+                    append_binary_value(data, z_data_[index],
+                                        single_precision);
+                }
+                if (include_marker_size) {
+                    append_binary_value(data,
+                                        marker_sizes_[index] /
+                                            marker_size_denominator,
+                                        single_precision);
+                }
+                if (include_marker_color) {
+                    append_binary_value(data, marker_colors_[index],
+                                        single_precision);
+                }
+            }
+        }
+        return data;
+    }
+
+    std::string line::inline_data_string(line_spec::style_to_plot style) {
+        if (!use_binary_data()) {
+            return "'-'";
+        }
+        if (!use_binary_data_files()) {
+            return "'-'" + binary_format_string(n_points_to_plot(style),
+                                                n_columns_to_plot(style));
+        }
+        // The blocks for each style are stored one after the other
+        // in the same file, so we skip the blocks of previous styles
+        const size_t value_size =
+            binary_data_single_precision() ? sizeof(float) : sizeof(double);
+        size_t skip_bytes = 0;
+        for (const auto &previous_style : styles_to_plot()) {
+            if (previous_style == style) {
+                break;
+            }
+            skip_bytes += n_points_to_plot(previous_style) *
+                          n_columns_to_plot(previous_style) * value_size;
+        }
+        return "\"" + escape(binary_data_file()) + "\"" +
+               binary_format_string(n_points_to_plot(style),
+                                    n_columns_to_plot(style), skip_bytes);
+    }
+
+    size_t line::n_points_to_plot(line_spec::style_to_plot style) {
+        if (style == line_spec::style_to_plot::plot_line_only) {
+            const std::vector<size_t> &decimated = decimated_indices();
+            if (!decimated.empty()) {
+                return decimated.size();
+            }
+        }
+        const bool data_is_for_markers =
+            style == line_spec::style_to_plot::plot_marker_only ||
+            style == line_spec::style_to_plot::plot_marker_face_only;
+        const bool only_at_marker_indices =
+            !marker_indices_.empty() && data_is_for_markers;
+        return only_at_marker_indices ? marker_indices_.size()
+                                      : y_data_.size();
+    }
+
+    size_t line::n_columns_to_plot(line_spec::style_to_plot style) {
+        const bool we_are_plotting_markers =
+            style != line_spec::style_to_plot::plot_line_only;
+        size_t n_columns = is_3d() ? 3 : 2;
+        if (!marker_sizes_.empty() && we_are_plotting_markers) {
+            ++n_columns;
+        }
+        if (!marker_colors_.empty() && we_are_plotting_markers) {
+            ++n_columns;
+        }
+        return n_columns;
     }
 
     void line::maybe_update_line_spec() {
@@ -239,6 +383,7 @@ namespace matplot {
     }
 
     double line::xmax() {
+        merge_appended_points();
         if (!is_polar()) {
             if (x_data_.empty()) {
                 if (!y_data_.empty()) {
@@ -247,17 +392,16 @@ namespace matplot {
                     return axes_object::xmax();
                 }
             }
-            return *std::max_element(x_data_.begin(), x_data_.end());
+            return bounds(x_data_, x_bounds_).max;
         } else {
             // y = rho
             if (parent_->r_axis().limits_mode_manual()) {
                 return +(parent_->r_axis().limits()[1] -
                          parent_->r_axis().limits()[0]);
             }
-            auto [min_rho, max_rho] =
-                std::minmax_element(y_data_.begin(), y_data_.end());
-            if (max_rho != y_data_.end() && min_rho != y_data_.end()) {
-                return +round_polar_max(std::abs(*max_rho));
+            if (!y_data_.empty()) {
+                const double max_rho = bounds(y_data_, y_bounds_).max;
+                return +round_polar_max(std::abs(max_rho));
             } else {
                 return 1;
             }
@@ -265,6 +409,7 @@ namespace matplot {
     }
 
     double line::xmin() {
+        merge_appended_points();
         if (!is_polar()) {
             if (x_data_.empty()) {
                 if (!y_data_.empty()) {
@@ -273,17 +418,16 @@ namespace matplot {
                     return axes_object::xmin();
                 }
             }
-            return *std::min_element(x_data_.begin(), x_data_.end());
+            return bounds(x_data_, x_bounds_).min;
         } else {
             // y = rho
             if (parent_->r_axis().limits_mode_manual()) {
                 return -(parent_->r_axis().limits()[1] -
                          parent_->r_axis().limits()[0]);
             }
-            auto [min_rho, max_rho] =
-                std::minmax_element(y_data_.begin(), y_data_.end());
-            if (max_rho != y_data_.end() && min_rho != y_data_.end()) {
-                return -round_polar_max(std::abs(*max_rho));
+            if (!y_data_.empty()) {
+                const double max_rho = bounds(y_data_, y_bounds_).max;
+                return -round_polar_max(std::abs(max_rho));
             } else {
                 return -1;
             }
@@ -291,21 +435,21 @@ namespace matplot {
     }
 
     double line::ymax() {
+        merge_appended_points();
         if (!is_polar()) {
             if (y_data_.empty()) {
                 return axes_object::ymax();
             }
-            return *std::max_element(y_data_.begin(), y_data_.end());
+            return bounds(y_data_, y_bounds_).max;
         } else {
             // y = rho
             if (parent_->r_axis().limits_mode_manual()) {
                 return +(parent_->r_axis().limits()[1] -
                          parent_->r_axis().limits()[0]);
             }
-            auto [min_rho, max_rho] =
-                std::minmax_element(y_data_.begin(), y_data_.end());
-            if (max_rho != y_data_.end() && min_rho != y_data_.end()) {
-                return +round_polar_max(std::abs(*max_rho));
+            if (!y_data_.empty()) {
+                const double max_rho = bounds(y_data_, y_bounds_).max;
+                return +round_polar_max(std::abs(max_rho));
             } else {
                 return 1;
             }
@@ -313,21 +457,21 @@ namespace matplot {
     }
 
     double line::ymin() {
+        merge_appended_points();
         if (!is_polar()) {
             if (y_data_.empty()) {
                 return axes_object::ymin();
             }
-            return *std::min_element(y_data_.begin(), y_data_.end());
+            return bounds(y_data_, y_bounds_).min;
         } else {
             // y = rho
             if (parent_->r_axis().limits_mode_manual()) {
                 return -(parent_->r_axis().limits()[1] -
                          parent_->r_axis().limits()[0]);
             }
-            auto [min_rho, max_rho] =
-                std::minmax_element(y_data_.begin(), y_data_.end());
-            if (max_rho != y_data_.end() && min_rho != y_data_.end()) {
-                return -round_polar_max(std::abs(*max_rho));
+            if (!y_data_.empty()) {
+                const double max_rho = bounds(y_data_, y_bounds_).max;
+                return -round_polar_max(std::abs(max_rho));
             } else {
                 return -1;
             }
@@ -335,6 +479,7 @@ namespace matplot {
     }
 
     enum axes_object::axes_category line::axes_category() {
+        merge_appended_points();
         if (z_data_.empty()) {
             if (!polar_) {
                 return axes_object::axes_category::two_dimensional;
@@ -364,36 +509,56 @@ namespace matplot {
         return *this;
     }
 
-    const std::vector<double> &line::y_data() const { return y_data_; }
+    const std::vector<double> &line::y_data() const {
+        // Reading the data is logically const, even if it merges the
+        // points we appended
+        const_cast<line *>(this)->merge_appended_points();
+        return y_data_;
+    }
 
     class line &line::y_data(const std::vector<double> &y_data) {
+        merge_appended_points();
         y_data_ = y_data;
         touch();
         return *this;
     }
 
-    const std::vector<double> &line::x_data() const { return x_data_; }
+    const std::vector<double> &line::x_data() const {
+        // Reading the data is logically const, even if it merges the
+        // points we appended
+        const_cast<line *>(this)->merge_appended_points();
+        return x_data_;
+    }
 
     class line &line::x_data(const std::vector<double> &x_data) {
+        merge_appended_points();
         x_data_ = x_data;
         touch();
         return *this;
     }
 
-    const std::vector<double> &line::z_data() const { return z_data_; }
+    const std::vector<double> &line::z_data() const {
+        // Reading the data is logically const, even if it merges the
+        // points we appended
+        const_cast<line *>(this)->merge_appended_points();
+        return z_data_;
+    }
 
     class line &line::z_data(const std::vector<double> &z_data) {
+        merge_appended_points();
         z_data_ = z_data;
         touch();
         return *this;
     }
 
     const std::vector<size_t> &line::marker_indices() const {
+        const_cast<line *>(this)->merge_appended_points();
         return marker_indices_;
     }
 
     class line &
     line::marker_indices(const std::vector<size_t> &marker_indices) {
+        merge_appended_points();
         marker_indices_ = marker_indices;
         touch();
         return *this;
@@ -407,6 +572,337 @@ namespace matplot {
         return *this;
     }
 
+    size_t line::capacity() const { return capacity_; }
+
+    class line &line::capacity(size_t capacity) {
+        merge_appended_points();
+        capacity_ = capacity;
+        if (capacity_ != 0) {
+            // keep the last points and make room for the window so that
+            // appending never reallocates
+            const size_t n_discarded =
+                y_data_.size() > capacity_ ? y_data_.size() - capacity_ : 0;
+            for (auto data : {&x_data_, &y_data_, &z_data_}) {
+                if (data->size() > capacity_) {
+                    data->erase(data->begin(),
+                                data->begin() + (data->size() - capacity_));
+                }
+                data->reserve(capacity_);
+            }
+            discard_marker_indices(n_discarded);
+        }
+        touch();
+        return *this;
+    }
+
+    class line &line::append(double x, double y) {
+        return append_points(&x, &y, nullptr, 1);
+    }
+
+    class line &line::append(double x, double y, double z) {
+        return append_points(&x, &y, &z, 1);
+    }
+
+    class line &line::append(double y) {
+        if (x_data_.empty()) {
+            return append_points(nullptr, &y, nullptr, 1);
+        }
+        const double x =
+            (appended_x_.empty() ? x_data_.back() : appended_x_.back()) + 1.;
+        return append_points(&x, &y, nullptr, 1);
+    }
+
+    class line &line::append(const std::vector<double> &x,
+                             const std::vector<double> &y) {
+        if (x.size() != y.size()) {
+            throw std::invalid_argument(
+                "line::append: x and y should have the same size");
+        }
+        return append_points(x.data(), y.data(), nullptr, y.size());
+    }
+
+    class line &line::append(const std::vector<double> &x,
+                             const std::vector<double> &y,
+                             const std::vector<double> &z) {
+        if (x.size() != y.size() || x.size() != z.size()) {
+            throw std::invalid_argument(
+                "line::append: x, y and z should have the same size");
+        }
+        return append_points(x.data(), y.data(), z.data(), y.size());
+    }
+
+    class line &line::append(const std::vector<double> &y) {
+        if (x_data_.empty()) {
+            return append_points(nullptr, y.data(), nullptr, y.size());
+        }
+        const double last_x =
+            appended_x_.empty() ? x_data_.back() : appended_x_.back();
+        std::vector<double> x(y.size());
+        for (size_t i = 0; i < x.size(); ++i) {
+            x[i] = last_x + static_cast<double>(i + 1);
+        }
+        return append_points(x.data(), y.data(), nullptr, y.size());
+    }
+
+    class line &line::append_points(const double *x, const double *y,
+                                    const double *z, size_t n) {
+        if (!marker_sizes_.empty() || !marker_colors_.empty()) {
+            throw std::invalid_argument(
+                "line::append: this line has a marker size or color for "
+                "each point");
+        }
+        if (z == nullptr && !z_data_.empty()) {
+            throw std::invalid_argument("line::append: this line has z data");
+        }
+        if (z != nullptr && !y_data_.empty() &&
+            (z_data_.size() != y_data_.size() ||
+             x_data_.size() != y_data_.size())) {
+            throw std::invalid_argument(
+                "line::append: the x, y and z data of this line do not match");
+        }
+        if (x != nullptr && x_data_.empty() && !y_data_.empty()) {
+            // the points we had used their indices as x values
+            merge_appended_points();
+            x_data_.reserve(std::max(capacity_, y_data_.size() + n));
+            for (size_t i = 0; i < y_data_.size(); ++i) {
+                x_data_.emplace_back(static_cast<double>(i + 1));
+            }
+        }
+        const bool window_is_full =
+            capacity_ != 0 && !y_data_.empty() &&
+            y_data_.size() + appended_y_.size() + n > capacity_;
+        if (window_is_full) {
+            if (x != nullptr) {
+                append_to_window(appended_x_, x, n);
+            }
+            append_to_window(appended_y_, y, n);
+            if (z != nullptr) {
+                append_to_window(appended_z_, z, n);
+            }
+            touch_after_append();
+            return *this;
+        }
+        merge_appended_points();
+        if (x != nullptr) {
+            append_to_data(x_data_, x_bounds_, x, n);
+        }
+        discard_marker_indices(append_to_data(y_data_, y_bounds_, y, n));
+        if (z != nullptr) {
+            append_to_data(z_data_, z_bounds_, z, n);
+        }
+        touch_after_append();
+        return *this;
+    }
+
+    size_t line::append_to_data(std::vector<double> &data,
+                                data_bounds &cache, const double *values,
+                                size_t n) {
+        bool update_bounds = bounds_are_up_to_date(data, cache);
+        const double *first_new = values;
+        const double *last_new = values + n;
+        size_t n_discarded = 0;
+        if (capacity_ != 0 && n >= capacity_) {
+            first_new = last_new - capacity_;
+            n_discarded = data.size() + n - capacity_;
+            data.clear();
+        } else if (capacity_ != 0 && data.size() + n > capacity_) {
+            // Discard the oldest points. This moves the points we keep
+            // within the storage we reserved, so nothing is allocated.
+            n_discarded = data.size() + n - capacity_;
+            if (update_bounds && cache.sorted) {
+                // The values we keep are still sorted
+                cache.min = data[n_discarded];
+                cache.max = data.back();
+            } else {
+                for (size_t i = 0; i < n_discarded && update_bounds; ++i) {
+                    // Without one of the extreme values, we need to scan
+                    // the data again to find the new bounds
+                    update_bounds =
+                        cache.min < data[i] && data[i] < cache.max;
+                }
+            }
+            data.erase(data.begin(), data.begin() + n_discarded);
+        }
+        if (data.empty() && first_new != last_new) {
+            cache.min = *first_new;
+            cache.max = *first_new;
+            cache.sorted = !std::isnan(*first_new);
+            update_bounds = true;
+        }
+        if (update_bounds) {
+            const double *previous = data.empty() ? nullptr : &data.back();
+            for (const double *it = first_new; it != last_new; ++it) {
+                // Same comparisons as std::min_element and
+                // std::max_element
+                if (*it < cache.min) {
+                    cache.min = *it;
+                }
+                if (cache.max < *it) {
+                    cache.max = *it;
+                }
+                if (previous != nullptr && !(*previous <= *it)) {
+                    cache.sorted = false;
+                }
+                previous = it;
+            }
+        }
+        data.insert(data.end(), first_new, last_new);
+        cache.revision = update_bounds ? revision() + 1 : 0;
+        cache.data = data.data();
+        cache.size = data.size();
+        return n_discarded;
+    }
+
+    void line::append_to_window(std::vector<double> &window,
+                                const double *values, size_t n) {
+        window.insert(window.end(), values, values + n);
+        // Only the last capacity_ points can reach the data, so we
+        // compact the buffer once every capacity_ points
+        if (window.size() >= 2 * capacity_) {
+            window.erase(window.begin(), window.end() - capacity_);
+        }
+    }
+
+    void line::touch_after_append() {
+        const size_t appended_revision = revision() + 1;
+        touch();
+        for (data_bounds *cache : {&x_bounds_, &y_bounds_, &z_bounds_}) {
+            if (cache->revision == appended_revision) {
+                cache->revision = revision() + 1;
+            }
+        }
+    }
+
+    void line::merge_appended_points() {
+        if (appended_y_.empty()) {
+            return;
+        }
+        // We touched the line when we appended these points, so the
+        // bounds append_to_data updates are already up to date
+        if (!appended_x_.empty()) {
+            append_to_data(x_data_, x_bounds_, appended_x_.data(),
+                           appended_x_.size());
+        }
+        discard_marker_indices(append_to_data(
+            y_data_, y_bounds_, appended_y_.data(), appended_y_.size()));
+        if (!appended_z_.empty()) {
+            append_to_data(z_data_, z_bounds_, appended_z_.data(),
+                           appended_z_.size());
+        }
+        appended_x_.clear();
+        appended_y_.clear();
+        appended_z_.clear();
+    }
+
+    void line::discard_marker_indices(size_t n_discarded) {
+        if (n_discarded == 0 || marker_indices_.empty()) {
+            return;
+        }
+        // Markers of discarded points go away and the others follow
+        // their points to the front of the window
+        auto it = std::remove_if(
+            marker_indices_.begin(), marker_indices_.end(),
+            [&](size_t index) { return index < n_discarded; });
+        marker_indices_.erase(it, marker_indices_.end());
+        for (size_t &index : marker_indices_) {
+            index -= n_discarded;
+        }
+    }
+
+    const line::data_bounds &line::bounds(const std::vector<double> &data,
+                                          data_bounds &cache) {
+        if (!bounds_are_up_to_date(data, cache)) {
+            cache.min = *std::min_element(data.begin(), data.end());
+            cache.max = *std::max_element(data.begin(), data.end());
+            // NaN is not sorted with anything
+            cache.sorted = !std::isnan(data.front()) &&
+                           std::adjacent_find(data.begin(), data.end(),
+                                              [](double a, double b) {
+                                                  return !(a <= b);
+                                              }) == data.end();
+            cache.revision = revision() + 1;
+            cache.data = data.data();
+            cache.size = data.size();
+        }
+        return cache;
+    }
+
+    bool line::bounds_are_up_to_date(const std::vector<double> &data,
+                                     const data_bounds &cache) const {
+        // Derived classes might replace the data without touching
+        // the line, so we also check it is the same data
+        return cache.revision == revision() + 1 && cache.data == data.data() &&
+               cache.size == data.size();
+    }
+
+    bool line::decimation() const { return decimation_; }
+
+    class line &line::decimation(bool decimation) {
+        decimation_ = decimation;
+        touch();
+        return *this;
+    }
+
+    bool line::decimation_grid(std::array<double, 2> &x_range,
+                               size_t &n_columns) {
+        if (!decimation_ || is_3d() || is_polar() || polar_) {
+            return false;
+        }
+        const auto &x_axis = parent_->x_axis();
+        if (x_axis.limits_mode_manual()) {
+            x_range = x_axis.limits();
+        } else if (x_data_.empty()) {
+            x_range = {1., static_cast<double>(y_data_.size())};
+        } else {
+            // The bounds are cached, so this does not scan the data on
+            // every call
+            const data_bounds &x_bounds = bounds(x_data_, x_bounds_);
+            x_range = {x_bounds.min, x_bounds.max};
+            if (!std::isfinite(x_range[0]) || !std::isfinite(x_range[1])) {
+                // Only the finite values are on the grid
+                x_range = {std::numeric_limits<double>::infinity(),
+                           -std::numeric_limits<double>::infinity()};
+                for (const double x : x_data_) {
+                    if (std::isfinite(x)) {
+                        x_range[0] = std::min(x_range[0], x);
+                        x_range[1] = std::max(x_range[1], x);
+                    }
+                }
+            }
+        }
+        // One column per pixel of the axes
+        const double axes_width =
+            parent_->width() * parent_->parent()->width();
+        n_columns = static_cast<size_t>(std::max(1., std::ceil(axes_width)));
+        // Each column keeps up to 4 points
+        return y_data_.size() > 4 * n_columns;
+    }
+
+    std::vector<size_t> line::decimate(const std::vector<double> &y) {
+        std::array<double, 2> x_range{};
+        size_t n_columns = 0;
+        if (!decimation_grid(x_range, n_columns)) {
+            return {};
+        }
+        return m4_indices(x_data_, y, x_range[0], x_range[1], n_columns,
+                          parent_->x_axis().scale() == axis::axis_scale::log);
+    }
+
+    const std::vector<size_t> &line::decimated_indices() {
+        std::string key = data_cache_key();
+        // y_data_ might be temporarily swapped with other data
+        // (e.g. stacked areas), so the cache also depends on it
+        if (decimated_indices_revision_ != revision() + 1 ||
+            decimated_indices_key_ != key ||
+            decimated_indices_data_ != y_data_.data()) {
+            decimated_indices_ = decimate(y_data_);
+            decimated_indices_revision_ = revision() + 1;
+            decimated_indices_key_ = std::move(key);
+            decimated_indices_data_ = y_data_.data();
+        }
+        return decimated_indices_;
+    }
+
     float line::line_width() const { return line_spec().line_width(); }
 
     class line &line::line_width(float line_width) {
@@ -430,6 +926,7 @@ namespace matplot {
     }
 
     class line &line::marker_size(const std::vector<float> &size_vector) {
+        merge_appended_points();
         marker_sizes_ = size_vector;
         touch();
         return *this;
@@ -506,10 +1003,96 @@ namespace matplot {
         return *this;
     }
 
+    matplot::line_spec line::legend_line_spec() {
+        maybe_update_line_spec();
+        return line_spec_;
+    }
+
     void line::run_draw_commands() {
-        // ask axes to draw the line
+        merge_appended_points();
+        if (!visible_ || y_data_.empty()) {
+            return;
+        }
         maybe_update_line_spec();
-        parent_->draw_path(x_data_,y_data_,line_spec_.color());
+        const bool x_is_manual = !x_data_.empty();
+        auto x_value = [&](size_t index) {
+            return x_is_manual ? x_data_[index] : index + 1.;
+        };
+
+        // ask axes to draw the line
+        if (line_spec_.has_line()) {
+            const std::vector<size_t> &decimated = decimated_indices();
+            if (decimated.empty() && x_is_manual) {
+                parent_->draw_path(x_data_, y_data_, line_spec_.color());
+            } else {
+                const size_t n =
+                    decimated.empty() ? y_data_.size() : decimated.size();
+                std::vector<double> x(n);
+                std::vector<double> y(n);
+                for (size_t i = 0; i < n; ++i) {
+                    const size_t index = decimated.empty() ? i : decimated[i];
+                    x[i] = x_value(index);
+                    y[i] = y_data_[index];
+                }
+                parent_->draw_path(x, y, line_spec_.color());
+            }
+        }
+
+        // ask axes to draw the markers
+        if (!line_spec_.has_non_custom_marker()) {
+            return;
+        }
+        const size_t n_markers = marker_indices_.empty()
+                                     ? y_data_.size()
+                                     : marker_indices_.size();
+        auto marker_index = [&](size_t i) {
+            return marker_indices_.empty() ? i : marker_indices_[i];
+        };
+        if (marker_sizes_.empty() && marker_colors_.empty()) {
+            std::vector<double> x(n_markers);
+            std::vector<double> y(n_markers);
+            for (size_t i = 0; i < n_markers; ++i) {
+                x[i] = x_value(marker_index(i));
+                y[i] = y_data_[marker_index(i)];
+            }
+            parent_->draw_markers(x, y, line_spec_);
+            return;
+        }
+
+        // Markers with variable size or color are instances of
+        // the same marker, drawn at once
+        std::pair<double, double> color_range{0., 1.};
+        if (!marker_colors_.empty()) {
+            auto [min_it, max_it] = std::minmax_element(marker_colors_.begin(),
+                                                        marker_colors_.end());
+            color_range = parent_->colormap_range(*min_it, *max_it);
+        }
+        std::vector<double> x(n_markers);
+        std::vector<double> y(n_markers);
+        std::vector<double> sizes(marker_sizes_.empty() ? 1 : n_markers,
+                                  line_spec_.marker_size());
+        std::vector<color_array> edge_colors(
+            marker_colors_.empty() ? 1 : n_markers, line_spec_.marker_color());
+        std::vector<color_array> face_colors(
+            marker_colors_.empty() ? 1 : n_markers,
+            line_spec_.marker_face_color());
+        for (size_t i = 0; i < n_markers; ++i) {
+            const size_t index = marker_index(i);
+            x[i] = x_value(index);
+            y[i] = y_data_[index];
+            if (index < marker_sizes_.size()) {
+                sizes[i] = marker_sizes_[index];
+            }
+            if (index < marker_colors_.size()) {
+                edge_colors[i] = parent_->colormap_interpolation(
+                    marker_colors_[index], color_range.first,
+                    color_range.second);
+                face_colors[i] = edge_colors[i];
+            }
+        }
+        parent_->draw_markers(x, y, line_spec_.marker_style(), sizes,
+                              edge_colors, line_spec_.marker_face(),
+                              face_colors);
     }
 
 } // namespace matplot
\ No newline at end of file
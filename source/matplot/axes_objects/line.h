@@ -35,10 +35,15 @@ namespace matplot {
 
       public /* mandatory virtual functions */:
         void run_draw_commands() override;
+        matplot::line_spec legend_line_spec() override;
 
         std::string plot_string() override;
         std::string legend_string(const std::string &title) override;
         std::string data_string() override;
+        bool supports_binary_data() override;
+        std::string binary_data_string() override;
+        bool data_is_self_contained() override;
+        std::string data_cache_key() override;
         double xmax() override;
         double xmin() override;
         double ymax() override;
@@ -83,6 +88,45 @@ namespace matplot {
         bool visible() const;
         class line &visible(bool visible);
 
+        /// Maximum number of points we keep when appending points
+        /// The oldest points are discarded as we append new ones,
+        /// so the line becomes a rolling window of the last points.
+        /// Zero means there is no limit.
+        size_t capacity() const;
+        class line &capacity(size_t capacity);
+
+        /// True if the line is decimated before we send it
+        /// For each pixel column the line crosses, we only send the
+        /// first, last, minimum, and maximum points (M4 decimation).
+        /// This draws the same line with a number of points proportional
+        /// to the axes width rather than to the data size. Markers are
+        /// not decimated, and neither are 3d and polar lines.
+        bool decimation() const;
+        class line &decimation(bool decimation);
+
+      public /* streaming data */:
+        /// Append a point to the line
+        /// The existing points are not copied, so this is the
+        /// efficient way to update lines that grow over time.
+        /// Lines with a marker size or color for each point cannot
+        /// append points, and marker indices follow the points they
+        /// refer to as the window discards old points.
+        class line &append(double x, double y);
+        class line &append(double x, double y, double z);
+
+        /// Append a point with no explicit x value
+        /// If the line has no x data, x is the point index.
+        /// Otherwise, x is the last x value plus one.
+        class line &append(double y);
+
+        /// Append many points at once
+        class line &append(const std::vector<double> &x,
+                           const std::vector<double> &y);
+        class line &append(const std::vector<double> &x,
+                           const std::vector<double> &y,
+                           const std::vector<double> &z);
+        class line &append(const std::vector<double> &y);
+
       public /* getters and setters bypassing the line_spec */:
         float line_width() const;
         class line &line_width(float line_width);
@@ -131,6 +175,7 @@ namespace matplot {
         }
 
         inline class line &marker_colors(const std::vector<double> &cs) {
+            merge_appended_points();
             marker_colors_ = cs;
             touch();
             return *this;
@@ -161,6 +206,80 @@ namespace matplot {
         virtual std::vector<line_spec::style_to_plot> styles_to_plot();
         void maybe_update_line_spec();
 
+        /// Data source for a style in the plot command
+        /// This is '-' or the binary data file and, in binary mode,
+        /// the format of its records
+        std::string inline_data_string(line_spec::style_to_plot style);
+
+        /// Number of points and columns we send for a style
+        size_t n_points_to_plot(line_spec::style_to_plot style);
+        size_t n_columns_to_plot(line_spec::style_to_plot style);
+
+        /// Minimum and maximum of a data vector
+        struct data_bounds {
+            double min{0.};
+            double max{0.};
+            /// Revision + 1 of the line when we found these bounds,
+            /// so zero means we have no bounds
+            size_t revision{0};
+            /// Data we found the bounds of
+            const double *data{nullptr};
+            size_t size{0};
+            /// The data is non-decreasing, such as x values in a
+            /// rolling window, so the bounds are its first and last
+            /// values
+            bool sorted{false};
+        };
+
+        /// Bounds of a non-empty data vector
+        /// We only scan the data again if the line changed
+        const data_bounds &bounds(const std::vector<double> &data,
+                                  data_bounds &cache);
+
+        /// True if the cached bounds still describe the data
+        bool bounds_are_up_to_date(const std::vector<double> &data,
+                                   const data_bounds &cache) const;
+
+        /// Append n points to the line
+        /// x and z are null if the line has no x or z data.
+        class line &append_points(const double *x, const double *y,
+                                  const double *z, size_t n);
+
+        /// Append values to a data vector, discarding the oldest values
+        /// if there are more than capacity_ values
+        /// The bounds of the data are updated with the new values,
+        /// unless we discard one of the extreme values of unsorted data.
+        /// \return Number of values we discarded
+        size_t append_to_data(std::vector<double> &data, data_bounds &cache,
+                              const double *values, size_t n);
+
+        /// Append values to the points waiting for a full window
+        void append_to_window(std::vector<double> &window,
+                              const double *values, size_t n);
+
+        /// Touch the line after appending data
+        /// The bounds append_to_data updated remain valid
+        void touch_after_append();
+
+        /// Move the points appended to a full window to the data
+        /// Functions that read the data call this first.
+        void merge_appended_points();
+
+        /// Shift the marker indices after discarding the oldest points
+        void discard_marker_indices(size_t n_discarded);
+
+        /// X range and number of pixel columns of the decimation grid
+        /// \return False if we should not decimate this line
+        bool decimation_grid(std::array<double, 2> &x_range,
+                             size_t &n_columns);
+
+        /// Indices of the points that represent y on the decimation grid
+        /// This is empty if we should send all points
+        std::vector<size_t> decimate(const std::vector<double> &y);
+
+        /// decimate(y_data_), reused while nothing it depends on changes
+        const std::vector<size_t> &decimated_indices();
+
       protected:
         /// Line style
         matplot::line_spec line_spec_;
@@ -189,6 +308,29 @@ namespace matplot {
 
         /// True if visible
         bool visible_{true};
+
+        /// Maximum number of points when appending (0 for no limit)
+        size_t capacity_{0};
+
+        /// Points appended to a full window and not merged yet
+        /// Discarding the oldest points moves the whole window, so
+        /// we only do it when the data is read. These buffers keep
+        /// the last capacity_ points once they reach twice that.
+        std::vector<double> appended_x_;
+        std::vector<double> appended_y_;
+        std::vector<double> appended_z_;
+
+        /// Bounds of the data, for the automatic axes limits
+        data_bounds x_bounds_;
+        data_bounds y_bounds_;
+        data_bounds z_bounds_;
+
+        /// Decimate the line for the axes width
+        bool decimation_{false};
+        std::vector<size_t> decimated_indices_;
+        size_t decimated_indices_revision_{0};
+        std::string decimated_indices_key_;
+        const double *decimated_indices_data_{nullptr};
     };
 } // namespace matplot
 
@@ -2,10 +2,13 @@
 // Created by Alan Freitas on 17/07/20.
 //
 
+#include <algorithm>
 #include <cmath>
+#include <limits>
 #include <matplot/axes_objects/matrix.h>
 #include <matplot/core/axes.h>
 #include <matplot/util/common.h>
+#include <matplot/util/text_writer.h>
 #include <sstream>
 
 namespace matplot {
@@ -116,82 +119,102 @@ namespace matplot {
         }
     }
 
-    std::string matrix::matrix_data_string() {
-        // single matrix
-        auto &matrix_ = matrices_[0];
-
-        // calculate min/max row/cols if normalizing
-        std::vector<double> value_max;
-        std::vector<double> value_min;
+    void matrix::normalization_limits(const vector_2d &m,
+                                      std::vector<double> &value_min,
+                                      std::vector<double> &value_max) {
         if (normalization_ == color_normalization::columns) {
-            value_max.resize(matrix_[0].size());
-            value_min.resize(matrix_[0].size());
-            for (size_t i = 0; i < matrix_[0].size(); ++i) {
-                value_max[i] = matrix_[0][i];
-                value_min[i] = matrix_[0][i];
-                for (size_t j = 0; j < matrix_.size(); ++j) {
-                    if (matrix_[j][i] > value_max[i]) {
-                        value_max[i] = matrix_[j][i];
+            value_max.resize(m[0].size());
+            value_min.resize(m[0].size());
+            for (size_t i = 0; i < m[0].size(); ++i) {
+                value_max[i] = m[0][i];
+                value_min[i] = m[0][i];
+                for (size_t j = 0; j < m.size(); ++j) {
+                    if (m[j][i] > value_max[i]) {
+                        value_max[i] = m[j][i];
                     }
-                    if (matrix_[j][i] < value_min[i]) {
-                        value_min[i] = matrix_[j][i];
+                    if (m[j][i] < value_min[i]) {
+                        value_min[i] = m[j][i];
                     }
                 }
             }
         } else if (normalization_ == color_normalization::rows) {
-            value_max.resize(matrix_.size());
-            value_min.resize(matrix_.size());
-            for (size_t i = 0; i < matrix_.size(); ++i) {
-                value_max[i] = matrix_[i][0];
-                value_min[i] = matrix_[i][0];
-                for (size_t j = 0; j < matrix_[0].size(); ++j) {
-                    if (matrix_[i][j] > value_max[i]) {
-                        value_max[i] = matrix_[i][j];
+            value_max.resize(m.size());
+            value_min.resize(m.size());
+            for (size_t i = 0; i < m.size(); ++i) {
+                value_max[i] = m[i][0];
+                value_min[i] = m[i][0];
+                for (size_t j = 0; j < m[0].size(); ++j) {
+                    if (m[i][j] > value_max[i]) {
+                        value_max[i] = m[i][j];
                     }
-                    if (matrix_[i][j] < value_min[i]) {
-                        value_min[i] = matrix_[i][j];
+                    if (m[i][j] < value_min[i]) {
+                        value_min[i] = m[i][j];
                     }
                 }
             }
         }
+    }
+
+    double matrix::normalized_value(const vector_2d &m, size_t i, size_t j,
+                                    const std::vector<double> &value_min,
+                                    const std::vector<double> &value_max) {
+        double z = m[i][j];
+        switch (normalization_) {
+        case color_normalization::none:
+            break;
+        case color_normalization::columns:
+            z -= value_min[j];
+            z /= value_max[j] - value_min[j];
+            break;
+        case color_normalization::rows:
+            z -= value_min[i];
+            z /= value_max[i] - value_min[i];
+            break;
+        }
+        return z;
+    }
+
+    std::string matrix::matrix_data_string() {
+        // single matrix, with about one cell per pixel
+        const size_t level = lod_level();
+        auto &matrix_ = lod_channel(0, level);
+        const double stride = static_cast<double>(size_t(1) << level);
+
+        // calculate min/max row/cols if normalizing
+        std::vector<double> value_max;
+        std::vector<double> value_min;
+        normalization_limits(matrix_, value_min, value_max);
 
         // stream matrix
-        std::stringstream ss;
-        double x_width_ = x_width();
-        double y_width_ = y_width();
+        text_writer out(text_data_precision());
+        // reduced cells are centered on the cells they cover
+        double x_width_ = x_width() * stride;
+        double y_width_ = y_width() * stride;
+        double x_first = x_ + x_width() * (stride - 1) / 2;
+        double y_first = y_ + y_width() * (stride - 1) / 2;
         const auto &[cb_min, cb_max] = parent_->color_box_range();
         bool use_cb_range = cb_min != cb_max;
         for (size_t i = 0; i < matrix_.size(); ++i) {
             for (size_t j = 0; j < matrix_[i].size(); ++j) {
                 // z will be normalized
-                double z = matrix_[i][j];
-                switch (normalization_) {
-                case color_normalization::none:
-                    break;
-                case color_normalization::columns:
-                    z -= value_min[j];
-                    z /= value_max[j] - value_min[j];
-                    break;
-                case color_normalization::rows:
-                    z -= value_min[i];
-                    z /= value_max[i] - value_min[i];
-                    break;
-                }
-                ss << "    " << x_ + x_width_ * j << "  " << y_ + y_width_ * i;
+                double z =
+                    normalized_value(matrix_, i, j, value_min, value_max);
+                out << "    " << x_first + x_width_ * j << "  "
+                    << y_first + y_width_ * i;
                 if (alpha_ == 0.) {
-                    ss << "  " << z;
+                    out << "  " << z;
                 } else {
                     color_array c = parent_->colormap_interpolation(
                         z, use_cb_range ? cb_min : 0.,
                         use_cb_range ? cb_max : 255);
-                    ss << "  " << c[1] * 255 << "  " << c[2] * 255 << "  "
-                       << c[3] * 255 << "  " << (1. - alpha_) * 255;
+                    out << "  " << c[1] * 255 << "  " << c[2] * 255 << "  "
+                        << c[3] * 255 << "  " << (1. - alpha_) * 255;
                 }
-                ss << "\n";
+                out << "\n";
             }
-            ss << "\n";
+            out << "\n";
         }
-        ss << "    e\n";
+        out << "    e\n";
 
         if (should_plot_labels()) {
             // find matrix max and min
@@ -224,14 +247,14 @@ namespace matplot {
                     }
 
                     if (normalized_value <= normalized_threshold) {
-                        ss << "    " << x_ + x_width_ * j << "  "
-                           << y_ + y_width_ * i << "  \"" << matrix_[i][j]
-                           << "\"\n";
+                        out << "    " << x_ + x_width_ * j << "  "
+                            << y_ + y_width_ * i << "  \"" << matrix_[i][j]
+                            << "\"\n";
                     }
                 }
-                ss << "\n";
+                out << "\n";
             }
-            ss << "    e\n";
+            out << "    e\n";
 
             for (size_t i = 0; i < matrix_.size(); ++i) {
                 for (size_t j = 0; j < matrix_[i].size(); ++j) {
@@ -248,44 +271,52 @@ namespace matplot {
                     }
 
                     if (normalized_value > normalized_threshold) {
-                        ss << "    " << x_ + x_width_ * j << "  "
-                           << y_ + y_width_ * i << "  \"" << matrix_[i][j]
-                           << "\"\n";
+                        out << "    " << x_ + x_width_ * j << "  "
+                            << y_ + y_width_ * i << "  \"" << matrix_[i][j]
+                            << "\"\n";
                     }
                 }
-                ss << "\n";
+                out << "\n";
             }
-            ss << "    e\n";
+            out << "    e\n";
         }
 
-        return ss.str();
+        return out.str();
     }
 
     std::string matrix::image_data_string() {
-        std::stringstream ss;
-        auto [h, w] = size(matrices_[0]);
-        double x_width_ = x_width();
-        double y_width_ = y_width();
+        text_writer out(text_data_precision());
+        // channels with about one cell per pixel
+        const size_t level = lod_level();
+        std::vector<const vector_2d *> channels;
+        for (size_t k = 0; k < matrices_.size(); ++k) {
+            channels.emplace_back(&lod_channel(k, level));
+        }
+        auto [h, w] = size(*channels[0]);
+        // reduced cells are centered on the cells they cover
+        const double stride = static_cast<double>(size_t(1) << level);
+        double x_width_ = x_width() * stride;
+        double y_width_ = y_width() * stride;
+        double x_first = x_ + x_width() * (stride - 1) / 2;
+        double y_first = y_ + y_width() * (stride - 1) / 2;
         for (size_t i = 0; i < w; ++i) {
             for (size_t j = 0; j < h; ++j) {
-                ss << "    " << x_ + x_width_ * i;
-                ss << "  " << y_ + y_width_ * j;
-                ss << "  " << static_cast<int>(matrices_[0][j][i]);
-                if (matrices_.size() >= 3) {
-                    ss << "  " << static_cast<int>(matrices_[1][j][i]);
-                    ss << "  " << static_cast<int>(matrices_[2][j][i]);
+                out << "    " << x_first + x_width_ * i;
+                out << "  " << y_first + y_width_ * j;
+                out << "  " << static_cast<int>((*channels[0])[j][i]);
+                if (channels.size() >= 3) {
+                    out << "  " << static_cast<int>((*channels[1])[j][i]);
+                    out << "  " << static_cast<int>((*channels[2])[j][i]);
                 }
                 if (has_alpha()) {
-                    ss << "  "
-                       << static_cast<int>(
-                              (1 - alpha_) *
-                              (is_rgba() ? matrices_[3][j][i] : 255.));
+                    const double a = is_rgba() ? (*channels[3])[j][i] : 255.;
+                    out << "  " << static_cast<int>((1 - alpha_) * a);
                 }
-                ss << "\n";
+                out << "\n";
             }
         }
-        ss << "    e\n";
-        return ss.str();
+        out << "    e\n";
+        return out.str();
     }
 
     std::string matrix::data_string() {
@@ -424,4 +455,155 @@ namespace matplot {
         touch();
         return *this;
     }
+
+    bool matrix::level_of_detail() const { return level_of_detail_; }
+
+    class matrix &matrix::level_of_detail(bool level_of_detail) {
+        level_of_detail_ = level_of_detail;
+        touch();
+        return *this;
+    }
+
+    size_t matrix::lod_level() {
+        const size_t n_rows = matrices_[0].size();
+        const size_t n_cols = matrices_[0][0].size();
+        if (!level_of_detail_ || n_rows < 2 || n_cols < 2 ||
+            should_plot_labels() || parent_->is_polar() ||
+            parent_->x_axis().scale() == axis::axis_scale::log ||
+            parent_->y_axis().scale() == axis::axis_scale::log) {
+            return 0;
+        }
+        // Keep at least one cell per pixel in both directions
+        const auto [x_pixel, y_pixel] = parent_->pixel_size();
+        const double cells_per_pixel =
+            std::min(x_pixel / std::abs(x_width()),
+                     y_pixel / std::abs(y_width()));
+        return lod_pyramid::level_for(cells_per_pixel);
+    }
+
+    const vector_2d &matrix::lod_channel(size_t channel, size_t k) {
+        if (lod_revision_ != revision() ||
+            lod_pyramids_.size() != matrices_.size()) {
+            lod_pyramids_.assign(matrices_.size(), lod_pyramid());
+            lod_revision_ = revision();
+        }
+        return lod_pyramids_[channel].level(matrices_[channel], k);
+    }
+
+    void matrix::run_draw_commands() {
+        if (!visible_ || matrices_.empty() || matrices_[0].empty() ||
+            matrices_[0][0].empty()) {
+            return;
+        }
+        const size_t n_rows = matrices_[0].size();
+        const size_t n_cols = matrices_[0][0].size();
+        const double x_width_ = n_cols > 1 ? x_width() : 1.;
+        const double y_width_ = n_rows > 1 ? y_width() : 1.;
+
+        // Draw the level with about one cell per pixel. Each of its
+        // cells covers stride x stride cells of the matrix.
+        const size_t level = lod_level();
+        const size_t stride = size_t(1) << level;
+        std::vector<const vector_2d *> channels;
+        for (size_t k = 0; k < matrices_.size(); ++k) {
+            channels.emplace_back(&lod_channel(k, level));
+        }
+        const vector_2d &values = *channels[0];
+        const size_t n_level_rows = values.size();
+        const size_t n_level_cols = values[0].size();
+        auto x_edge = [&](size_t j) {
+            return x_ + x_width_ * (std::min(j * stride, n_cols) - 0.5);
+        };
+        auto y_edge = [&](size_t i) {
+            return y_ + y_width_ * (std::min(i * stride, n_rows) - 0.5);
+        };
+
+        // colors of the cells
+        std::vector<double> value_max;
+        std::vector<double> value_min;
+        std::pair<double, double> color_range{0., 1.};
+        const bool use_colormap = matrices_.size() < 3;
+        if (use_colormap) {
+            normalization_limits(values, value_min, value_max);
+            double z_min = std::numeric_limits<double>::max();
+            double z_max = std::numeric_limits<double>::lowest();
+            for (size_t i = 0; i < n_level_rows; ++i) {
+                for (size_t j = 0; j < n_level_cols; ++j) {
+                    const double z =
+                        normalized_value(values, i, j, value_min, value_max);
+                    if (std::isfinite(z)) {
+                        z_min = std::min(z_min, z);
+                        z_max = std::max(z_max, z);
+                    }
+                }
+            }
+            color_range = parent_->colormap_range(z_min, z_max);
+        }
+        auto cell_color = [&](size_t i, size_t j) {
+            color_array c;
+            if (use_colormap) {
+                c = parent_->colormap_interpolation(
+                    normalized_value(values, i, j, value_min, value_max),
+                    color_range.first, color_range.second);
+            } else {
+                // images have channels from 0 to 255
+                for (size_t k = 0; k < 3; ++k) {
+                    c[k + 1] = static_cast<float>((*channels[k])[i][j] / 255.);
+                }
+            }
+            const double opacity =
+                (1. - alpha_) * (is_rgba() ? (*channels[3])[i][j] / 255. : 1.);
+            c[0] = static_cast<float>(1. - opacity);
+            return c;
+        };
+
+        // Each row is drawn as runs of cells with the same color
+        for (size_t i = 0; i < n_level_rows; ++i) {
+            size_t first = 0;
+            color_array run_color = cell_color(i, 0);
+            for (size_t j = 1; j <= n_level_cols; ++j) {
+                color_array c = j < n_level_cols ? cell_color(i, j) : run_color;
+                if (j < n_level_cols && c == run_color) {
+                    continue;
+                }
+                parent_->draw_rectangle(x_edge(first), x_edge(j), y_edge(i),
+                                        y_edge(i + 1), run_color);
+                first = j;
+                run_color = c;
+            }
+        }
+
+        // Values over the cells, in white over the darkest 30% of
+        // the colors and in black over the others
+        if (!should_plot_labels()) {
+            return;
+        }
+        double threshold = 0.7;
+        if (normalization_ == color_normalization::none) {
+            auto [min_it, max_it] = std::minmax_element(
+                matrices_[0][0].begin(), matrices_[0][0].end());
+            double minm = *min_it;
+            double maxm = *max_it;
+            for (const auto &row : matrices_[0]) {
+                auto [row_min, row_max] =
+                    std::minmax_element(row.begin(), row.end());
+                minm = std::min(minm, *row_min);
+                maxm = std::max(maxm, *row_max);
+            }
+            threshold = minm + 0.7 * (maxm - minm);
+        }
+        const color_array black = {0, 0, 0, 0};
+        const color_array white = {0, 1, 1, 1};
+        for (size_t i = 0; i < n_rows; ++i) {
+            for (size_t j = 0; j < n_cols; ++j) {
+                const double z =
+                    normalized_value(values, i, j, value_min, value_max);
+                parent_->draw_text(x_ + x_width_ * j, y_ + y_width_ * i,
+                                   num2str(matrices_[0][i][j]),
+                                   parent_->font_size(),
+                                   z <= threshold ? black : white);
+            }
+        }
+    }
+
 } // namespace matplot
\ No newline at end of file
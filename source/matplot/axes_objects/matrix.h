@@ -13,6 +13,7 @@
 #include <matplot/util/concepts.h>
 #include <matplot/util/handle_types.h>
 #include <matplot/util/common.h>
+#include <matplot/util/lod_pyramid.h>
 
 namespace matplot {
     class axes;
@@ -56,6 +57,7 @@ namespace matplot {
 
       public /* mandatory virtual functions */:
         // std::string set_variables_string() override;
+        void run_draw_commands() override;
         std::string plot_string() override;
         // std::string legend_string(const std::string& title) override;
         std::string data_string() override;
@@ -104,6 +106,14 @@ namespace matplot {
         double alpha() const;
         class matrix &alpha(double alpha);
 
+        /// True if large matrices are reduced to the resolution of
+        /// the axes before we draw them
+        /// Each pixel then shows the mean of the cells it covers.
+        /// Heatmaps with labels and matrices on log or polar axes
+        /// are always drawn at full resolution.
+        bool level_of_detail() const;
+        class matrix &level_of_detail(bool level_of_detail);
+
       public /* functions for matrixes */:
         /// Matrix has three channels
         bool is_rgb() const;
@@ -120,9 +130,22 @@ namespace matplot {
         bool should_plot_labels();
         void setup_axes();
         std::string matrix_data_string();
+        void normalization_limits(const vector_2d &m,
+                                  std::vector<double> &value_min,
+                                  std::vector<double> &value_max);
+        double normalized_value(const vector_2d &m, size_t i, size_t j,
+                                const std::vector<double> &value_min,
+                                const std::vector<double> &value_max);
         std::string image_data_string();
         std::string labels_data_string();
 
+        /// Level of detail with about one cell per pixel of the axes
+        size_t lod_level();
+
+        /// A channel at a level of detail, built on first use
+        /// Each cell of level k covers 2^k x 2^k cells of the matrix.
+        const vector_2d &lod_channel(size_t channel, size_t k);
+
         inline double x_width() {
             return (w_ - 1) / (matrices_[0][0].size() - 1);
         }
@@ -148,6 +171,11 @@ namespace matplot {
         double alpha_ = 0.0;
 
         bool visible_{true};
+
+        // Reduced copies of each channel
+        bool level_of_detail_{true};
+        std::vector<lod_pyramid> lod_pyramids_;
+        size_t lod_revision_{0};
     };
 } // namespace matplot
 
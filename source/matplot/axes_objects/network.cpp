@@ -2,11 +2,13 @@
 // Created by Alan Freitas on 2020-07-07.
 //
 
+#include <algorithm>
 #include <cmath>
 #include <iomanip>
 #include <matplot/axes_objects/network.h>
 #include <matplot/core/axes.h>
 #include <matplot/util/common.h>
+#include <matplot/util/text_writer.h>
 #include <nodesoup.hpp>
 #include <random>
 #include <regex>
@@ -105,41 +107,41 @@ namespace matplot {
     }
 
     std::string network::data_string() {
-        std::stringstream ss;
+        text_writer out(text_data_precision());
         bool plot_z_data = z_data_.size() == x_data_.size();
         bool line_width_is_variable = !line_widths_.empty() && z_data_.empty();
         // plot edges
         if (!directed_) {
             // when not directed, each edge is a line
             for (size_t i = 0; i < edges_.size(); ++i) {
-                ss << "    " << x_data_[edges_[i].first];
+                out << "    " << x_data_[edges_[i].first];
                 if (!line_width_is_variable) {
-                    ss << "  " << y_data_[edges_[i].first];
+                    out << "  " << y_data_[edges_[i].first];
                 } else {
-                    ss << "  "
-                       << y_data_[edges_[i].first] - line_widths_[i] / 2.;
-                    ss << "  "
-                       << y_data_[edges_[i].first] + line_widths_[i] / 2.;
+                    out << "  "
+                        << y_data_[edges_[i].first] - line_widths_[i] / 2.;
+                    out << "  "
+                        << y_data_[edges_[i].first] + line_widths_[i] / 2.;
                 }
                 if (plot_z_data) {
-                    ss << "  " << z_data_[edges_[i].first];
+                    out << "  " << z_data_[edges_[i].first];
                 }
-                ss << "\n";
-                ss << "    " << x_data_[edges_[i].second];
+                out << "\n";
+                out << "    " << x_data_[edges_[i].second];
                 if (!line_width_is_variable) {
-                    ss << "  " << y_data_[edges_[i].second];
+                    out << "  " << y_data_[edges_[i].second];
                 } else {
-                    ss << "  "
-                       << y_data_[edges_[i].second] - line_widths_[i] / 2.;
-                    ss << "  "
-                       << y_data_[edges_[i].second] + line_widths_[i] / 2.;
+                    out << "  "
+                        << y_data_[edges_[i].second] - line_widths_[i] / 2.;
+                    out << "  "
+                        << y_data_[edges_[i].second] + line_widths_[i] / 2.;
                 }
                 if (plot_z_data) {
-                    ss << "  " << z_data_[edges_[i].second];
+                    out << "  " << z_data_[edges_[i].second];
                 }
-                ss << "\n\n";
+                out << "\n\n";
             }
-            ss << "e\n";
+            out << "e\n";
         } else {
             // when directed, each edge is a vector
             // for each edge, plot two vectors
@@ -157,83 +159,85 @@ namespace matplot {
                 double u2 = x2 - xmean;
                 double v2 = y2 - ymean;
                 if (!plot_z_data) {
-                    ss << "    " << x1 << "  " << y1 << "  " << u1 << "  " << v1
-                       << "\n";
-                    ss << "    " << xmean << "  " << ymean << "  " << u2 << "  "
-                       << v2 << "\n";
+                    out << "    " << x1 << "  " << y1 << "  " << u1 << "  "
+                        << v1 << "\n";
+                    out << "    " << xmean << "  " << ymean << "  " << u2
+                        << "  " << v2 << "\n";
                 } else {
                     double z1 = z_data_[edges_[i].first];
                     double z2 = z_data_[edges_[i].second];
                     double zmean = 0.5 * (z1 + z2);
                     double w1 = zmean - z1;
                     double w2 = z2 - zmean;
-                    ss << "    " << x1 << "  " << y1 << "  " << z1 << "  " << u1
-                       << "  " << v1 << "  " << w1 << "\n";
-                    ss << "    " << xmean << "  " << ymean << "  " << zmean
-                       << "  " << u2 << "  " << v2 << "  " << w2 << "\n";
+                    out << "    " << x1 << "  " << y1 << "  " << z1 << "  "
+                        << u1 << "  " << v1 << "  " << w1 << "\n";
+                    out << "    " << xmean << "  " << ymean << "  " << zmean
+                        << "  " << u2 << "  " << v2 << "  " << w2 << "\n";
                 }
             }
-            ss << "e\n";
+            out << "e\n";
         }
 
         // plot vertices
         const bool marker_size_is_variable = !marker_sizes_.empty();
         const bool marker_color_is_variable = !marker_colors_.empty();
         for (size_t i = 0; i < x_data_.size(); ++i) {
-            ss << "    " << x_data_[i];
-            ss << "  " << y_data_[i];
+            out << "    " << x_data_[i];
+            out << "  " << y_data_[i];
             if (plot_z_data) {
-                ss << "  " << z_data_[i];
+                out << "  " << z_data_[i];
             }
             if (marker_size_is_variable) {
-                ss << "  " << marker_sizes_[i];
+                out << "  " << marker_sizes_[i];
             }
             if (marker_color_is_variable) {
-                ss << "  " << marker_colors_[i];
+                out << "  " << marker_colors_[i];
             }
-            ss << "\n";
+            out << "\n";
         }
-        ss << "e\n";
+        out << "e\n";
 
         // plot labels
         if (show_labels_ || !edge_labels_.empty()) {
             if (show_labels_) {
                 for (size_t i = 0; i < x_data_.size(); ++i) {
-                    ss << "    " << x_data_[i];
-                    ss << "  " << y_data_[i];
+                    out << "    " << x_data_[i];
+                    out << "  " << y_data_[i];
                     if (plot_z_data) {
-                        ss << "  " << z_data_[i];
+                        out << "  " << z_data_[i];
                     }
                     if (node_labels().size() > i) {
-                        ss << "  " << std::quoted(node_labels_[i]);
+                        out << "  ";
+                        out.quoted(node_labels_[i]);
                     } else {
-                        ss << "  " << i;
+                        out << "  " << i;
                     }
-                    ss << "\n";
+                    out << "\n";
                 }
             }
             // plot edge labels
             if (!edge_labels_.empty()) {
                 for (size_t i = 0; i < edge_labels_.size(); ++i) {
-                    ss << "    "
-                       << 0.5 * (x_data_[edges_[i].first] +
-                                 x_data_[edges_[i].second]);
-                    ss << "  "
-                       << 0.5 * (y_data_[edges_[i].first] +
-                                 y_data_[edges_[i].second]);
+                    out << "    "
+                        << 0.5 * (x_data_[edges_[i].first] +
+                                  x_data_[edges_[i].second]);
+                    out << "  "
+                        << 0.5 * (y_data_[edges_[i].first] +
+                                  y_data_[edges_[i].second]);
                     if (plot_z_data) {
-                        ss << "  "
-                           << 0.5 * (z_data_[edges_[i].first] +
-                                     z_data_[edges_[i].second]);
+                        out << "  "
+                            << 0.5 * (z_data_[edges_[i].first] +
+                                      z_data_[edges_[i].second]);
                     }
-                    ss << "  " << std::quoted(edge_labels_[i]);
-                    ss << "\n";
+                    out << "  ";
+                    out.quoted(edge_labels_[i]);
+                    out << "\n";
                 }
             }
-            ss << "e\n";
+            out << "e\n";
         }
 
-        return ss.str();
+        return out.str();
     }
 
     void network::maybe_update_line_spec() {
@@ -719,4 +723,82 @@ namespace matplot {
         return marker_colors_;
     }
 
+    void network::run_draw_commands() {
+        if (!visible_) {
+            return;
+        }
+        maybe_update_line_spec();
+        maybe_update_graph_layout();
+        const size_t n = std::min(x_data_.size(), y_data_.size());
+
+        // edges
+        if (line_spec_.has_line()) {
+            std::vector<double> x;
+            std::vector<double> y;
+            std::vector<double> u;
+            std::vector<double> v;
+            for (const auto &[first, second] : edges_) {
+                if (first >= n || second >= n) {
+                    continue;
+                }
+                const double x1 = x_data_[first];
+                const double y1 = y_data_[first];
+                const double x2 = x_data_[second];
+                const double y2 = y_data_[second];
+                if (!directed_) {
+                    x.insert(x.end(), {x1, x2, NaN});
+                    y.insert(y.end(), {y1, y2, NaN});
+                } else {
+                    // one vector from start to middle and
+                    // one from middle to end
+                    const double xmean = 0.5 * (x1 + x2);
+                    const double ymean = 0.5 * (y1 + y2);
+                    x.insert(x.end(), {x1, xmean});
+                    y.insert(y.end(), {y1, ymean});
+                    u.insert(u.end(), {xmean - x1, x2 - xmean});
+                    v.insert(v.end(), {ymean - y1, y2 - ymean});
+                }
+            }
+            if (!directed_) {
+                parent_->draw_path(x, y, line_spec_.color());
+            } else {
+                parent_->draw_arrows(x, y, u, v, line_spec_.color());
+            }
+        }
+
+        // nodes
+        if (!line_spec_.has_non_custom_marker()) {
+            return;
+        }
+        if (marker_sizes_.empty() && marker_colors_.empty()) {
+            parent_->draw_markers(x_data_, y_data_, line_spec_);
+            return;
+        }
+        std::pair<double, double> color_range{0., 1.};
+        if (!marker_colors_.empty()) {
+            auto [min_it, max_it] = std::minmax_element(marker_colors_.begin(),
+                                                        marker_colors_.end());
+            color_range = parent_->colormap_range(*min_it, *max_it);
+        }
+        std::vector<double> sizes(marker_sizes_.empty() ? 1 : n,
+                                  line_spec_.marker_size());
+        std::vector<color_array> edge_colors(
+            marker_colors_.empty() ? 1 : n, line_spec_.marker_color());
+        std::vector<color_array> face_colors(
+            marker_colors_.empty() ? 1 : n, line_spec_.marker_face_color());
+        for (size_t i = 0; i < n; ++i) {
+            if (i < marker_sizes_.size()) {
+                sizes[i] = marker_sizes_[i];
+            }
+            if (i < marker_colors_.size()) {
+                edge_colors[i] = parent_->colormap_interpolation(
+                    marker_colors_[i], color_range.first, color_range.second);
+                face_colors[i] = edge_colors[i];
+            }
+        }
+        parent_->draw_markers(x_data_, y_data_, line_spec_.marker_style(),
+                              sizes, edge_colors, line_spec_.marker_face(),
+                              face_colors);
+    }
+
 } // namespace matplot
\ No newline at end of file
@@ -6,6 +6,7 @@
 #include <matplot/axes_objects/parallel_lines.h>
 #include <matplot/core/axes.h>
 #include <matplot/util/common.h>
+#include <matplot/util/text_writer.h>
 #include <regex>
 #include <sstream>
 
@@ -169,28 +170,28 @@ namespace matplot {
         };
 
         const bool color_is_variable = !line_colors_.empty();
-        std::stringstream ss;
+        text_writer out(text_data_precision());
         // for each point
         for (size_t i = 0; i < data_[0].size(); ++i) {
             // for each dimension
             for (size_t dimension = 0; dimension < data_.size(); ++dimension) {
-                ss << "    " << dimension + 1 << "  ";
+                out << "    " << dimension + 1 << "  ";
                 if (!jitter_) {
-                    ss << normalize(data_[dimension][i], dimension) << "  ";
+                    out << normalize(data_[dimension][i], dimension) << "  ";
                 } else {
-                    ss << normalize(jitter(data_[dimension][i], dimension),
-                                    dimension)
-                       << "  ";
+                    out << normalize(jitter(data_[dimension][i], dimension),
+                                     dimension)
+                        << "  ";
                 }
                 if (color_is_variable) {
-                    ss << line_colors_[i] << "  ";
+                    out << line_colors_[i] << "  ";
                 }
                 // new line
-                ss << "\n";
+                out << "\n";
             }
-            ss << "\n";
+            out << "\n";
         }
-        ss << "e\n";
+        out << "e\n";
 
         // Calculate tics for the multidimensional axes
         std::vector<ticks_results> ticks(data_.size());
@@ -212,22 +213,22 @@ namespace matplot {
 
         // The fake axes with fake ticks
         for (size_t dimension = 0; dimension < data_.size(); ++dimension) {
-            ss << "    " << dimension + 1 << "  " << 0 << "\n";
-            ss << "    " << dimension + 1 << "  " << 1 << "\n\n";
+            out << "    " << dimension + 1 << "  " << 0 << "\n";
+            out << "    " << dimension + 1 << "  " << 1 << "\n\n";
 
             const size_t n_ticks = ticks[dimension].ticks.size();
             constexpr double tick_size = 0.03;
             for (size_t i = 0; i < n_ticks + 1; ++i) {
                 double y = normalize(ticks[dimension].ticks[i], dimension);
-                ss << "    " << dimension + 1 << "  " << y << "\n";
+                out << "    " << dimension + 1 << "  " << y << "\n";
                 const bool is_last_dimension = dimension == data_.size() - 1;
-                ss << "    "
-                   << dimension + 1 +
-                          (!is_last_dimension ? -tick_size : +tick_size)
-                   << "  " << y << "\n\n";
+                out << "    "
+                    << dimension + 1 +
+                           (!is_last_dimension ? -tick_size : +tick_size)
+                    << "  " << y << "\n\n";
             }
         }
-        ss << "e\n";
+        out << "e\n";
 
         // Put labels on the fake tics
         for (size_t dimension = 0; dimension < data_.size(); ++dimension) {
@@ -237,20 +238,20 @@ namespace matplot {
                 double tic_value = ticks[dimension].ticks[i];
                 double y = normalize(tic_value, dimension);
                 const bool is_last_dimension = dimension == data_.size() - 1;
-                ss << "    "
-                   << dimension + 1 +
-                          (!is_last_dimension ? -tick_size - 0.01
-                                              : +tick_size + 0.01)
-                   << "  " << y << "  "
-                   << std::quoted(ticks[dimension].tickLabels[i]) << "\n\n";
+                out << "    "
+                    << dimension + 1 +
+                           (!is_last_dimension ? -tick_size - 0.01
+                                               : +tick_size + 0.01)
+                    << "  " << y << "  ";
+                out.quoted(ticks[dimension].tickLabels[i]) << "\n\n";
             }
             if (dimension == data_.size() - 2) {
-                ss << "e\n";
+                out << "e\n";
             }
         }
-        ss << "e\n";
+        out << "e\n";
 
-        return ss.str();
+        return out.str();
     }
 
     std::string parallel_lines::unset_variables_string() { return ""; }
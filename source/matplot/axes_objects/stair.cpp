@@ -49,26 +49,29 @@ namespace matplot {
                 // replace lines with steps, according to style
                 switch (stair_style_) {
                 case stair_style::trace_x_first:
-                    res += " '-' with steps " +
+                    res += " " + inline_data_string(style) + " with steps " +
                            line_spec_.plot_string(style, false);
                     break;
                 case stair_style::trace_y_first:
-                    res += " '-' with fsteps " +
+                    res += " " + inline_data_string(style) + " with fsteps " +
                            line_spec_.plot_string(style, false);
                     break;
                 case stair_style::histogram:
-                    res += " '-' with histeps " +
+                    res += " " + inline_data_string(style) +
+                           " with histeps " +
                            line_spec_.plot_string(style, false);
                     break;
                 case stair_style::fill:
-                    res += " '-' with fillsteps fillstyle solid 0.25 fillcolor "
+                    res += " " + inline_data_string(style) +
+                           " with fillsteps fillstyle solid 0.25 fillcolor "
                            "\"" +
                            to_string(line_spec_.color()) + "\"";
                     break;
                 }
             } else {
                 // plot markers the same way
-                res += " '-' " + line_spec_.plot_string(style);
+                res += " " + inline_data_string(style) + " " +
+                       line_spec_.plot_string(style);
             }
             if (first) {
                 first = false;
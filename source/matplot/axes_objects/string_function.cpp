@@ -32,6 +32,11 @@ namespace matplot {
 
     std::string string_function::data_string() { return ""; }
 
+    bool string_function::supports_binary_data() {
+        // The function is evaluated by gnuplot. There is no data.
+        return false;
+    }
+
     double string_function::xmax() {
         if (is_polar()) {
             return 2;
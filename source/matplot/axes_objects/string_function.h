@@ -26,6 +26,7 @@ namespace matplot {
       public:
         std::string plot_string() override;
         std::string data_string() override;
+        bool supports_binary_data() override;
         double xmax() override;
         double xmin() override;
         double ymax() override;
@@ -2,10 +2,13 @@
 // Created by Alan Freitas on 2020-07-07.
 //
 
+#include <algorithm>
 #include <cmath>
+#include <limits>
 #include <matplot/axes_objects/surface.h>
 #include <matplot/core/axes.h>
 #include <matplot/util/common.h>
+#include <matplot/util/text_writer.h>
 #include <regex>
 #include <sstream>
 
@@ -344,7 +347,7 @@ namespace matplot {
     }
 
     std::string surface::grid_data_string() {
-        std::stringstream ss;
+        text_writer out(text_data_precision());
         const bool contour = (contour_base_ || contour_surface_);
         const bool palette_map_3d = palette_map_at_bottom_ ||
                                     palette_map_at_surface_ ||
@@ -353,36 +356,43 @@ namespace matplot {
         const bool manual_color = size(Z_data_) == size(C_data_);
         const size_t replicates = 1 + repeat_data_for_contour_labels;
 
-        auto send_point = [](std::stringstream &ss, double x, double y,
-                             double z, double c) {
-            ss << "    " << x;
-            ss << "  " << y;
-            ss << "  " << z;
+        // Send the level with about one vertex per pixel
+        const size_t level = lod_level();
+        const vector_2d &X = lod_grid(0, level);
+        const vector_2d &Y = lod_grid(1, level);
+        const vector_2d &Z = lod_grid(2, level);
+        const vector_2d &C = manual_color ? lod_grid(3, level) : C_data_;
+
+        auto send_point = [](text_writer &out, double x, double y, double z,
+                             double c) {
+            out << "    " << x;
+            out << "  " << y;
+            out << "  " << z;
             if (std::isfinite(c)) {
-                ss << "  " << c;
+                out << "  " << c;
             }
-            ss << "\n";
+            out << "\n";
         };
 
-        auto send_point_fill = [](std::stringstream &ss, double x, double y,
+        auto send_point_fill = [](text_writer &out, double x, double y,
                                   double z, double zlow, double zhigh,
                                   double c) {
-            ss << "    " << x;
-            ss << "  " << y;
-            ss << "  " << z;
-            ss << "  " << zlow;
-            ss << "  " << zhigh;
+            out << "    " << x;
+            out << "  " << y;
+            out << "  " << z;
+            out << "  " << zlow;
+            out << "  " << zhigh;
             if (std::isfinite(c)) {
-                ss << "  " << c;
+                out << "  " << c;
             }
-            ss << "\n";
+            out << "\n";
         };
 
         auto color_value = [&](size_t data_replicate, size_t i, size_t j) {
             if (manual_color && data_replicate == 0) {
-                return C_data_[i][j];
+                return C[i][j];
             } else if (!palette_map_3d && !line_spec_.user_color()) {
-                return Z_data_[i][j];
+                return Z[i][j];
             } else {
                 return NaN;
             }
@@ -392,91 +402,87 @@ namespace matplot {
              ++data_replicate) {
             if (curtain_) {
                 // open curtain - first line with zmin instead of z
-                size_t i = Y_data_.size() - 1;
-                send_point(ss, X_data_[i][0], Y_data_[i][0], zmin_,
+                size_t i = Y.size() - 1;
+                send_point(out, X[i][0], Y[i][0], zmin_,
                            color_value(data_replicate, i, 0));
-                for (size_t j = 0; j < Y_data_[i].size(); ++j) {
-                    send_point(ss, X_data_[i][j], Y_data_[i][j], zmin_,
+                for (size_t j = 0; j < Y[i].size(); ++j) {
+                    send_point(out, X[i][j], Y[i][j], zmin_,
                                color_value(data_replicate, i, j));
                 }
-                send_point(
-                    ss, X_data_[i][Y_data_[i].size() - 1],
-                    Y_data_[i][Y_data_[i].size() - 1], zmin_,
-                    color_value(data_replicate, i, Y_data_[i].size() - 1));
-                ss << "\n";
+                send_point(out, X[i][Y[i].size() - 1], Y[i][Y[i].size() - 1],
+                           zmin_,
+                           color_value(data_replicate, i, Y[i].size() - 1));
+                out << "\n";
             }
             // each row is an isoline
-            for (long i = Y_data_.size() - 1; i >= 0; --i) {
+            for (long i = Y.size() - 1; i >= 0; --i) {
                 // open row curtain or waterfall
                 if (curtain_ || waterfall_) {
-                    send_point(ss, X_data_[i][0], Y_data_[i][0], zmin_,
+                    send_point(out, X[i][0], Y[i][0], zmin_,
                                color_value(data_replicate, i, 0));
                 }
                 // send all points in that row
-                for (size_t j = 0; j < Y_data_[i].size(); ++j) {
+                for (size_t j = 0; j < Y[i].size(); ++j) {
                     if (!fences_) {
-                        send_point(ss, X_data_[i][j], Y_data_[i][j],
-                                   Z_data_[i][j],
+                        send_point(out, X[i][j], Y[i][j], Z[i][j],
                                    color_value(data_replicate, i, j));
                     } else {
-                        send_point_fill(ss, X_data_[i][j], Y_data_[i][j],
-                                        Z_data_[i][j], zmin_, Z_data_[i][j],
+                        send_point_fill(out, X[i][j], Y[i][j], Z[i][j], zmin_,
+                                        Z[i][j],
                                         color_value(data_replicate, i, j));
                     }
                 }
                 // close row curtain or waterfall
                 if (curtain_ || waterfall_) {
                     send_point(
-                        ss, X_data_[i][Y_data_[i].size() - 1],
-                        Y_data_[i][Y_data_[i].size() - 1], zmin_,
-                        color_value(data_replicate, i, Y_data_[i].size() - 1));
+                        out, X[i][Y[i].size() - 1], Y[i][Y[i].size() - 1],
+                        zmin_, color_value(data_replicate, i, Y[i].size() - 1));
                 }
                 // end the current isoline
                 if (!waterfall_ && !fences_) {
                     // usually an empty line to indicate this isoline is over
-                    ss << "\n";
+                    out << "\n";
                 } else {
                     // waterfalls and fences have one splot per row
                     // so we end not only the isoline
-                    ss << "e\n";
+                    out << "e\n";
                 }
             }
             if (curtain_) {
                 // close curtain
                 size_t i = 0;
-                send_point(ss, X_data_[i][0], Y_data_[i][0], zmin_,
+                send_point(out, X[i][0], Y[i][0], zmin_,
                            color_value(data_replicate, i, 0));
-                for (size_t j = 0; j < Y_data_[i].size(); ++j) {
-                    send_point(ss, X_data_[i][j], Y_data_[i][j], zmin_,
+                for (size_t j = 0; j < Y[i].size(); ++j) {
+                    send_point(out, X[i][j], Y[i][j], zmin_,
                                color_value(data_replicate, i, j));
                 }
-                send_point(
-                    ss, X_data_[i][Y_data_[i].size() - 1],
-                    Y_data_[i][Y_data_[i].size() - 1], zmin_,
-                    color_value(data_replicate, i, Y_data_[i].size() - 1));
-                ss << "\n";
+                send_point(out, X[i][Y[i].size() - 1], Y[i][Y[i].size() - 1],
+                           zmin_,
+                           color_value(data_replicate, i, Y[i].size() - 1));
+                out << "\n";
             }
 
             // finish the plot
             // waterfalls don't need closing again
             if (!waterfall_ && !fences_) {
-                ss << "e\n";
+                out << "e\n";
             }
         }
-        return ss.str();
+        return out.str();
     }
 
     std::string surface::ribbon_data_string() {
-        std::stringstream ss;
-        auto send_point = [](std::stringstream &ss, double x, double y,
-                             double z, double c) {
-            ss << "    " << x;
-            ss << "  " << y;
-            ss << "  " << z;
+        text_writer out(text_data_precision());
+        auto send_point = [](text_writer &out, double x, double y, double z,
+                             double c) {
+            out << "    " << x;
+            out << "  " << y;
+            out << "  " << z;
             if (std::isfinite(c)) {
-                ss << "  " << c;
+                out << "  " << c;
             }
-            ss << "\n";
+            out << "\n";
         };
 
         const bool manual_color = size(Z_data_) == size(C_data_);
@@ -503,15 +509,15 @@ namespace matplot {
         for (size_t i = 0; i < n_cols; ++i) {
             // two isolines per row
             for (size_t j = 0; j < n_rows; ++j) {
-                send_point(ss, X_data_[j][i] - absolute_width / 2.,
+                send_point(out, X_data_[j][i] - absolute_width / 2.,
                            Y_data_[j][i], Z_data_[j][i], color_value(j, i));
-                send_point(ss, X_data_[j][i] + absolute_width / 2.,
+                send_point(out, X_data_[j][i] + absolute_width / 2.,
                            Y_data_[j][i], Z_data_[j][i], color_value(j, i));
-                ss << "\n";
+                out << "\n";
             }
-            ss << "e\n";
+            out << "e\n";
         }
-        return ss.str();
+        return out.str();
     }
 
     std::string surface::data_string() {
@@ -917,4 +923,201 @@ namespace matplot {
         return *this;
     }
 
+    bool surface::level_of_detail() const { return level_of_detail_; }
+
+    class surface &surface::level_of_detail(bool level_of_detail) {
+        level_of_detail_ = level_of_detail;
+        touch();
+        return *this;
+    }
+
+    size_t surface::lod_level() {
+        const size_t n_rows =
+            std::min({X_data_.size(), Y_data_.size(), Z_data_.size()});
+        if (!level_of_detail_ || waterfall_ || fences_ || ribbons_ ||
+            n_rows < 2 || parent_->is_polar() ||
+            parent_->x_axis().scale() == axis::axis_scale::log ||
+            parent_->y_axis().scale() == axis::axis_scale::log) {
+            return 0;
+        }
+        // The grid might be curved, so we measure the middle row and
+        // the middle column on the screen
+        const auto [x_pixel, y_pixel] = parent_->pixel_size();
+        auto pixel_distance = [&](size_t i1, size_t j1, size_t i2,
+                                  size_t j2) {
+            return std::hypot((X_data_[i2][j2] - X_data_[i1][j1]) / x_pixel,
+                              (Y_data_[i2][j2] - Y_data_[i1][j1]) / y_pixel);
+        };
+        const size_t middle_row = n_rows / 2;
+        const size_t n_cols =
+            std::min(X_data_[middle_row].size(), Y_data_[middle_row].size());
+        double row_length = 0.;
+        for (size_t j = 0; j + 1 < n_cols; ++j) {
+            row_length += pixel_distance(middle_row, j, middle_row, j + 1);
+        }
+        const size_t middle_col = n_cols / 2;
+        double col_length = 0.;
+        for (size_t i = 0; i + 1 < n_rows; ++i) {
+            if (middle_col < X_data_[i + 1].size() &&
+                middle_col < Y_data_[i + 1].size()) {
+                col_length += pixel_distance(i, middle_col, i + 1, middle_col);
+            }
+        }
+        // Keep at least one vertex per pixel in both directions
+        const double cells_per_pixel =
+            std::min((n_cols - 1) / row_length, (n_rows - 1) / col_length);
+        return lod_pyramid::level_for(cells_per_pixel);
+    }
+
+    const vector_2d &surface::lod_grid(size_t grid, size_t k) {
+        if (lod_revision_ != revision()) {
+            for (auto &pyramid : lod_pyramids_) {
+                pyramid.clear();
+            }
+            lod_revision_ = revision();
+        }
+        const std::array<const vector_2d *, 4> grids = {&X_data_, &Y_data_,
+                                                        &Z_data_, &C_data_};
+        return lod_pyramids_[grid].level(*grids[grid], k);
+    }
+
+    void surface::run_draw_commands() {
+        // Only the map view is drawn for now. Ribbons, fences and
+        // waterfalls need a 3D projection.
+        if (!visible_ || waterfall_ || fences_ || ribbons_ ||
+            Z_data_.empty() || Z_data_[0].empty()) {
+            return;
+        }
+        // Draw the level with about one vertex per pixel
+        const size_t level = lod_level();
+        const vector_2d &X = lod_grid(0, level);
+        const vector_2d &Y = lod_grid(1, level);
+        const vector_2d &Z = lod_grid(2, level);
+        const size_t n_rows = std::min({X.size(), Y.size(), Z.size()});
+        const bool manual_color = size(Z_data_) == size(C_data_);
+        const vector_2d &values = manual_color ? lod_grid(3, level) : Z;
+        double value_min = std::numeric_limits<double>::max();
+        double value_max = std::numeric_limits<double>::lowest();
+        for (const auto &row : values) {
+            for (const double value : row) {
+                if (std::isfinite(value)) {
+                    value_min = std::min(value_min, value);
+                    value_max = std::max(value_max, value);
+                }
+            }
+        }
+        const auto [color_min, color_max] =
+            parent_->colormap_range(value_min, value_max);
+
+        // Values are quantized to the colormap entries, so we can
+        // draw all cells with the same color at once
+        const size_t n_colors =
+            parent_->max_colors()
+                ? parent_->max_colors()
+                : std::max<size_t>(parent_->colormap().size(), 2);
+        auto color_index = [&](double value) {
+            const double t = (value - color_min) / (color_max - color_min);
+            const double clamped =
+                std::isfinite(t) ? std::clamp(t, 0., 1.) : 0.5;
+            return static_cast<size_t>(std::lround(clamped * (n_colors - 1)));
+        };
+        auto index_color = [&](size_t index) {
+            return parent_->colormap_interpolation(
+                static_cast<double>(index), 0., n_colors - 1.);
+        };
+
+        const bool is_solid_surface = palette_map_at_bottom_ ||
+                                      palette_map_at_surface_ ||
+                                      palette_map_at_top_;
+        if (surface_visible_ && is_solid_surface) {
+            std::vector<std::vector<double>> x(n_colors);
+            std::vector<std::vector<double>> y(n_colors);
+            for (size_t i = 0; i + 1 < n_rows; ++i) {
+                const size_t n_cols =
+                    std::min({X[i].size(), X[i + 1].size(), Y[i].size(),
+                              Y[i + 1].size(), values[i].size(),
+                              values[i + 1].size()});
+                for (size_t j = 0; j + 1 < n_cols; ++j) {
+                    // cells are colored by the mean of their corners
+                    const double value = (values[i][j] + values[i][j + 1] +
+                                          values[i + 1][j + 1] +
+                                          values[i + 1][j]) /
+                                         4.;
+                    if (!std::isfinite(value)) {
+                        continue;
+                    }
+                    const size_t k = color_index(value);
+                    x[k].insert(x[k].end(),
+                                {X[i][j], X[i][j + 1], X[i + 1][j + 1],
+                                 X[i][j], X[i + 1][j + 1], X[i + 1][j]});
+                    y[k].insert(y[k].end(),
+                                {Y[i][j], Y[i][j + 1], Y[i + 1][j + 1],
+                                 Y[i][j], Y[i + 1][j + 1], Y[i + 1][j]});
+                }
+            }
+            for (size_t k = 0; k < n_colors; ++k) {
+                color_array c = index_color(k);
+                c[0] = 1.f - face_alpha_;
+                parent_->draw_triangles(x[k], y[k], c);
+            }
+        }
+
+        if (!line_spec_.has_line()) {
+            return;
+        }
+        if (is_solid_surface || line_spec_.user_color()) {
+            // Default line color for surfaces is black
+            const color_array c = line_spec_.user_color()
+                                      ? line_spec_.color()
+                                      : color_array{0, 0, 0, 0};
+            std::vector<double> x;
+            std::vector<double> y;
+            for (size_t i = 0; i < n_rows; ++i) {
+                x.insert(x.end(), X[i].begin(), X[i].end());
+                y.insert(y.end(), Y[i].begin(), Y[i].end());
+                x.emplace_back(NaN);
+                y.emplace_back(NaN);
+            }
+            for (size_t j = 0; j < X[0].size(); ++j) {
+                for (size_t i = 0; i < n_rows; ++i) {
+                    x.emplace_back(j < X[i].size() ? X[i][j] : NaN);
+                    y.emplace_back(j < Y[i].size() ? Y[i][j] : NaN);
+                }
+                x.emplace_back(NaN);
+                y.emplace_back(NaN);
+            }
+            parent_->draw_path(x, y, c);
+            return;
+        }
+
+        // Mesh segments are colored by the mean of their ends
+        std::vector<std::vector<double>> x(n_colors);
+        std::vector<std::vector<double>> y(n_colors);
+        auto add_segment = [&](size_t i1, size_t j1, size_t i2, size_t j2) {
+            const double value = (values[i1][j1] + values[i2][j2]) / 2.;
+            if (!std::isfinite(value)) {
+                return;
+            }
+            const size_t k = color_index(value);
+            x[k].insert(x[k].end(), {X[i1][j1], X[i2][j2], NaN});
+            y[k].insert(y[k].end(), {Y[i1][j1], Y[i2][j2], NaN});
+        };
+        for (size_t i = 0; i < n_rows; ++i) {
+            const size_t n_cols =
+                std::min({X[i].size(), Y[i].size(), values[i].size()});
+            for (size_t j = 0; j < n_cols; ++j) {
+                if (j + 1 < n_cols) {
+                    add_segment(i, j, i, j + 1);
+                }
+                if (i + 1 < n_rows && j < X[i + 1].size() &&
+                    j < Y[i + 1].size() && j < values[i + 1].size()) {
+                    add_segment(i, j, i + 1, j);
+                }
+            }
+        }
+        for (size_t k = 0; k < n_colors; ++k) {
+            parent_->draw_path(x[k], y[k], index_color(k));
+        }
+    }
+
 } // namespace matplot
\ No newline at end of file
@@ -14,6 +14,7 @@
 #include <matplot/core/axes_object.h>
 #include <matplot/core/line_spec.h>
 #include <matplot/util/common.h>
+#include <matplot/util/lod_pyramid.h>
 
 namespace matplot {
     class axes;
@@ -43,6 +44,7 @@ namespace matplot {
 
       public /* mandatory virtual functions */:
         std::string set_variables_string() override;
+        void run_draw_commands() override;
         std::string plot_string() override;
         std::string legend_string(const std::string &title) override;
         std::string data_string() override;
@@ -166,6 +168,14 @@ namespace matplot {
         bool visible() const;
         class surface &visible(bool visible);
 
+        /// True if large grids are reduced to the resolution of the
+        /// axes before we draw them
+        /// Each level halves the rows and columns, until there is
+        /// about one vertex per pixel. Waterfalls, fences, ribbons,
+        /// and surfaces on log or polar axes always use all vertices.
+        bool level_of_detail() const;
+        class surface &level_of_detail(bool level_of_detail);
+
       public /* getters and setters bypassing the line_spec */:
         float line_width() const;
         class surface &line_width(float line_width);
@@ -193,6 +203,12 @@ namespace matplot {
         std::string ribbon_data_string();
         size_t create_line_index();
 
+        /// Level of detail with about one vertex per pixel of the axes
+        size_t lod_level();
+
+        /// X, Y, Z, or C data (0 to 3) at a level of detail
+        const vector_2d &lod_grid(size_t grid, size_t k);
+
       protected:
         /// Data in the xlim
         vector_2d X_data_{};
@@ -247,6 +263,15 @@ namespace matplot {
 
         /// True if visible
         bool visible_{true};
+
+        /// Reduced copies of X, Y, Z, and C
+        bool level_of_detail_{true};
+        std::array<lod_pyramid, 4> lod_pyramids_{
+            lod_pyramid(lod_pyramid::reduction::subsample),
+            lod_pyramid(lod_pyramid::reduction::subsample),
+            lod_pyramid(lod_pyramid::reduction::subsample),
+            lod_pyramid(lod_pyramid::reduction::subsample)};
+        size_t lod_revision_{0};
     };
 } // namespace matplot
 
@@ -6,6 +6,7 @@
 #include <matplot/axes_objects/vectors.h>
 #include <matplot/core/axes.h>
 #include <matplot/util/common.h>
+#include <matplot/util/text_writer.h>
 #include <regex>
 #include <sstream>
 
@@ -68,7 +69,7 @@ namespace matplot {
     }
 
     std::string vectors::data_string() {
-        std::stringstream ss;
+        text_writer out(text_data_precision());
         if (visible_) {
             for (size_t i = 0; i < v_data_.size(); ++i) {
                 double x_value = x_data_.size() > i ? x_data_[i]
@@ -85,27 +86,27 @@ namespace matplot {
                     !std::isfinite(z_value) || !std::isfinite(u_value) ||
                     !std::isfinite(v_value) || !std::isfinite(w_value);
                 if (is_end_of_series) {
-                    ss << "    \n";
+                    out << "    \n";
                     continue;
                 }
 
-                ss << "    " << x_value;
-                ss << "  " << y_value;
+                out << "    " << x_value;
+                out << "  " << y_value;
                 if (is_3d()) {
-                    ss << "  " << z_value;
+                    out << "  " << z_value;
                 } else if (parent_->is_3d()) {
-                    ss << "  " << 0.0;
+                    out << "  " << 0.0;
                 }
 
-                ss << "  " << u_value;
-                ss << "  " << v_value;
+                out << "  " << u_value;
+                out << "  " << v_value;
                 if (is_3d()) {
-                    ss << "  " << w_value;
+                    out << "  " << w_value;
                 } else if (parent_->is_3d()) {
-                    ss << "  " << 0.0;
+                    out << "  " << 0.0;
                 }
 
-                ss << "\n";
+                out << "\n";
             }
             // if polar, gnuplot uses the vector origin to determine
             // the automatic range of the r-axis.
@@ -114,12 +115,12 @@ namespace matplot {
             // So we create an extra vector of magnitude zero from
             // the polar max to make the r-range adapt.
             if (is_polar()) {
-                ss << "    0  " << xmax() << "  0  0\n";
+                out << "    0  " << xmax() << "  0  0\n";
             }
         }
-        ss << "    "
-           << "e\n";
-        return ss.str();
+        out << "    "
+            << "e\n";
+        return out.str();
     }
 
     void vectors::maybe_update_line_spec() {
@@ -397,4 +398,23 @@ namespace matplot {
         return *this;
     }
 
+    void vectors::run_draw_commands() {
+        // Polar and 3D vectors are only drawn by gnuplot for now
+        if (!visible_ || is_polar() || is_3d()) {
+            return;
+        }
+        maybe_update_line_spec();
+        const size_t n = v_data_.size();
+        std::vector<double> x(n);
+        std::vector<double> y(n);
+        std::vector<double> u(n);
+        std::vector<double> v(v_data_);
+        for (size_t i = 0; i < n; ++i) {
+            x[i] = x_data_.size() > i ? x_data_[i] : static_cast<double>(i + 1);
+            y[i] = y_data_.size() > i ? y_data_[i] : 0;
+            u[i] = u_data_.size() > i ? u_data_[i] : 0;
+        }
+        parent_->draw_arrows(x, y, u, v, line_spec_.color(), 8.f, fill_);
+    }
+
 } // namespace matplot
\ No newline at end of file
@@ -55,6 +55,7 @@ namespace matplot {
             : vectors(parent.get(), args...) {}
 
       public /* mandatory virtual functions */:
+        void run_draw_commands() override;
         std::string plot_string() override;
         std::string legend_string(const std::string &title) override;
         std::string data_string() override;
@@ -3,6 +3,7 @@
 //
 
 #include "backend_interface.h"
+#include <matplot/backend/vertex_batch.h>
 #include <matplot/util/common.h>
 
 namespace matplot::backend {
@@ -79,6 +80,18 @@ namespace matplot::backend {
         }
     }
 
+    void backend_interface::draw_triangles(const std::vector<double> &x,
+                                           const std::vector<double> &y,
+                                           const std::array<float, 4> &color) {
+        if (!consumes_gnuplot_commands()) {
+            throw std::logic_error(
+                "There is no function to draw_triangles in this backend yet");
+        } else {
+            throw std::logic_error("This backend has no function draw_triangles "
+                                   "because it is based on gnuplot commands");
+        }
+    }
+
     void backend_interface::draw_markers(const std::vector<double> &x,
                                          const std::vector<double> &y,
                                          const std::vector<double> &z) {
@@ -103,6 +116,20 @@ namespace matplot::backend {
         }
     }
 
+    void backend_interface::draw_text(const std::string &text, double x,
+                                      double y, const std::string &font,
+                                      float font_size,
+                                      const std::array<float, 4> &color,
+                                      float angle) {
+        if (!consumes_gnuplot_commands()) {
+            throw std::logic_error(
+                "There is no function to draw_text in this backend yet");
+        } else {
+            throw std::logic_error("This backend has no function draw_text "
+                                   "because it is based on gnuplot commands");
+        }
+    }
+
     void
     backend_interface::draw_image(const std::vector<std::vector<double>> &x,
                                   const std::vector<std::vector<double>> &y,
@@ -139,6 +166,37 @@ namespace matplot::backend {
         }
     }
 
+    bool backend_interface::binary_data() { return false; }
+
+    bool backend_interface::binary_data_single_precision() { return false; }
+
+    int backend_interface::text_data_precision() { return 6; }
+
+    void backend_interface::run_binary_data(const std::string &data) {
+        if (consumes_gnuplot_commands()) {
+            throw std::logic_error(
+                "There is no function to run_binary_data in this backend yet");
+        } else {
+            throw std::logic_error(
+                "This backend has no function to run_binary_data because it "
+                "is not based on gnuplot commands");
+        }
+    }
+
+    bool backend_interface::binary_data_files() { return false; }
+
+    std::string
+    backend_interface::write_binary_data_file(const std::string &key,
+                                              const std::string &data) {
+        throw std::logic_error(
+            "There is no function to write_binary_data_file in this backend");
+    }
+
+    std::string backend_interface::binary_data_file(const std::string &key) {
+        throw std::logic_error(
+            "There is no function to binary_data_file in this backend");
+    }
+
     void backend_interface::include_comment(const std::string &text) {
         if (consumes_gnuplot_commands()) {
             throw std::logic_error(
@@ -166,6 +224,33 @@ namespace matplot::backend {
 
     void backend_interface::position_y(unsigned int new_position_y) {}
 
+    bool backend_interface::supports_vertex_batch() { return false; }
+
+    void backend_interface::draw_batch(const vertex_batch &batch) {
+        if (!consumes_gnuplot_commands()) {
+            throw std::logic_error(
+                "There is no function to draw_batch in this backend yet");
+        } else {
+            throw std::logic_error("This backend has no function draw_batch "
+                                   "because it is based on gnuplot commands");
+        }
+    }
+
+    bool backend_interface::supports_partial_repaint() { return false; }
+
+    void backend_interface::repaint_region(const vertex_batch &batch,
+                                           double x1, double x2, double y1,
+                                           double y2) {
+        if (!consumes_gnuplot_commands()) {
+            throw std::logic_error(
+                "There is no function to repaint_region in this backend yet");
+        } else {
+            throw std::logic_error("This backend has no function "
+                                   "repaint_region because it is based on "
+                                   "gnuplot commands");
+        }
+    }
+
     void backend_interface::draw_background(const std::array<float, 4> &color) {}
 
     void backend_interface::draw_rectangle(const double x1, const double x2,
@@ -11,6 +11,8 @@
 
 namespace matplot {
     namespace backend {
+        class vertex_batch;
+
         /// Inherit from this class to create a new backend
         /// - Interactive backends show the plots on a window
         /// - Non-interactive backends save the plots to a file
@@ -144,6 +146,12 @@ namespace matplot {
                                    const std::vector<double> &y,
                                    const std::array<float, 4> &color);
 
+            /// \brief Draw filled triangles on the image
+            /// Each three points are a triangle.
+            virtual void draw_triangles(const std::vector<double> &x,
+                                        const std::vector<double> &y,
+                                        const std::array<float, 4> &color);
+
             /// \brief Draw markers on the image
             virtual void draw_markers(const std::vector<double> &x,
                                       const std::vector<double> &y,
@@ -154,6 +162,19 @@ namespace matplot {
                                    const std::vector<double> &y,
                                    const std::vector<double> &z = {});
 
+            /// \brief Draw a line of text on the image
+            /// (x, y) is the bottom left corner of the text. The font
+            /// size is the height of a line in pixels. The angle
+            /// rotates the text around (x, y), in degrees
+            /// counterclockwise.
+            /// Backends that draw batches get text in the batch,
+            /// as glyphs from a glyph_atlas, instead.
+            virtual void draw_text(const std::string &text, double x,
+                                   double y, const std::string &font,
+                                   float font_size,
+                                   const std::array<float, 4> &color,
+                                   float angle = 0.f);
+
             /// \brief Draw image matrix on the image
             virtual void
             draw_image(const std::vector<std::vector<double>> &x,
@@ -165,6 +186,32 @@ namespace matplot {
                                        const std::vector<double> &y,
                                        const std::vector<double> &z = {});
 
+            /// \brief True if the backend can draw a whole vertex_batch
+            /// If true, the figure records the primitives of each frame
+            /// in a vertex_batch and calls draw_batch once, rather than
+            /// calling the functions above for each primitive.
+            /// The default implementation returns false.
+            virtual bool supports_vertex_batch();
+
+            /// \brief Draw all the primitives of a frame
+            /// Commands should be drawn in order. Each command has a
+            /// single color, so backends can usually draw it with a
+            /// single call.
+            virtual void draw_batch(const vertex_batch &batch);
+
+            /// \brief True if the backend keeps the pixels of the last
+            /// frame, so that the figure can repaint only some regions
+            /// The default implementation returns false.
+            virtual bool supports_partial_repaint();
+
+            /// \brief Draw a vertex_batch over a region of the last frame
+            /// Only the pixels inside the region change. The batch
+            /// should cover the whole region, so it usually starts
+            /// with the background. The figure repaints all regions
+            /// that changed and then calls render_data().
+            virtual void repaint_region(const vertex_batch &batch, double x1,
+                                        double x2, double y1, double y2);
+
             /// We can certainly include more functions here, such as
             /// draw_mesh, draw_rectangle, etc...
             /// However, these functions should have a default implementation
@@ -193,6 +240,52 @@ namespace matplot {
             /// We can buffer the lines until the end of data is sent
             virtual void run_command(const std::string &text);
 
+            /// \brief True if objects should send their data as inline
+            /// binary records rather than text
+            /// Formatting and parsing text is the most expensive part of
+            /// sending large datasets to gnuplot. Objects that support it
+            /// will use the `binary record=... format=...` syntax instead.
+            /// The default implementation returns false.
+            virtual bool binary_data();
+
+            /// \brief True if inline binary records should be float32
+            /// rather than float64
+            virtual bool binary_data_single_precision();
+
+            /// \brief Significant digits of numbers in text data
+            /// Zero means the shortest representation that parses back
+            /// to the same number. Fewer digits make the data smaller.
+            /// The default implementation returns 6, which is the
+            /// precision of std::ostream.
+            virtual int text_data_precision();
+
+            /// \brief Send raw bytes to the gnuplot pipe
+            /// These are the records of an inline binary data block
+            /// and are not followed by a newline.
+            virtual void run_binary_data(const std::string &data);
+
+            /// \brief True if binary data should be written to files
+            /// that the plot command references by path
+            /// This avoids streaming large datasets through the pipe and
+            /// lets us reuse the files of objects that did not change.
+            /// This only applies if binary_data() is also true.
+            /// The default implementation returns false.
+            virtual bool binary_data_files();
+
+            /// \brief Write the binary data for a key to its file
+            /// Keys identify data sources and should be unique.
+            /// The backend owns these files and is responsible for
+            /// removing the files that are not in use anymore.
+            /// \return Path to the file
+            virtual std::string
+            write_binary_data_file(const std::string &key,
+                                   const std::string &data);
+
+            /// \brief Get the path of the file for a key, if it exists
+            /// This also tells the backend the file is still in use.
+            /// \return Path to the file or an empty string
+            virtual std::string binary_data_file(const std::string &key);
+
             /// \brief Include a comment in the gnuplot code
             /// This is useful when tracing the gnuplot commands
             /// and when generating a gnuplot file.
@@ -0,0 +1,464 @@
+#include "cimg_raster.h"
+#include <algorithm>
+#include <cmath>
+#include <filesystem>
+#include <iostream>
+#include <matplot/backend/glyph_atlas.h>
+#include <matplot/backend/vertex_batch.h>
+#include <matplot/util/common.h>
+
+#include <CImg.h>
+
+namespace {
+    using image_t = cimg_library::CImg<unsigned char>;
+    using matplot::backend::vertex_batch;
+
+    /// Matplot++ colors are {transparency, red, green, blue}
+    std::array<unsigned char, 3> rgb(const std::array<float, 4> &color) {
+        auto channel = [](float v) {
+            return static_cast<unsigned char>(
+                std::lround(std::clamp(v, 0.f, 1.f) * 255.f));
+        };
+        return {channel(color[1]), channel(color[2]), channel(color[3])};
+    }
+
+    float opacity(const std::array<float, 4> &color) {
+        return std::clamp(1.f - color[0], 0.f, 1.f);
+    }
+
+    /// Pixel coordinates, far outside the image if the value is huge,
+    /// so CImg can clip them without overflowing
+    /// Callers skip non-finite values. NaN has no pixel, so we also
+    /// put it outside the image rather than rounding it.
+    int pixel(double v) {
+        constexpr double limit = 1e6;
+        if (std::isnan(v)) {
+            return -static_cast<int>(limit);
+        }
+        return static_cast<int>(std::lround(std::clamp(v, -limit, limit)));
+    }
+
+    /// Fill triangles given as x1, y1, x2, y2, x3, y3 image coordinates
+    ///
+    /// Translucent triangles that share an edge would blend the
+    /// edge twice, so we rasterize them into a mask and blend the
+    /// color once per pixel.
+    void fill_triangles(image_t &image, const std::vector<int> &corners,
+                        const std::array<float, 4> &color) {
+        const auto c = rgb(color);
+        const float alpha = opacity(color);
+        const size_t n = corners.size() / 6 * 6;
+        if (alpha >= 1.f) {
+            for (size_t i = 0; i < n; i += 6) {
+                image.draw_triangle(corners[i], corners[i + 1], corners[i + 2],
+                                    corners[i + 3], corners[i + 4],
+                                    corners[i + 5], c.data());
+            }
+            return;
+        }
+        if (alpha <= 0.f || n == 0) {
+            return;
+        }
+        image_t mask(image.width(), image.height(), 1, 1, 0);
+        const unsigned char covered = 1;
+        for (size_t i = 0; i < n; i += 6) {
+            mask.draw_triangle(corners[i], corners[i + 1], corners[i + 2],
+                               corners[i + 3], corners[i + 4], corners[i + 5],
+                               &covered);
+        }
+        cimg_forXY(mask, x, y) {
+            if (mask(x, y)) {
+                for (int k = 0; k < 3; ++k) {
+                    unsigned char &v = image(x, y, 0, k);
+                    v = static_cast<unsigned char>(
+                        std::lround(v * (1.f - alpha) + c[k] * alpha));
+                }
+            }
+        }
+    }
+
+    /// Draw the corners, as x1, y1, x2, y2, ... image coordinates,
+    /// as primitives of the given type
+    void draw_corners(image_t &image, vertex_batch::primitive type,
+                      const std::vector<int> &corners,
+                      const std::array<float, 4> &color) {
+        using primitive = vertex_batch::primitive;
+        const auto c = rgb(color);
+        const float alpha = opacity(color);
+        switch (type) {
+        case primitive::lines:
+            for (size_t i = 0; i + 3 < corners.size(); i += 4) {
+                image.draw_line(corners[i], corners[i + 1], corners[i + 2],
+                                corners[i + 3], c.data(), alpha);
+            }
+            break;
+        case primitive::triangles:
+            fill_triangles(image, corners, color);
+            break;
+        case primitive::points:
+            for (size_t i = 0; i + 1 < corners.size(); i += 2) {
+                image.draw_point(corners[i], corners[i + 1], c.data(), alpha);
+            }
+            break;
+        case primitive::glyphs:
+            // Glyphs have no corners
+            break;
+        }
+    }
+
+    /// Draw the glyphs of a glyph command
+    ///
+    /// Each glyph is a parallelogram. We map the center of each
+    /// pixel it covers back to the atlas and blend the color with
+    /// the coverage of the nearest atlas pixel.
+    void draw_glyphs(image_t &image, double height, const vertex_batch &batch,
+                     const vertex_batch::command &command) {
+        if (command.atlas == nullptr) {
+            return;
+        }
+        const auto &atlas = *command.atlas;
+        const std::vector<unsigned char> &coverage = atlas.pixels();
+        const auto c = rgb(command.color);
+        const float alpha = opacity(command.color);
+        constexpr size_t stride = vertex_batch::glyph_vertex_size;
+        const float *v = batch.glyph_vertices().data() +
+                         command.first_index * stride;
+        for (size_t i = 0; i + 6 <= command.n_indices;
+             i += 6, v += 6 * stride) {
+            // Bottom left, bottom right and top left corners
+            const float *p0 = v;
+            const float *p1 = v + stride;
+            const float *p3 = v + 5 * stride;
+            const double e1x = p1[0] - p0[0];
+            const double e1y = p1[1] - p0[1];
+            const double e2x = p3[0] - p0[0];
+            const double e2y = p3[1] - p0[1];
+            const double det = e1x * e2y - e1y * e2x;
+            if (det == 0.) {
+                continue;
+            }
+            // Image rows covered by the glyph
+            const double xs[4] = {p0[0], p1[0], p3[0], p1[0] + e2x};
+            const double ys[4] = {p0[1], p1[1], p3[1], p1[1] + e2y};
+            const auto [x_min, x_max] = std::minmax_element(xs, xs + 4);
+            const auto [y_min, y_max] = std::minmax_element(ys, ys + 4);
+            const int i0 = std::max(pixel(std::floor(*x_min)), 0);
+            const int i1 = std::min(pixel(std::ceil(*x_max)), image.width());
+            const int j0 = std::max(pixel(std::floor(height - *y_max)), 0);
+            const int j1 = std::min(pixel(std::ceil(height - *y_min)),
+                                    image.height());
+            for (int j = j0; j < j1; ++j) {
+                for (int k = i0; k < i1; ++k) {
+                    // Coordinates of the pixel center on the glyph edges
+                    const double dx = k + 0.5 - p0[0];
+                    const double dy = height - (j + 0.5) - p0[1];
+                    const double s = (dx * e2y - dy * e2x) / det;
+                    const double t = (e1x * dy - e1y * dx) / det;
+                    if (s < 0. || s >= 1. || t < 0. || t >= 1.) {
+                        continue;
+                    }
+                    const double u = p0[2] + s * (p1[2] - p0[2]);
+                    const double w = p0[3] + t * (p3[3] - p0[3]);
+                    const auto ax = std::min(
+                        static_cast<unsigned>(u * atlas.width()),
+                        atlas.width() - 1);
+                    const auto ay = std::min(
+                        static_cast<unsigned>(w * atlas.height()),
+                        atlas.height() - 1);
+                    const float a =
+                        alpha *
+                        coverage[static_cast<size_t>(ay) * atlas.width() + ax] /
+                        255.f;
+                    if (a <= 0.f) {
+                        continue;
+                    }
+                    for (int ch = 0; ch < 3; ++ch) {
+                        unsigned char &value = image(k, j, 0, ch);
+                        value = static_cast<unsigned char>(
+                            std::lround(value * (1.f - a) + c[ch] * a));
+                    }
+                }
+            }
+        }
+    }
+
+    /// Draw each instance of an instanced command
+    void draw_instances(image_t &image, double height,
+                        const vertex_batch &batch,
+                        const vertex_batch::command &command) {
+        const std::vector<float> &v = batch.vertices();
+        const uint32_t *first = batch.indices().data() + command.first_index;
+        const uint32_t *last = first + command.n_indices;
+        const float *instance = batch.instances().data() +
+                                command.first_instance *
+                                    vertex_batch::instance_size;
+        std::vector<int> corners;
+        for (size_t i = 0; i < command.n_instances;
+             ++i, instance += vertex_batch::instance_size) {
+            const double x = instance[0];
+            const double y = instance[1];
+            const double scale = instance[2];
+            for (const uint32_t *j = first; j < last; ++j) {
+                corners.emplace_back(pixel(x + scale * v[2 * *j]));
+                corners.emplace_back(
+                    pixel(height - (y + scale * v[2 * *j + 1])));
+            }
+            // Draw each run of instances with the same color at once
+            const float *next = instance + vertex_batch::instance_size;
+            if (i + 1 == command.n_instances ||
+                !std::equal(instance + 3, instance + 7, next + 3)) {
+                draw_corners(image, command.type, corners,
+                             {instance[3], instance[4], instance[5],
+                              instance[6]});
+                corners.clear();
+            }
+        }
+    }
+} // namespace
+
+namespace matplot::backend {
+    cimg_raster::cimg_raster() { resize_pixels(); }
+
+    bool cimg_raster::is_interactive() { return false; }
+
+    const std::string &cimg_raster::output() { return output_; }
+
+    const std::string &cimg_raster::output_format() { return format_; }
+
+    bool cimg_raster::output(const std::string &filename) {
+        return output(filename, "");
+    }
+
+    bool cimg_raster::output(const std::string &filename,
+                             const std::string &file_format) {
+        if (filename.empty()) {
+            output_.clear();
+            format_.clear();
+            return true;
+        }
+        return output_file(filename, file_format, "cimg_raster", output_,
+                           format_);
+    }
+
+    unsigned int cimg_raster::width() { return width_; }
+
+    unsigned int cimg_raster::height() { return height_; }
+
+    void cimg_raster::width(unsigned int new_width) {
+        width_ = std::max(new_width, 1u);
+    }
+
+    void cimg_raster::height(unsigned int new_height) {
+        height_ = std::max(new_height, 1u);
+    }
+
+    void cimg_raster::new_frame() {
+        resize_pixels();
+        std::fill(pixels_.begin(), pixels_.end(), 255);
+    }
+
+    bool cimg_raster::render_data() {
+        if (output_.empty()) {
+            // The frame stays in memory, in pixels()
+            return true;
+        }
+        return save(pixels_.data(), width_, height_, output_, format_);
+    }
+
+    void cimg_raster::wait() {
+        // There is no window to wait for
+    }
+
+    bool cimg_raster::supports_fonts() { return false; }
+
+    void cimg_raster::draw_background(const std::array<float, 4> &color) {
+        new_frame();
+        draw_rectangle(0., width_, 0., height_, color);
+    }
+
+    void cimg_raster::draw_rectangle(const double x1, const double x2,
+                                     const double y1, const double y2,
+                                     const std::array<float, 4> &color) {
+        if (!std::isfinite(x1) || !std::isfinite(x2) ||
+            !std::isfinite(y1) || !std::isfinite(y2)) {
+            return;
+        }
+        // Our y axis goes up, but the rows of the image go down
+        image_t image(pixels_.data(), width_, height_, 1, 3, true);
+        const auto c = rgb(color);
+        image.draw_rectangle(pixel(x1), pixel(height_ - y1), pixel(x2),
+                             pixel(height_ - y2), c.data(), opacity(color));
+    }
+
+    void cimg_raster::draw_path(const std::vector<double> &x,
+                                const std::vector<double> &y,
+                                const std::array<float, 4> &color) {
+        image_t image(pixels_.data(), width_, height_, 1, 3, true);
+        const auto c = rgb(color);
+        const float alpha = opacity(color);
+        const size_t n = std::min(x.size(), y.size());
+        for (size_t i = 1; i < n; ++i) {
+            // Missing values break the path
+            if (!std::isfinite(x[i - 1]) || !std::isfinite(y[i - 1]) ||
+                !std::isfinite(x[i]) || !std::isfinite(y[i])) {
+                continue;
+            }
+            image.draw_line(pixel(x[i - 1]), pixel(height_ - y[i - 1]),
+                            pixel(x[i]), pixel(height_ - y[i]), c.data(),
+                            alpha);
+        }
+    }
+
+    void cimg_raster::draw_triangles(const std::vector<double> &x,
+                                     const std::vector<double> &y,
+                                     const std::array<float, 4> &color) {
+        image_t image(pixels_.data(), width_, height_, 1, 3, true);
+        const size_t n = std::min(x.size(), y.size()) / 3 * 3;
+        std::vector<int> corners;
+        corners.reserve(2 * n);
+        for (size_t i = 0; i < n; i += 3) {
+            // Triangles with missing corners are not drawn
+            bool finite = true;
+            for (size_t j = i; j < i + 3; ++j) {
+                finite = finite && std::isfinite(x[j]) && std::isfinite(y[j]);
+            }
+            if (!finite) {
+                continue;
+            }
+            for (size_t j = i; j < i + 3; ++j) {
+                corners.emplace_back(pixel(x[j]));
+                corners.emplace_back(pixel(height_ - y[j]));
+            }
+        }
+        fill_triangles(image, corners, color);
+    }
+
+    void cimg_raster::draw_text(const std::string &text, double x, double y,
+                                const std::string &, float font_size,
+                                const std::array<float, 4> &color,
+                                float angle) {
+        // The atlas has a single font
+        vertex_batch batch;
+        batch.add_text(glyph_atlas::shared(static_cast<unsigned int>(
+                           std::lround(font_size))),
+                       text, x, y, angle, color);
+        draw_batch(batch);
+    }
+
+    bool cimg_raster::supports_vertex_batch() { return true; }
+
+    void cimg_raster::draw_batch(const vertex_batch &batch) {
+        image_t image(pixels_.data(), width_, height_, 1, 3, true);
+        const std::vector<float> &v = batch.vertices();
+        const std::vector<uint32_t> &indices = batch.indices();
+        auto px = [&](uint32_t i) { return pixel(v[2 * i]); };
+        auto py = [&](uint32_t i) { return pixel(height_ - v[2 * i + 1]); };
+        std::vector<int> corners;
+        for (const auto &command : batch.commands()) {
+            if (command.n_instances != 0) {
+                draw_instances(image, height_, batch, command);
+                continue;
+            }
+            if (command.type == vertex_batch::primitive::glyphs) {
+                draw_glyphs(image, height_, batch, command);
+                continue;
+            }
+            const uint32_t *first = indices.data() + command.first_index;
+            const uint32_t *last = first + command.n_indices;
+            corners.clear();
+            for (const uint32_t *i = first; i < last; ++i) {
+                corners.emplace_back(px(*i));
+                corners.emplace_back(py(*i));
+            }
+            draw_corners(image, command.type, corners, command.color);
+        }
+    }
+
+    const std::vector<unsigned char> &cimg_raster::pixels() const {
+        return pixels_;
+    }
+
+    bool cimg_raster::output_file(const std::string &filename,
+                                  const std::string &file_format,
+                                  const std::string &backend_name,
+                                  std::string &output,
+                                  std::string &output_format) {
+        constexpr auto exts = extension_format();
+        auto it = exts.end();
+        if (file_format.empty()) {
+            std::string ext =
+                std::filesystem::path(filename).extension().string();
+            it = std::find_if(exts.begin(), exts.end(), [&](const auto &e) {
+                return iequals(std::string(e.first), ext);
+            });
+            if (it == exts.end()) {
+                std::cerr << "The " << backend_name << " backend cannot save "
+                          << ext << " files" << std::endl;
+                return false;
+            }
+        } else {
+            it = std::find_if(exts.begin(), exts.end(), [&](const auto &e) {
+                return e.second == file_format;
+            });
+            if (it == exts.end()) {
+                std::cerr << file_format << " format does not exist for the "
+                          << backend_name << " backend" << std::endl;
+                return false;
+            }
+        }
+
+        // Create the directory if it does not exist
+        namespace fs = std::filesystem;
+        fs::path p{filename};
+        if (!p.parent_path().empty() && !fs::exists(p.parent_path())) {
+            std::error_code ec;
+            fs::create_directories(p.parent_path(), ec);
+            if (ec) {
+                std::cerr << "Could not find or create " << p.parent_path()
+                          << std::endl;
+                return false;
+            }
+        }
+
+        output = filename;
+        output_format = std::string(it->second);
+
+        // Append extension if needed
+        if (p.extension().empty()) {
+            output += it->first;
+        }
+        return true;
+    }
+
+    bool cimg_raster::save(const unsigned char *pixels, unsigned int width,
+                           unsigned int height, const std::string &filename,
+                           const std::string &file_format) {
+        // CImg does not change the pixels of a shared image when saving
+        const image_t image(pixels, width, height, 1, 3, true);
+        try {
+            if (file_format == "png") {
+                image.save_png(filename.c_str());
+            } else if (file_format == "bmp") {
+                image.save_bmp(filename.c_str());
+            } else if (file_format == "jpeg") {
+                image.save_jpeg(filename.c_str());
+            } else if (file_format == "tiff") {
+                image.save_tiff(filename.c_str());
+            } else {
+                image.save_pnm(filename.c_str());
+            }
+        } catch (const cimg_library::CImgException &e) {
+            std::cerr << "Could not save " << filename << ": " << e.what()
+                      << std::endl;
+            return false;
+        }
+        return true;
+    }
+
+    void cimg_raster::resize_pixels() {
+        const size_t n = static_cast<size_t>(width_) * height_ * 3;
+        if (pixels_.size() != n) {
+            pixels_.assign(n, 255);
+        }
+    }
+} // namespace matplot::backend
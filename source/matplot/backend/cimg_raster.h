@@ -0,0 +1,123 @@
+#ifndef MATPLOTPLUSPLUS_CIMG_RASTER_H
+#define MATPLOTPLUSPLUS_CIMG_RASTER_H
+
+#include <array>
+#include <matplot/backend/backend_interface.h>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+namespace matplot::backend {
+    /// \class cimg_raster
+    /// A non-interactive backend that rasterizes the figure in memory
+    ///
+    /// This backend consumes vertices rather than gnuplot commands and
+    /// draws them into an RGB image with CImg, which is already bundled
+    /// with Matplot++. There is no external process, pipe, or text to
+    /// parse, so figures can be exported from headless servers without
+    /// gnuplot.
+    ///
+    /// The image is saved to the output file at the end of each frame.
+    /// PPM and BMP files are always supported. PNG, JPEG and TIFF
+    /// files need the libraries CImg uses for them.
+    ///
+    /// Like the other backends based on vertices, this backend can
+    /// only draw what the axes objects tessellate.
+    class cimg_raster : public backend_interface {
+      public:
+        cimg_raster();
+
+      public:
+        bool is_interactive() override;
+        const std::string &output() override;
+        const std::string &output_format() override;
+        bool output(const std::string &filename) override;
+        bool output(const std::string &filename,
+                    const std::string &file_format) override;
+        unsigned int width() override;
+        unsigned int height() override;
+        void width(unsigned int new_width) override;
+        void height(unsigned int new_height) override;
+        void new_frame() override;
+        bool render_data() override;
+        void wait() override;
+        bool supports_fonts() override;
+
+      public:
+        void draw_background(const std::array<float, 4> &color) override;
+        void draw_rectangle(const double x1, const double x2,
+                            const double y1, const double y2,
+                            const std::array<float, 4> &color) override;
+        void draw_path(const std::vector<double> &x,
+                       const std::vector<double> &y,
+                       const std::array<float, 4> &color) override;
+        void draw_triangles(const std::vector<double> &x,
+                            const std::vector<double> &y,
+                            const std::array<float, 4> &color) override;
+        void draw_text(const std::string &text, double x, double y,
+                       const std::string &font, float font_size,
+                       const std::array<float, 4> &color,
+                       float angle = 0.f) override;
+        bool supports_vertex_batch() override;
+        void draw_batch(const vertex_batch &batch) override;
+
+      public:
+        /// \brief Pixels of the current frame
+        /// The red, green and blue channels come one after the other.
+        /// Each channel has height() rows of width() pixels, from the
+        /// top of the image.
+        const std::vector<unsigned char> &pixels() const;
+
+        /// \brief Save pixels in the same layout as pixels() to a file
+        /// The format should be one of the formats in extension_format().
+        static bool save(const unsigned char *pixels, unsigned int width,
+                         unsigned int height, const std::string &filename,
+                         const std::string &file_format);
+
+        /// \brief Check a file we are going to save() to
+        /// If the format is empty, it comes from the extension of the
+        /// file. This creates the directory of the file and sets the
+        /// output file, with the extension of the format if it has
+        /// none, and the output format.
+        /// \return False, after printing why, if we cannot save it
+        static bool output_file(const std::string &filename,
+                                const std::string &file_format,
+                                const std::string &backend_name,
+                                std::string &output,
+                                std::string &output_format);
+
+        static constexpr unsigned int default_width = 560;
+        static constexpr unsigned int default_height = 420;
+
+        /// File extensions and the formats we can save
+        static constexpr std::array<
+            std::pair<std::string_view, std::string_view>, 8>
+        extension_format() {
+            return std::array<std::pair<std::string_view, std::string_view>,
+                              8>{
+                std::pair{".png", "png"},  std::pair{".ppm", "ppm"},
+                std::pair{".pnm", "pnm"},  std::pair{".bmp", "bmp"},
+                std::pair{".jpg", "jpeg"}, std::pair{".jpeg", "jpeg"},
+                std::pair{".tif", "tiff"}, std::pair{".tiff", "tiff"}};
+        }
+
+      private:
+        /// Allocate the pixels if the size changed
+        void resize_pixels();
+
+      private:
+        // Channels of the image, one after the other
+        std::vector<unsigned char> pixels_;
+
+        // Size of the image
+        unsigned int width_{default_width};
+        unsigned int height_{default_height};
+
+        // File we save the image to and its format
+        std::string output_;
+        std::string format_;
+    };
+} // namespace matplot::backend
+
+#endif // MATPLOTPLUSPLUS_CIMG_RASTER_H
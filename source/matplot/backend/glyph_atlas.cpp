@@ -0,0 +1,126 @@
+#include "glyph_atlas.h"
+#include <algorithm>
+#include <map>
+#include <memory>
+#include <mutex>
+
+#include <CImg.h>
+
+namespace matplot::backend {
+    glyph_atlas::glyph_atlas(unsigned int font_height)
+        : font_height_(std::max(font_height, 1u)), glyphs_(256) {
+        // CImg keeps a small cache of fonts and might replace
+        // the one we get, so we copy the glyphs right away.
+        // The masks of the characters come after their colors.
+        using font_t = cimg_library::CImgList<unsigned char>;
+        static std::mutex font_mutex;
+        std::lock_guard<std::mutex> lock(font_mutex);
+        const font_t &font = font_t::font(font_height_, true);
+
+        // Pack the glyphs in rows, with a pixel between them,
+        // so that sampling one glyph never reaches another
+        constexpr unsigned int max_width = 1024;
+        constexpr unsigned int padding = 1;
+        unsigned int x = padding;
+        unsigned int y = padding;
+        unsigned int row_height = 0;
+        for (unsigned int c = 0; c < 256; ++c) {
+            const auto &mask = font[256 + c];
+            glyph &g = glyphs_[c];
+            g.width = mask.width();
+            g.height = mask.height();
+            if (x + g.width + padding > max_width) {
+                x = padding;
+                y += row_height + padding;
+                row_height = 0;
+            }
+            g.x = x;
+            g.y = y;
+            x += g.width + padding;
+            row_height = std::max(row_height, g.height);
+            width_ = std::max(width_, x);
+        }
+        height_ = y + row_height + padding;
+
+        pixels_.assign(static_cast<size_t>(width_) * height_, 0);
+        for (unsigned int c = 0; c < 256; ++c) {
+            const auto &mask = font[256 + c];
+            const glyph &g = glyphs_[c];
+            for (unsigned int j = 0; j < g.height; ++j) {
+                for (unsigned int i = 0; i < g.width; ++i) {
+                    pixels_[static_cast<size_t>(g.y + j) * width_ + g.x + i] =
+                        mask(i, j);
+                }
+            }
+        }
+    }
+
+    const glyph_atlas &glyph_atlas::shared(unsigned int font_height) {
+        static std::mutex atlases_mutex;
+        static std::map<unsigned int, std::unique_ptr<glyph_atlas>> atlases;
+        std::lock_guard<std::mutex> lock(atlases_mutex);
+        auto &atlas = atlases[font_height];
+        if (!atlas) {
+            atlas = std::make_unique<glyph_atlas>(font_height);
+        }
+        return *atlas;
+    }
+
+    unsigned int glyph_atlas::font_height() const { return font_height_; }
+
+    const glyph_atlas::glyph &
+    glyph_atlas::glyph_for(uint32_t code_point) const {
+        return code_point < glyphs_.size() ? glyphs_[code_point]
+                                           : glyphs_['?'];
+    }
+
+    unsigned int glyph_atlas::text_width(const std::string &text) const {
+        unsigned int width = 0;
+        for (uint32_t code_point : code_points(text)) {
+            width += glyph_for(code_point).width;
+        }
+        return width;
+    }
+
+    unsigned int glyph_atlas::width() const { return width_; }
+
+    unsigned int glyph_atlas::height() const { return height_; }
+
+    const std::vector<unsigned char> &glyph_atlas::pixels() const {
+        return pixels_;
+    }
+
+    std::vector<uint32_t> glyph_atlas::code_points(const std::string &text) {
+        std::vector<uint32_t> result;
+        result.reserve(text.size());
+        for (size_t i = 0; i < text.size();) {
+            const auto byte = static_cast<unsigned char>(text[i]);
+            // Number of continuation bytes and the bits of the lead byte
+            size_t n = 0;
+            uint32_t code_point = byte;
+            bool valid = true;
+            if ((byte & 0xE0) == 0xC0) {
+                n = 1;
+                code_point = byte & 0x1F;
+            } else if ((byte & 0xF0) == 0xE0) {
+                n = 2;
+                code_point = byte & 0x0F;
+            } else if ((byte & 0xF8) == 0xF0) {
+                n = 3;
+                code_point = byte & 0x07;
+            } else {
+                valid = byte < 0x80;
+            }
+            for (size_t j = 1; valid && j <= n; ++j) {
+                const auto next = i + j < text.size()
+                                      ? static_cast<unsigned char>(text[i + j])
+                                      : 0;
+                valid = (next & 0xC0) == 0x80;
+                code_point = (code_point << 6) | (next & 0x3F);
+            }
+            result.emplace_back(valid ? code_point : '?');
+            i += valid ? n + 1 : 1;
+        }
+        return result;
+    }
+} // namespace matplot::backend
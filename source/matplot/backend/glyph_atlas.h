@@ -0,0 +1,70 @@
+#ifndef MATPLOTPLUSPLUS_GLYPH_ATLAS_H
+#define MATPLOTPLUSPLUS_GLYPH_ATLAS_H
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace matplot::backend {
+    /// \class glyph_atlas
+    /// The glyphs of a font, rasterized once into a single image
+    ///
+    /// Backends based on vertices draw text as one textured quad
+    /// per glyph. Rasterizing a glyph is much more expensive than
+    /// drawing a quad, so each glyph is rasterized only once, when
+    /// the atlas is created, and all text of that size reuses it.
+    /// GPU backends upload the atlas as a single texture.
+    ///
+    /// The glyphs come from the bitmap font bundled with CImg, which
+    /// covers Latin-1. Other characters are drawn as '?'.
+    class glyph_atlas {
+      public:
+        /// Where a glyph is in the atlas, in pixels
+        struct glyph {
+            unsigned int x{0};
+            unsigned int y{0};
+            unsigned int width{0};
+            unsigned int height{0};
+        };
+
+      public:
+        /// \brief Rasterize the glyphs with a line height in pixels
+        explicit glyph_atlas(unsigned int font_height);
+
+        /// \brief The atlas for a line height, created on first use
+        /// Atlases are never destroyed, so the reference can be kept.
+        /// This function can be called from any thread.
+        static const glyph_atlas &shared(unsigned int font_height);
+
+        /// \brief Height of a line in pixels
+        unsigned int font_height() const;
+
+        /// \brief Glyph of a Unicode code point
+        const glyph &glyph_for(uint32_t code_point) const;
+
+        /// \brief Width of a text in pixels
+        unsigned int text_width(const std::string &text) const;
+
+        /// \brief Size of the atlas image in pixels
+        unsigned int width() const;
+        unsigned int height() const;
+
+        /// \brief Coverage of the pixels, from 0 to 255
+        /// There are height() rows of width() pixels, from the top.
+        const std::vector<unsigned char> &pixels() const;
+
+        /// \brief Code points of a UTF-8 string
+        /// Invalid bytes become '?'.
+        static std::vector<uint32_t> code_points(const std::string &text);
+
+      private:
+        unsigned int font_height_;
+        unsigned int width_{0};
+        unsigned int height_{0};
+        // Glyphs of the Latin-1 code points
+        std::vector<glyph> glyphs_;
+        std::vector<unsigned char> pixels_;
+    };
+} // namespace matplot::backend
+
+#endif // MATPLOTPLUSPLUS_GLYPH_ATLAS_H
@@ -3,12 +3,18 @@
 //
 
 #include "gnuplot.h"
+#include <algorithm>
 #include <filesystem>
+#include <fstream>
 #include <iostream>
 #include <matplot/util/common.h>
 #include <matplot/util/popen.h>
+#include <memory>
+#include <mutex>
+#include <random>
 #include <regex>
 #include <thread>
+#include <vector>
 
 #ifdef MATPLOT_HAS_FBUFSIZE
 
@@ -27,25 +33,87 @@ static size_t gnuplot_pipe_capacity(FILE *) {
 
 #endif // MATPLOT_HAS_FBUFSIZE
 
+static FILE *open_gnuplot_pipe() {
+    FILE *pipe;
+    if constexpr (matplot::backend::gnuplot::
+                      windows_should_persist_by_default) {
+        pipe = POPEN("gnuplot --persist", "w");
+    } else {
+        pipe = POPEN("gnuplot", "w");
+    }
+    if (!pipe) {
+        std::cerr << "Opening the gnuplot pipe_ failed!" << std::endl;
+    }
+    return pipe;
+}
+
+namespace {
+    /// A long-lived gnuplot process many backends send frames to
+    /// The process is closed when nobody uses it anymore, which waits
+    /// until gnuplot renders all frames we sent.
+    struct shared_gnuplot_process {
+        FILE *pipe{open_gnuplot_pipe()};
+        std::mutex mutex;
+
+        ~shared_gnuplot_process() {
+            if (pipe) {
+                fputs("exit\n", pipe);
+                PCLOSE(pipe);
+            }
+        }
+    };
+
+    struct shared_gnuplot_process_pool {
+        std::mutex mutex;
+        size_t size{0};
+        std::vector<std::shared_ptr<shared_gnuplot_process>> processes;
+        size_t next{0};
+    };
+
+    shared_gnuplot_process_pool &process_pool() {
+        static shared_gnuplot_process_pool pool;
+        return pool;
+    }
+
+    /// True if the first command of a frame, after the comments, is
+    /// reset. These frames do not depend on the frames before them.
+    bool frame_starts_with_reset(const std::string &frame) {
+        size_t pos = 0;
+        while (pos < frame.size() && frame[pos] == '#') {
+            pos = frame.find('\n', pos);
+            if (pos == std::string::npos) {
+                return false;
+            }
+            ++pos;
+        }
+        return frame.compare(pos, 6, "reset\n") == 0;
+    }
+} // namespace
+
 namespace matplot::backend {
     bool gnuplot::consumes_gnuplot_commands() { return true; }
 
     gnuplot::gnuplot() {
         // List terminal types
         terminal_ = default_terminal_type();
-        // Open the gnuplot pipe_
-        if constexpr (windows_should_persist_by_default) {
-            pipe_ = POPEN("gnuplot --persist", "w");
-        } else {
-            pipe_ = POPEN("gnuplot", "w");
+        // Unique prefix for the binary data files of this pipe
+        std::random_device rd;
+        std::stringstream ss;
+        ss << "matplot_" << std::hex << rd() << rd() << "_";
+        binary_data_file_prefix_ = ss.str();
+        // Open the gnuplot pipe_, unless we use the shared processes
+        shared_process_ = shared_processes() != 0;
+        if (!shared_process_) {
+            pipe_ = open_gnuplot_pipe();
         }
-        // Check if everything is OK
-        if (!pipe_) {
-            std::cerr << "Opening the gnuplot pipe_ failed!" << std::endl;
+        if constexpr (asynchronous_rendering_by_default) {
+            asynchronous_rendering(true);
         }
     }
 
     gnuplot::~gnuplot() {
+        // Send the queued frames and stop the render thread
+        asynchronous_rendering(false);
         if constexpr (dont_let_it_close_too_fast) {
             auto time_since_last_flush =
                 std::chrono::high_resolution_clock::now() - last_flush_;
@@ -54,11 +122,25 @@ namespace matplot::backend {
                                             time_since_last_flush);
             }
         }
+        if (shared_process_) {
+            // The shared processes outlive us. Commands we did not
+            // send yet are not part of any frame.
+            return;
+        }
         run_command("exit");
         flush_commands();
         if (pipe_) {
             PCLOSE(pipe_);
         }
+        // gnuplot is done with the data files now
+        std::error_code ec;
+        for (const auto &[key, file] : binary_data_files_in_use_) {
+            std::filesystem::remove(file.first, ec);
+        }
+        for (const auto &[frame, path] : retired_binary_data_files_) {
+            std::filesystem::remove(path, ec);
+        }
+        std::filesystem::remove(binary_data_frame_file(), ec);
     }
 
     bool gnuplot::is_interactive() { return output_.empty(); }
@@ -211,12 +293,34 @@ namespace matplot::backend {
         }
     }
 
-    bool gnuplot::render_data() { return flush_commands(); }
+    bool gnuplot::render_data() {
+        if (shared_process_ && !output_.empty()) {
+            // Close the file so it is complete once the process gets
+            // to the next frame, which might not be ours
+            run_command("unset output");
+        }
+        retire_unused_binary_data_files();
+        bool ok = flush_commands();
+        remove_retired_binary_data_files();
+        return ok;
+    }
 
     bool gnuplot::flush_commands() {
         if constexpr (dont_let_it_close_too_fast) {
             last_flush_ = std::chrono::high_resolution_clock::now();
         }
+        if (asynchronous_rendering_) {
+            queue_frame();
+            return true;
+        }
+        if (shared_process_) {
+            send_frame_to_shared_process(frame_);
+            frame_.clear();
+            return true;
+        }
+        if (!pipe_) {
+            return false;
+        }
         fputs("\n", pipe_);
         fflush(pipe_);
         if constexpr (trace_commands) {
@@ -230,6 +334,14 @@ namespace matplot::backend {
     }
 
     void gnuplot::run_command(const std::string &command) {
+        if (shared_process_ || asynchronous_rendering_) {
+            frame_ += command;
+            frame_ += '\n';
+            if constexpr (trace_commands) {
+                std::cout << command << std::endl;
+            }
+            return;
+        }
         if (!pipe_) {
             return;
         }
@@ -249,6 +361,314 @@ namespace matplot::backend {
         }
     }
 
+    bool gnuplot::binary_data() { return binary_data_; }
+
+    void gnuplot::binary_data(bool binary_data) { binary_data_ = binary_data; }
+
+    bool gnuplot::binary_data_single_precision() {
+        return binary_data_single_precision_;
+    }
+
+    void gnuplot::binary_data_single_precision(bool single_precision) {
+        binary_data_single_precision_ = single_precision;
+    }
+
+    int gnuplot::text_data_precision() { return text_data_precision_; }
+
+    void gnuplot::text_data_precision(int precision) {
+        text_data_precision_ = precision;
+    }
+
+    void gnuplot::run_binary_data(const std::string &data) {
+        if (shared_process_ || asynchronous_rendering_) {
+            frame_ += data;
+            return;
+        }
+        if (!pipe_) {
+            return;
+        }
+        // The records follow the plot command immediately, so we
+        // cannot use fputs or append a newline here
+        fwrite(data.data(), sizeof(char), data.size(), pipe_);
+        bytes_in_pipe_ += data.size();
+        if constexpr (trace_commands) {
+            std::cout << "    # " << data.size() << " bytes of binary data"
+                      << std::endl;
+        }
+    }
+
+    bool gnuplot::binary_data_files() {
+        return binary_data_files_ && !shared_process_ &&
+               !asynchronous_rendering_;
+    }
+
+    void gnuplot::binary_data_files(bool binary_data_files) {
+        binary_data_files_ = binary_data_files;
+    }
+
+    std::string gnuplot::write_binary_data_file(const std::string &key,
+                                                const std::string &data) {
+        namespace fs = std::filesystem;
+        // Each version of the data gets its own file. Frames we sent
+        // before might still be waiting in the pipe, and they have to
+        // find the data they were plotted with.
+        auto it = binary_data_files_in_use_.find(key);
+        if (it != binary_data_files_in_use_.end()) {
+            retired_binary_data_files_.emplace_back(binary_data_frame_,
+                                                    it->second.first);
+        }
+        std::string path =
+            (fs::path(binary_data_directory()) /
+             (binary_data_file_prefix_ + key + "_" +
+              std::to_string(++binary_data_file_counter_) + ".bin"))
+                .string();
+        std::ofstream fout(path, std::ios::binary | std::ios::trunc);
+        fout.write(data.data(), static_cast<std::streamsize>(data.size()));
+        fout.close();
+        if (!fout) {
+            std::cerr << "Could not write the binary data file " << path
+                      << std::endl;
+        }
+        binary_data_files_in_use_[key] = std::make_pair(path, true);
+        return path;
+    }
+
+    std::string gnuplot::binary_data_file(const std::string &key) {
+        auto it = binary_data_files_in_use_.find(key);
+        if (it == binary_data_files_in_use_.end()) {
+            return "";
+        }
+        it->second.second = true;
+        return it->second.first;
+    }
+
+    std::string gnuplot::binary_data_directory() {
+        namespace fs = std::filesystem;
+        // Static initialization is thread-safe, so figures can be
+        // created in parallel
+        static const std::string directory = [] {
+            // Prefer shared memory so the files never touch the disk
+            std::error_code ec;
+            if (fs::is_directory("/dev/shm", ec)) {
+                return std::string("/dev/shm");
+            }
+            return fs::temp_directory_path(ec).string();
+        }();
+        return directory;
+    }
+
+    std::string gnuplot::binary_data_frame_file() const {
+        return (std::filesystem::path(binary_data_directory()) /
+                (binary_data_file_prefix_ + "frame.txt"))
+            .string();
+    }
+
+    void gnuplot::retire_unused_binary_data_files() {
+        if (binary_data_files_in_use_.empty() &&
+            retired_binary_data_files_.empty()) {
+            return;
+        }
+        // Files that were not used in this frame belong to objects
+        // that do not exist or are not visible anymore
+        auto it = binary_data_files_in_use_.begin();
+        while (it != binary_data_files_in_use_.end()) {
+            if (!it->second.second) {
+                retired_binary_data_files_.emplace_back(binary_data_frame_,
+                                                        it->second.first);
+                it = binary_data_files_in_use_.erase(it);
+            } else {
+                it->second.second = false;
+                ++it;
+            }
+        }
+        // gnuplot tells us when it is done with this frame by writing
+        // its number to a file. Flushing the pipe only means gnuplot
+        // will get to the frame eventually.
+        run_command("set print \"" + escape(binary_data_frame_file()) +
+                    "\"");
+        run_command("print " + std::to_string(binary_data_frame_));
+        run_command("unset print");
+        ++binary_data_frame_;
+    }
+
+    void gnuplot::remove_retired_binary_data_files() {
+        if (retired_binary_data_files_.empty()) {
+            return;
+        }
+        // The file might be empty if gnuplot is writing it right now
+        std::ifstream fin(binary_data_frame_file());
+        size_t last_frame = 0;
+        if (!(fin >> last_frame)) {
+            return;
+        }
+        auto is_done = [&](const std::pair<size_t, std::string> &file) {
+            if (file.first > last_frame) {
+                return false;
+            }
+            std::error_code ec;
+            std::filesystem::remove(file.second, ec);
+            return true;
+        };
+        retired_binary_data_files_.erase(
+            std::remove_if(retired_binary_data_files_.begin(),
+                           retired_binary_data_files_.end(), is_done),
+            retired_binary_data_files_.end());
+    }
+
+    void gnuplot::shared_processes(size_t n) {
+        auto &pool = process_pool();
+        std::vector<std::shared_ptr<shared_gnuplot_process>> old_processes;
+        {
+            std::lock_guard<std::mutex> lock(pool.mutex);
+            pool.size = n;
+            old_processes.swap(pool.processes);
+        }
+        // The old processes close as soon as the backends using
+        // them are done sending their frames
+    }
+
+    size_t gnuplot::shared_processes() {
+        auto &pool = process_pool();
+        std::lock_guard<std::mutex> lock(pool.mutex);
+        return pool.size;
+    }
+
+    bool gnuplot::uses_shared_processes() const { return shared_process_; }
+
+    void gnuplot::send_frame_to_shared_process(const std::string &frame) {
+        if (frame.empty()) {
+            return;
+        }
+        auto &pool = process_pool();
+        std::vector<std::shared_ptr<shared_gnuplot_process>> processes;
+        size_t first = 0;
+        {
+            std::lock_guard<std::mutex> lock(pool.mutex);
+            if (pool.processes.empty()) {
+                // Open the processes when the first frame arrives
+                for (size_t i = 0; i < std::max<size_t>(pool.size, 1); ++i) {
+                    pool.processes.emplace_back(
+                        std::make_shared<shared_gnuplot_process>());
+                }
+            }
+            processes = pool.processes;
+            first = pool.next++ % processes.size();
+        }
+        // Prefer a process no other thread is writing to
+        std::unique_lock<std::mutex> lock;
+        std::shared_ptr<shared_gnuplot_process> process;
+        for (size_t i = 0; i < processes.size() && !process; ++i) {
+            auto &candidate = processes[(first + i) % processes.size()];
+            lock = std::unique_lock<std::mutex>(candidate->mutex,
+                                                std::try_to_lock);
+            if (lock.owns_lock()) {
+                process = candidate;
+            }
+        }
+        if (!process) {
+            process = processes[first];
+            lock = std::unique_lock<std::mutex>(process->mutex);
+        }
+        if (process->pipe) {
+            // gnuplot renders this frame while we prepare the next one
+            fwrite(frame.data(), sizeof(char), frame.size(), process->pipe);
+            fputs("\n", process->pipe);
+            fflush(process->pipe);
+        }
+    }
+
+    void gnuplot::asynchronous_rendering(bool asynchronous) {
+        if (asynchronous == asynchronous_rendering_) {
+            return;
+        }
+        if (asynchronous) {
+            stop_render_thread_ = false;
+            asynchronous_rendering_ = true;
+            render_thread_ = std::thread([this] { render_loop(); });
+            return;
+        }
+        {
+            std::lock_guard<std::mutex> lock(render_mutex_);
+            stop_render_thread_ = true;
+        }
+        render_condition_.notify_all();
+        render_thread_.join();
+        asynchronous_rendering_ = false;
+        // Commands that are not part of a frame yet go to the pipe now
+        if (!shared_process_ && pipe_ && !frame_.empty()) {
+            fwrite(frame_.data(), sizeof(char), frame_.size(), pipe_);
+            bytes_in_pipe_ += frame_.size();
+            frame_.clear();
+        }
+    }
+
+    bool gnuplot::asynchronous_rendering() const {
+        return asynchronous_rendering_;
+    }
+
+    void gnuplot::wait_for_queued_frames() {
+        std::unique_lock<std::mutex> lock(render_mutex_);
+        render_condition_.wait(lock, [this] {
+            return queued_frames_.empty() && !render_thread_busy_;
+        });
+    }
+
+    void gnuplot::queue_frame() {
+        if (frame_.empty()) {
+            return;
+        }
+        const bool writes_file = !output_.empty();
+        {
+            std::lock_guard<std::mutex> lock(render_mutex_);
+            if (!writes_file && frame_starts_with_reset(frame_)) {
+                // Coalesce: the interactive frames still waiting
+                // would be replaced by this one anyway
+                queued_frames_.erase(
+                    std::remove_if(queued_frames_.begin(),
+                                   queued_frames_.end(),
+                                   [](const auto &f) { return !f.second; }),
+                    queued_frames_.end());
+            }
+            queued_frames_.emplace_back(std::move(frame_), writes_file);
+        }
+        frame_.clear();
+        render_condition_.notify_all();
+    }
+
+    void gnuplot::render_loop() {
+        std::unique_lock<std::mutex> lock(render_mutex_);
+        while (true) {
+            render_condition_.wait(lock, [this] {
+                return stop_render_thread_ || !queued_frames_.empty();
+            });
+            if (queued_frames_.empty()) {
+                return;
+            }
+            std::string frame = std::move(queued_frames_.front().first);
+            queued_frames_.pop_front();
+            render_thread_busy_ = true;
+            lock.unlock();
+            // The caller keeps building frames while gnuplot reads this one
+            write_frame(frame);
+            lock.lock();
+            render_thread_busy_ = false;
+            render_condition_.notify_all();
+        }
+    }
+
+    void gnuplot::write_frame(const std::string &frame) {
+        if (shared_process_) {
+            send_frame_to_shared_process(frame);
+            return;
+        }
+        if (!pipe_) {
+            return;
+        }
+        fwrite(frame.data(), sizeof(char), frame.size(), pipe_);
+        fputs("\n", pipe_);
+        fflush(pipe_);
+    }
+
     void gnuplot::include_comment(const std::string &comment) {
         if (include_comments_) {
             run_command("# " + comment);
@@ -256,10 +676,10 @@ namespace matplot::backend {
     }
 
     std::string gnuplot::default_terminal_type() {
-        static std::string terminal_type;
-        const bool dont_know_term_type = terminal_type.empty();
-        if (dont_know_term_type) {
-            terminal_type =
+        // We only start a gnuplot process to ask for this once.
+        // Static initialization is thread-safe.
+        static const std::string terminal_type = [] {
+            std::string terminal_type =
                 run_and_get_output("gnuplot -e \"show terminal\" 2>&1");
             terminal_type = std::regex_replace(
                 terminal_type, std::regex("[^]*terminal type is ([^ ]+)[^]*"),
@@ -268,15 +688,16 @@ namespace matplot::backend {
             if (still_dont_know_term_type) {
                 terminal_type = "qt";
             }
-        }
+            return terminal_type;
+        }();
         return terminal_type;
     }
 
     std::pair<int, int> gnuplot::gnuplot_version() {
-        static std::pair<int, int> version{0, 0};
-        const bool dont_know_gnuplot_version =
-            version == std::pair<int, int>({0, 0});
-        if (dont_know_gnuplot_version) {
+        // We only start a gnuplot process to ask for this once.
+        // Static initialization is thread-safe.
+        static const std::pair<int, int> version = [] {
+            std::pair<int, int> version{0, 0};
             std::string version_str =
                 run_and_get_output("gnuplot --version 2>&1");
             std::string version_major = std::regex_replace(
@@ -302,7 +723,8 @@ namespace matplot::backend {
             if (still_dont_know_gnuplot_version) {
                 version = std::pair<int, int>({5, 2});
             }
-        }
+            return version;
+        }();
         return version;
     }
 
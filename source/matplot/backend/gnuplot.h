@@ -7,7 +7,13 @@
 
 #include <array>
 #include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <map>
 #include <matplot/backend/backend_interface.h>
+#include <mutex>
+#include <thread>
+#include <vector>
 
 #ifndef NDEBUG
 #define TRACE_GNUPLOT_COMMANDS
@@ -39,8 +45,102 @@ namespace matplot::backend {
       public:
         bool consumes_gnuplot_commands() override;
         void run_command(const std::string &command) override;
+        bool binary_data() override;
+        bool binary_data_single_precision() override;
+        int text_data_precision() override;
+        void run_binary_data(const std::string &data) override;
+        bool binary_data_files() override;
+        std::string write_binary_data_file(const std::string &key,
+                                           const std::string &data) override;
+        std::string binary_data_file(const std::string &key) override;
         void include_comment(const std::string &comment) override;
 
+      public /* binary data */:
+        /// Send data as inline binary records instead of text
+        void binary_data(bool binary_data);
+
+        /// Use float32 instead of float64 for the binary records
+        void binary_data_single_precision(bool single_precision);
+
+        /// Write binary data to files instead of sending it inline
+        /// The files go to /dev/shm, if available, or to the temporary
+        /// directory. Objects that did not change reuse their files.
+        void binary_data_files(bool binary_data_files);
+
+        /// Directory where we create the binary data files
+        static std::string binary_data_directory();
+
+        /// Significant digits of numbers in text data
+        /// Zero means the shortest round-trip representation.
+        void text_data_precision(int precision);
+
+      private:
+        /// File where gnuplot writes the last frame it plotted
+        std::string binary_data_frame_file() const;
+
+        /// Retire the data files nobody used in this frame and ask
+        /// gnuplot to confirm when it is done with the frame
+        void retire_unused_binary_data_files();
+
+        /// Remove the retired files of frames gnuplot is done with
+        void remove_retired_binary_data_files();
+
+      public /* shared gnuplot processes */:
+        /// Set the number of gnuplot processes shared by new backends
+        /// If zero (the default), each backend opens its own gnuplot
+        /// process. Otherwise, backends buffer each frame and send it
+        /// to one of these long-lived processes, so creating figures
+        /// does not start new processes and the processes render
+        /// frames in parallel. This is meant for exporting many
+        /// figures: figures on interactive terminals share windows, and
+        /// binary data files are not used because the backend cannot
+        /// know when gnuplot is done with them.
+        /// Changing the number of processes closes the current ones,
+        /// which waits until they render all pending frames.
+        static void shared_processes(size_t n);
+
+        /// Number of gnuplot processes shared by new backends
+        static size_t shared_processes();
+
+        /// True if this backend sends its frames to shared processes
+        bool uses_shared_processes() const;
+
+      private:
+        /// Send a frame to one of the shared processes
+        void send_frame_to_shared_process(const std::string &frame);
+
+      public /* asynchronous rendering */:
+        /// \brief Write frames to gnuplot on a render thread
+        /// The figure still builds the commands of each frame on the
+        /// calling thread, so the frame is a snapshot of the plot
+        /// state, but render_data() returns as soon as the frame is
+        /// queued. A slow gnuplot does not block the caller anymore.
+        /// Frames coalesce while the render thread is busy: a new
+        /// frame that redraws the whole figure for an interactive
+        /// terminal replaces the frames still waiting, so only the
+        /// newest one is sent. Frames that write files are never
+        /// dropped. Binary data files are not used in this mode
+        /// because a new frame could replace them while gnuplot is
+        /// reading them.
+        /// Turning this off waits until all queued frames are sent.
+        void asynchronous_rendering(bool asynchronous);
+
+        /// True if a render thread writes our frames to gnuplot
+        bool asynchronous_rendering() const;
+
+        /// Block until the render thread sent all queued frames
+        void wait_for_queued_frames();
+
+      private:
+        /// Give the buffered frame to the render thread
+        void queue_frame();
+
+        /// The render thread writes queued frames until we stop it
+        void render_loop();
+
+        /// Write a complete frame to our pipe or to a shared process
+        void write_frame(const std::string &frame);
+
       public /* gnuplot pipe functions */:
         /// We "render the data" by flushing the commands
         bool flush_commands();
@@ -73,6 +173,25 @@ namespace matplot::backend {
         // http://www.gnuplot.info/files/gpReadMouseTest.c
         static constexpr bool allow_using_mouse = true;
 
+        // True if objects should send their data as inline binary
+        // records by default. Binary data is much faster to send and
+        // parse than text, but the commands are not human-readable
+        // anymore.
+        static constexpr bool binary_data_by_default = false;
+
+        // True if binary data should go through files rather than
+        // the pipe by default
+        static constexpr bool binary_data_files_by_default = false;
+
+        // Significant digits of numbers in text data by default
+        // This is the precision of std::ostream. Use 0 for the
+        // shortest representation that parses back to the same number.
+        static constexpr int text_data_precision_by_default = 6;
+
+        // True if frames are written to gnuplot on a render thread
+        // by default
+        static constexpr bool asynchronous_rendering_by_default = false;
+
 #if defined(TRACE_GNUPLOT_COMMANDS) &&                                         \
     !defined(MATPLOT_BUILD_FOR_DOCUMENTATION_IMAGES)
         static constexpr bool trace_commands = false;
@@ -117,7 +236,34 @@ namespace matplot::backend {
 
       private:
         // Pipe to gnuplot process
-        FILE *pipe_;
+        FILE *pipe_{nullptr};
+
+        // Whether we send frames to the shared processes rather
+        // than to our own pipe
+        bool shared_process_{false};
+
+        // Commands of the current frame when using shared processes
+        // or asynchronous rendering
+        std::string frame_;
+
+        // Whether the render thread writes our frames
+        bool asynchronous_rendering_{false};
+
+        // Frames waiting for the render thread and whether
+        // each frame writes a file
+        std::deque<std::pair<std::string, bool>> queued_frames_;
+
+        // Whether the render thread is writing a frame
+        bool render_thread_busy_{false};
+
+        // Whether the render thread should stop after the
+        // queued frames
+        bool stop_render_thread_{false};
+
+        // Thread writing our frames and the state it shares with us
+        std::thread render_thread_;
+        std::mutex render_mutex_;
+        std::condition_variable render_condition_;
 
         // How many bytes we put in the pipe
         size_t bytes_in_pipe_{0};
@@ -136,6 +282,38 @@ namespace matplot::backend {
 
         // Whether we should include comments in the commands
         bool include_comments_ = trace_commands;
+
+        // Whether objects should send data as binary records
+        bool binary_data_ = binary_data_by_default;
+
+        // Whether binary records are float32 rather than float64
+        bool binary_data_single_precision_{false};
+
+        // Whether binary data goes through files
+        bool binary_data_files_ = binary_data_files_by_default;
+
+        // Significant digits of numbers in text data
+        int text_data_precision_ = text_data_precision_by_default;
+
+        // Binary data files for each key and whether each file
+        // was used in the current frame
+        std::map<std::string, std::pair<std::string, bool>>
+            binary_data_files_in_use_;
+
+        // Prefix that makes the name of our data files unique
+        std::string binary_data_file_prefix_;
+
+        // Number of data files we created, which makes each version
+        // of the data of an object a new file
+        size_t binary_data_file_counter_{0};
+
+        // Number of the frame we are sending
+        size_t binary_data_frame_{1};
+
+        // Files replaced or unused since the frame we retired them in.
+        // We remove them once gnuplot plotted this frame.
+        std::vector<std::pair<size_t, std::string>>
+            retired_binary_data_files_;
     };
 } // namespace matplot::backend
 
@@ -3,8 +3,13 @@
 //
 
 #include "opengl_3.h"
+#include <algorithm>
+#include <cmath>
 #include <iostream>
 #include <future>
+#include <matplot/backend/cimg_raster.h>
+#include <matplot/backend/glyph_atlas.h>
+#include <matplot/backend/vertex_batch.h>
 #include <matplot/util/common.h>
 #include <thread>
 
@@ -23,19 +28,6 @@ namespace matplot::backend {
             "   gl_Position = vec4((aPos.x/windowWidth)*2-1, (aPos.y/windowHeight)*2-1, 0.0, 1.0);"
             //"   vertexColor = aColor;\n"
             "}\0";
-        unsigned int draw_2d_single_color_vertex_shader;
-        draw_2d_single_color_vertex_shader = glCreateShader(GL_VERTEX_SHADER);
-        glShaderSource(draw_2d_single_color_vertex_shader, 1, &draw_2d_single_color_vertex_shader_source, NULL);
-        glCompileShader(draw_2d_single_color_vertex_shader);
-        int success;
-        char info_log[512];
-        glGetShaderiv(draw_2d_single_color_vertex_shader, GL_COMPILE_STATUS, &success);
-        if (!success) {
-            glGetShaderInfoLog(draw_2d_single_color_vertex_shader, 512, NULL, info_log);
-            throw std::runtime_error(
-                std::string("ERROR::SHADER::VERTEX::COMPILATION_FAILED\n") +
-                    info_log);
-        }
 
         // create and compile fragment shader
         const char *draw_2d_single_color_fragment_shader_source =
@@ -48,81 +40,213 @@ namespace matplot::backend {
             "{\n"
             "    FragColor = ourColor;\n"
             "}";
-        unsigned int draw_2d_single_color_fragment_shader;
-        draw_2d_single_color_fragment_shader = glCreateShader(GL_FRAGMENT_SHADER);
-        glShaderSource(draw_2d_single_color_fragment_shader, 1, &draw_2d_single_color_fragment_shader_source, NULL);
-        glCompileShader(draw_2d_single_color_fragment_shader);
-        glGetShaderiv(draw_2d_single_color_fragment_shader, GL_COMPILE_STATUS, &success);
+        draw_2d_single_color_shader_program_ =
+            create_shader_program(draw_2d_single_color_vertex_shader_source,
+                                  draw_2d_single_color_fragment_shader_source);
+
+        // Look up the uniforms once rather than on every draw call
+        window_height_location_ = glGetUniformLocation(draw_2d_single_color_shader_program_, "windowHeight");
+        window_width_location_ = glGetUniformLocation(draw_2d_single_color_shader_program_, "windowWidth");
+        color_location_ = glGetUniformLocation(draw_2d_single_color_shader_program_, "ourColor");
+        if (window_height_location_ == -1 || window_width_location_ == -1 || color_location_ == -1) {
+            throw std::runtime_error("can't find uniform location");
+        }
+
+        // Instanced shaders draw the same template, such as a marker,
+        // at many positions. Each instance has its position and scale
+        // in aInstance and its color, as {transparency, r, g, b},
+        // in aColor.
+        const char *draw_2d_instanced_vertex_shader_source =
+            "#version 330 core\n"
+            "layout (location = 0) in vec2 aPos;\n"
+            "layout (location = 1) in vec3 aInstance;\n"
+            "layout (location = 2) in vec4 aColor;\n"
+            "uniform float windowHeight;\n"
+            "uniform float windowWidth;\n"
+            "out vec4 vertexColor;\n"
+            "void main()\n"
+            "{\n"
+            "   vec2 p = aInstance.xy + aInstance.z * aPos;\n"
+            "   gl_Position = vec4((p.x/windowWidth)*2-1, (p.y/windowHeight)*2-1, 0.0, 1.0);\n"
+            "   vertexColor = vec4(aColor.yzw, 1.0 - aColor.x);\n"
+            "}";
+        const char *draw_2d_instanced_fragment_shader_source =
+            "#version 330 core\n"
+            "in vec4 vertexColor;\n"
+            "out vec4 FragColor;\n"
+            "void main()\n"
+            "{\n"
+            "    FragColor = vertexColor;\n"
+            "}";
+        draw_2d_instanced_shader_program_ =
+            create_shader_program(draw_2d_instanced_vertex_shader_source,
+                                  draw_2d_instanced_fragment_shader_source);
+        instanced_window_height_location_ = glGetUniformLocation(draw_2d_instanced_shader_program_, "windowHeight");
+        instanced_window_width_location_ = glGetUniformLocation(draw_2d_instanced_shader_program_, "windowWidth");
+        if (instanced_window_height_location_ == -1 || instanced_window_width_location_ == -1) {
+            throw std::runtime_error("can't find uniform location");
+        }
+
+        // Glyph shaders draw textured quads. The texture is the
+        // coverage of the glyphs, which becomes the alpha channel.
+        const char *draw_2d_glyph_vertex_shader_source =
+            "#version 330 core\n"
+            "layout (location = 0) in vec2 aPos;\n"
+            "layout (location = 1) in vec2 aTexCoord;\n"
+            "uniform float windowHeight;\n"
+            "uniform float windowWidth;\n"
+            "out vec2 texCoord;\n"
+            "void main()\n"
+            "{\n"
+            "   gl_Position = vec4((aPos.x/windowWidth)*2-1, (aPos.y/windowHeight)*2-1, 0.0, 1.0);\n"
+            "   texCoord = aTexCoord;\n"
+            "}";
+        const char *draw_2d_glyph_fragment_shader_source =
+            "#version 330 core\n"
+            "in vec2 texCoord;\n"
+            "out vec4 FragColor;\n"
+            "uniform sampler2D atlas;\n"
+            "uniform vec4 ourColor;\n"
+            "void main()\n"
+            "{\n"
+            "    FragColor = vec4(ourColor.rgb, ourColor.a * texture(atlas, texCoord).r);\n"
+            "}";
+        draw_2d_glyph_shader_program_ =
+            create_shader_program(draw_2d_glyph_vertex_shader_source,
+                                  draw_2d_glyph_fragment_shader_source);
+        glyph_window_height_location_ = glGetUniformLocation(draw_2d_glyph_shader_program_, "windowHeight");
+        glyph_window_width_location_ = glGetUniformLocation(draw_2d_glyph_shader_program_, "windowWidth");
+        glyph_color_location_ = glGetUniformLocation(draw_2d_glyph_shader_program_, "ourColor");
+        if (glyph_window_height_location_ == -1 || glyph_window_width_location_ == -1 || glyph_color_location_ == -1) {
+            throw std::runtime_error("can't find uniform location");
+        }
+
+        glGetIntegerv(GL_MAX_VERTEX_ATTRIBS, &n_vertex_attributes_available_);
+        std::cout << "Maximum number of vertex attributes supported: " << n_vertex_attributes_available_ << std::endl;
+    }
+
+    unsigned int opengl_3::create_shader_program(const char *vertex_shader_source,
+                                                 const char *fragment_shader_source) {
+        // create and compile vertex shader
+        unsigned int vertex_shader = glCreateShader(GL_VERTEX_SHADER);
+        glShaderSource(vertex_shader, 1, &vertex_shader_source, NULL);
+        glCompileShader(vertex_shader);
+        int success;
+        char info_log[512];
+        glGetShaderiv(vertex_shader, GL_COMPILE_STATUS, &success);
+        if (!success) {
+            glGetShaderInfoLog(vertex_shader, 512, NULL, info_log);
+            glDeleteShader(vertex_shader);
+            throw std::runtime_error(
+                std::string("ERROR::SHADER::VERTEX::COMPILATION_FAILED\n") +
+                    info_log);
+        }
+
+        // create and compile fragment shader
+        unsigned int fragment_shader = glCreateShader(GL_FRAGMENT_SHADER);
+        glShaderSource(fragment_shader, 1, &fragment_shader_source, NULL);
+        glCompileShader(fragment_shader);
+        glGetShaderiv(fragment_shader, GL_COMPILE_STATUS, &success);
         if (!success) {
-            glGetShaderInfoLog(draw_2d_single_color_fragment_shader, 512, NULL, info_log);
+            glGetShaderInfoLog(fragment_shader, 512, NULL, info_log);
+            glDeleteShader(vertex_shader);
+            glDeleteShader(fragment_shader);
             throw std::runtime_error(
                 std::string("ERROR::SHADER::FRAGMENT::COMPILATION_FAILED\n") +
                 info_log);
         }
 
         // Link shaders into shader program
-        draw_2d_single_color_shader_program_ = glCreateProgram();
-        glAttachShader(draw_2d_single_color_shader_program_, draw_2d_single_color_vertex_shader);
-        glAttachShader(draw_2d_single_color_shader_program_, draw_2d_single_color_fragment_shader);
-        glLinkProgram(draw_2d_single_color_shader_program_);
+        unsigned int program = glCreateProgram();
+        glAttachShader(program, vertex_shader);
+        glAttachShader(program, fragment_shader);
+        glLinkProgram(program);
+
+        // Delete the shader objects
+        glDeleteShader(vertex_shader);
+        glDeleteShader(fragment_shader);
+
         // check if linking was successful
-        glGetProgramiv(draw_2d_single_color_shader_program_, GL_LINK_STATUS, &success);
+        glGetProgramiv(program, GL_LINK_STATUS, &success);
         if (!success) {
-            glGetProgramInfoLog(draw_2d_single_color_shader_program_, 512, NULL, info_log);
+            glGetProgramInfoLog(program, 512, NULL, info_log);
+            glDeleteProgram(program);
             throw std::runtime_error(
                 std::string("ERROR::SHADER_PROGRAM::LINKING_FAILED\n") +
                 info_log);
         }
-
-        // Delete the shader objects
-        glDeleteShader(draw_2d_single_color_vertex_shader);
-        glDeleteShader(draw_2d_single_color_fragment_shader);
-
-        glGetIntegerv(GL_MAX_VERTEX_ATTRIBS, &n_vertex_attributes_available_);
-        std::cout << "Maximum number of vertex attributes supported: " << n_vertex_attributes_available_ << std::endl;
+        return program;
     }
 
     opengl_3::~opengl_3() {
+        if (batch_vao_ != 0) {
+            glDeleteVertexArrays(1, &batch_vao_);
+            glDeleteBuffers(1, &batch_vbo_);
+            glDeleteBuffers(1, &batch_ebo_);
+            glDeleteBuffers(1, &batch_instance_vbo_);
+            glDeleteVertexArrays(1, &glyph_vao_);
+            glDeleteBuffers(1, &glyph_vbo_);
+        }
+        for (const auto &[atlas, texture] : glyph_textures_) {
+            glDeleteTextures(1, &texture);
+        }
+        if (framebuffer_ != 0) {
+            glDeleteFramebuffers(1, &framebuffer_);
+            glDeleteRenderbuffers(1, &color_renderbuffer_);
+        }
         glDeleteProgram(draw_2d_single_color_shader_program_);
+        glDeleteProgram(draw_2d_instanced_shader_program_);
+        glDeleteProgram(draw_2d_glyph_shader_program_);
     }
 
-    bool opengl_3::is_interactive() { return true; }
+    bool opengl_3::is_interactive() { return output_.empty(); }
 
-    const std::string &opengl_3::output() {
-        throw std::logic_error("output not implemented yet");
-    }
+    const std::string &opengl_3::output() { return output_; }
 
-    const std::string &opengl_3::output_format() {
-        throw std::logic_error("output_format not implemented yet");
-    }
+    const std::string &opengl_3::output_format() { return output_format_; }
 
     bool opengl_3::output(const std::string &filename) {
-        throw std::logic_error("output not implemented yet");
+        return output(filename, "");
     }
 
     bool opengl_3::output(const std::string &filename,
                           const std::string &file_format) {
-        throw std::logic_error("output not implemented yet");
+        if (filename.empty()) {
+            output_.clear();
+            output_format_.clear();
+            return true;
+        }
+        // We save the files with CImg, like the cimg_raster backend
+        return cimg_raster::output_file(filename, file_format, "opengl_3",
+                                        output_, output_format_);
     }
 
     unsigned int opengl_3::width() {
+        // Files have their own size. Windows have the size of the viewport.
+        if (!output_.empty()) {
+            return width_;
+        }
         GLint m_viewport[4];
         glGetIntegerv( GL_VIEWPORT, m_viewport );
         return m_viewport[2];
     }
 
     unsigned int opengl_3::height() {
+        if (!output_.empty()) {
+            return height_;
+        }
         GLint m_viewport[4];
         glGetIntegerv( GL_VIEWPORT, m_viewport );
         return m_viewport[3];
     }
 
     void opengl_3::width(unsigned int new_width) {
-        throw std::logic_error("width not implemented yet");
+        // This is the size of the files. The window controls its own size.
+        width_ = std::max(new_width, 1u);
     }
 
     void opengl_3::height(unsigned int new_height) {
-        throw std::logic_error("height not implemented yet");
+        height_ = std::max(new_height, 1u);
     }
 
     unsigned int opengl_3::position_x() {
@@ -141,12 +265,100 @@ namespace matplot::backend {
         throw std::logic_error("position_y not implemented yet");
     }
 
-    void opengl_3::new_frame() {}
+    void opengl_3::new_frame() { bind_offscreen_framebuffer(); }
 
     bool opengl_3::render_data() {
+        if (framebuffer_ == 0) {
+            return true;
+        }
+        // The figure might have repainted nothing, if nothing changed
+        if (!drawing_offscreen_) {
+            bind_offscreen_framebuffer();
+        }
+        if (!output_.empty()) {
+            return save_offscreen_framebuffer();
+        }
+        present_offscreen_framebuffer();
         return true;
     }
 
+    void opengl_3::bind_offscreen_framebuffer() {
+        // Keep the framebuffer and viewport of the window
+        // to restore them later
+        if (!drawing_offscreen_) {
+            glGetIntegerv(GL_DRAW_FRAMEBUFFER_BINDING, &window_framebuffer_);
+            glGetIntegerv(GL_VIEWPORT, window_viewport_);
+        }
+        // Files have their own size. Windows have the size of the viewport.
+        const unsigned int w =
+            output_.empty() ? std::max(window_viewport_[2], 1) : width_;
+        const unsigned int h =
+            output_.empty() ? std::max(window_viewport_[3], 1) : height_;
+        if (framebuffer_ == 0) {
+            glGenFramebuffers(1, &framebuffer_);
+            glGenRenderbuffers(1, &color_renderbuffer_);
+        }
+        glBindFramebuffer(GL_FRAMEBUFFER, framebuffer_);
+        if (framebuffer_width_ != w || framebuffer_height_ != h) {
+            glBindRenderbuffer(GL_RENDERBUFFER, color_renderbuffer_);
+            glRenderbufferStorage(GL_RENDERBUFFER, GL_RGBA8, w, h);
+            glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0,
+                                      GL_RENDERBUFFER, color_renderbuffer_);
+            glBindRenderbuffer(GL_RENDERBUFFER, 0);
+            framebuffer_width_ = w;
+            framebuffer_height_ = h;
+        }
+        if (glCheckFramebufferStatus(GL_FRAMEBUFFER) !=
+            GL_FRAMEBUFFER_COMPLETE) {
+            glBindFramebuffer(GL_FRAMEBUFFER, window_framebuffer_);
+            throw std::runtime_error("Offscreen framebuffer is not complete");
+        }
+        glViewport(0, 0, w, h);
+        drawing_offscreen_ = true;
+    }
+
+    void opengl_3::unbind_offscreen_framebuffer() {
+        glBindFramebuffer(GL_FRAMEBUFFER, window_framebuffer_);
+        glViewport(window_viewport_[0], window_viewport_[1],
+                   window_viewport_[2], window_viewport_[3]);
+        drawing_offscreen_ = false;
+    }
+
+    void opengl_3::present_offscreen_framebuffer() {
+        glBindFramebuffer(GL_READ_FRAMEBUFFER, framebuffer_);
+        glBindFramebuffer(GL_DRAW_FRAMEBUFFER, window_framebuffer_);
+        glBlitFramebuffer(0, 0, framebuffer_width_, framebuffer_height_,
+                          window_viewport_[0], window_viewport_[1],
+                          window_viewport_[0] + framebuffer_width_,
+                          window_viewport_[1] + framebuffer_height_,
+                          GL_COLOR_BUFFER_BIT, GL_NEAREST);
+        unbind_offscreen_framebuffer();
+    }
+
+    bool opengl_3::save_offscreen_framebuffer() {
+        const size_t w = framebuffer_width_;
+        const size_t h = framebuffer_height_;
+        std::vector<unsigned char> rgba(4 * w * h);
+        glPixelStorei(GL_PACK_ALIGNMENT, 1);
+        glReadPixels(0, 0, static_cast<GLsizei>(w), static_cast<GLsizei>(h),
+                     GL_RGBA, GL_UNSIGNED_BYTE, rgba.data());
+        unbind_offscreen_framebuffer();
+
+        // OpenGL rows go up and channels are interleaved.
+        // CImg rows go down and channels come one after the other.
+        std::vector<unsigned char> pixels(3 * w * h);
+        for (size_t y = 0; y < h; ++y) {
+            const unsigned char *row = rgba.data() + 4 * w * (h - 1 - y);
+            for (size_t x = 0; x < w; ++x) {
+                for (size_t k = 0; k < 3; ++k) {
+                    pixels[k * w * h + y * w + x] = row[4 * x + k];
+                }
+            }
+        }
+        return cimg_raster::save(pixels.data(), framebuffer_width_,
+                                 framebuffer_height_, output_, output_format_);
+    }
+
     void opengl_3::draw_rectangle(const double x1, const double x2,
                                            const double y1, const double y2,
                                            const std::array<float, 4> &color) {
@@ -192,28 +404,8 @@ namespace matplot::backend {
         // glVertexAttribPointer(color_attribute_location, 3, GL_FLOAT, GL_FALSE, stride, (void *)(3*sizeof(float)));
         // glEnableVertexAttribArray(1);
 
-        // Activate our shader program
-        glUseProgram(draw_2d_single_color_shader_program_);
-
-        // Set window size
-        int windowHeightLocation = glGetUniformLocation(draw_2d_single_color_shader_program_, "windowHeight");
-        if (windowHeightLocation == -1) {
-            throw std::runtime_error("can't find uniform location");
-        }
-        glUniform1f(windowHeightLocation, static_cast<float>(height()));
-
-        int windowWidthLocation = glGetUniformLocation(draw_2d_single_color_shader_program_, "windowWidth");
-        if (windowWidthLocation == -1) {
-            throw std::runtime_error("can't find uniform location");
-        }
-        glUniform1f(windowWidthLocation, static_cast<float>(width()));
-
-        // Set color
-        int vertexColorLocation = glGetUniformLocation(draw_2d_single_color_shader_program_, "ourColor");
-        if (vertexColorLocation == -1) {
-            throw std::runtime_error("can't find uniform location");
-        }
-        glUniform4f(vertexColorLocation, color[1], color[2], color[3], 1.-color[0]);
+        // Activate our shader program and set window size and color
+        use_2d_single_color_shader_program(color);
 
         // Bind element buffer
         glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, EBO);
@@ -229,6 +421,8 @@ namespace matplot::backend {
     }
 
     void opengl_3::draw_background(const std::array<float, 4> &color) {
+        // The background starts a new frame
+        new_frame();
         glClearColor(color[1], color[2], color[3], 1. - color[0]);
         glClear(GL_COLOR_BUFFER_BIT);
     }
@@ -264,28 +458,8 @@ namespace matplot::backend {
         glVertexAttribPointer(vertex_attribute_location, 2, GL_FLOAT, GL_FALSE, stride, (void *)0);
         glEnableVertexAttribArray(0);
 
-        // Activate our shader program
-        glUseProgram(draw_2d_single_color_shader_program_);
-
-        // Set window size
-        int windowHeightLocation = glGetUniformLocation(draw_2d_single_color_shader_program_, "windowHeight");
-        if (windowHeightLocation == -1) {
-            throw std::runtime_error("can't find uniform location");
-        }
-        glUniform1f(windowHeightLocation, static_cast<float>(height()));
-
-        int windowWidthLocation = glGetUniformLocation(draw_2d_single_color_shader_program_, "windowWidth");
-        if (windowWidthLocation == -1) {
-            throw std::runtime_error("can't find uniform location");
-        }
-        glUniform1f(windowWidthLocation, static_cast<float>(width()));
-
-        // Set color
-        int vertexColorLocation = glGetUniformLocation(draw_2d_single_color_shader_program_, "ourColor");
-        if (vertexColorLocation == -1) {
-            throw std::runtime_error("can't find uniform location");
-        }
-        glUniform4f(vertexColorLocation, color[1], color[2], color[3], 1.-color[0]);
+        // Activate our shader program and set window size and color
+        use_2d_single_color_shader_program(color);
 
         // Bind element buffer
         glBindVertexArray(VAO);
@@ -298,6 +472,186 @@ namespace matplot::backend {
         glDeleteBuffers(1, &VBO);
     }
 
+    void opengl_3::draw_triangles(const std::vector<double> &x,
+                                  const std::vector<double> &y,
+                                  const std::array<float, 4> &color) {
+        // Draw the triangles as a batch with a single command
+        vertex_batch batch;
+        batch.add_triangles(x, y, color);
+        draw_batch(batch);
+    }
+
+    bool opengl_3::supports_vertex_batch() { return true; }
+
+    void opengl_3::draw_batch(const vertex_batch &batch) {
+        if (batch.empty()) {
+            return;
+        }
+
+        // Create the buffers in the first batch and reuse them
+        constexpr GLsizei instance_stride = vertex_batch::instance_size * sizeof(float);
+        if (batch_vao_ == 0) {
+            glGenVertexArrays(1, &batch_vao_);
+            glGenBuffers(1, &batch_vbo_);
+            glGenBuffers(1, &batch_ebo_);
+            glGenBuffers(1, &batch_instance_vbo_);
+            glBindVertexArray(batch_vao_);
+            glBindBuffer(GL_ARRAY_BUFFER, batch_vbo_);
+            glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, batch_ebo_);
+            glVertexAttribPointer(0, 2, GL_FLOAT, GL_FALSE, 2 * sizeof(float), (void *)0);
+            glEnableVertexAttribArray(0);
+            // Position, scale and color advance once per instance
+            glBindBuffer(GL_ARRAY_BUFFER, batch_instance_vbo_);
+            glEnableVertexAttribArray(1);
+            glEnableVertexAttribArray(2);
+            glVertexAttribDivisor(1, 1);
+            glVertexAttribDivisor(2, 1);
+            // Glyphs have their own vertices, with texture coordinates
+            constexpr GLsizei glyph_stride = vertex_batch::glyph_vertex_size * sizeof(float);
+            glGenVertexArrays(1, &glyph_vao_);
+            glGenBuffers(1, &glyph_vbo_);
+            glBindVertexArray(glyph_vao_);
+            glBindBuffer(GL_ARRAY_BUFFER, glyph_vbo_);
+            glVertexAttribPointer(0, 2, GL_FLOAT, GL_FALSE, glyph_stride, (void *)0);
+            glVertexAttribPointer(1, 2, GL_FLOAT, GL_FALSE, glyph_stride, (void *)(2 * sizeof(float)));
+            glEnableVertexAttribArray(0);
+            glEnableVertexAttribArray(1);
+            glBindVertexArray(batch_vao_);
+        } else {
+            glBindVertexArray(batch_vao_);
+        }
+
+        // Upload all vertices, indices and instances of the frame at once
+        const std::vector<float> &vertices = batch.vertices();
+        const std::vector<uint32_t> &indices = batch.indices();
+        const std::vector<float> &instances = batch.instances();
+        glBindBuffer(GL_ARRAY_BUFFER, batch_vbo_);
+        glBufferData(GL_ARRAY_BUFFER, vertices.size() * sizeof(float), vertices.data(), GL_STREAM_DRAW);
+        glBufferData(GL_ELEMENT_ARRAY_BUFFER, indices.size() * sizeof(uint32_t), indices.data(), GL_STREAM_DRAW);
+        if (!instances.empty()) {
+            glBindBuffer(GL_ARRAY_BUFFER, batch_instance_vbo_);
+            glBufferData(GL_ARRAY_BUFFER, instances.size() * sizeof(float), instances.data(), GL_STREAM_DRAW);
+        }
+        const std::vector<float> &glyph_vertices = batch.glyph_vertices();
+        if (!glyph_vertices.empty()) {
+            glBindBuffer(GL_ARRAY_BUFFER, glyph_vbo_);
+            glBufferData(GL_ARRAY_BUFFER, glyph_vertices.size() * sizeof(float), glyph_vertices.data(),
+                         GL_STREAM_DRAW);
+        }
+
+        // One draw call for each command
+        for (const auto &command : batch.commands()) {
+            if (command.type == vertex_batch::primitive::glyphs) {
+                // The edges of the glyphs blend with what is behind them
+                use_2d_glyph_shader_program(*command.atlas, command.color);
+                glBindVertexArray(glyph_vao_);
+                glEnable(GL_BLEND);
+                glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+                glDrawArrays(GL_TRIANGLES, static_cast<GLint>(command.first_index),
+                             static_cast<GLsizei>(command.n_indices));
+                glDisable(GL_BLEND);
+                glBindVertexArray(batch_vao_);
+                continue;
+            }
+            GLenum mode = GL_LINES;
+            if (command.type == vertex_batch::primitive::triangles) {
+                mode = GL_TRIANGLES;
+            } else if (command.type == vertex_batch::primitive::points) {
+                mode = GL_POINTS;
+            }
+            void *first_index = (void *)(command.first_index * sizeof(uint32_t));
+            if (command.n_instances == 0) {
+                use_2d_single_color_shader_program(command.color);
+                glDrawElements(mode, static_cast<GLsizei>(command.n_indices), GL_UNSIGNED_INT,
+                               first_index);
+                continue;
+            }
+            // OpenGL 3.3 has no base instance, so the instance
+            // attributes point to the first instance of the command
+            use_2d_instanced_shader_program();
+            const size_t first_instance = command.first_instance * instance_stride;
+            glBindBuffer(GL_ARRAY_BUFFER, batch_instance_vbo_);
+            glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, instance_stride, (void *)first_instance);
+            glVertexAttribPointer(2, 4, GL_FLOAT, GL_FALSE, instance_stride,
+                                  (void *)(first_instance + 3 * sizeof(float)));
+            glDrawElementsInstanced(mode, static_cast<GLsizei>(command.n_indices), GL_UNSIGNED_INT,
+                                    first_index, static_cast<GLsizei>(command.n_instances));
+        }
+
+        glBindVertexArray(0);
+    }
+
+    bool opengl_3::supports_partial_repaint() { return true; }
+
+    void opengl_3::repaint_region(const vertex_batch &batch, double x1,
+                                  double x2, double y1, double y2) {
+        // Unlike draw_background, this keeps the last frame
+        if (!drawing_offscreen_) {
+            bind_offscreen_framebuffer();
+        }
+        const auto left = static_cast<GLint>(std::floor(x1));
+        const auto bottom = static_cast<GLint>(std::floor(y1));
+        glEnable(GL_SCISSOR_TEST);
+        glScissor(left, bottom, static_cast<GLsizei>(std::ceil(x2)) - left,
+                  static_cast<GLsizei>(std::ceil(y2)) - bottom);
+        draw_batch(batch);
+        glDisable(GL_SCISSOR_TEST);
+    }
+
+    void opengl_3::use_2d_single_color_shader_program(const std::array<float, 4> &color) {
+        glUseProgram(draw_2d_single_color_shader_program_);
+        glUniform1f(window_height_location_, static_cast<float>(height()));
+        glUniform1f(window_width_location_, static_cast<float>(width()));
+        glUniform4f(color_location_, color[1], color[2], color[3], 1. - color[0]);
+    }
+
+    void opengl_3::use_2d_instanced_shader_program() {
+        glUseProgram(draw_2d_instanced_shader_program_);
+        glUniform1f(instanced_window_height_location_, static_cast<float>(height()));
+        glUniform1f(instanced_window_width_location_, static_cast<float>(width()));
+    }
+
+    void opengl_3::use_2d_glyph_shader_program(const glyph_atlas &atlas,
+                                               const std::array<float, 4> &color) {
+        glUseProgram(draw_2d_glyph_shader_program_);
+        glUniform1f(glyph_window_height_location_, static_cast<float>(height()));
+        glUniform1f(glyph_window_width_location_, static_cast<float>(width()));
+        glUniform4f(glyph_color_location_, color[1], color[2], color[3], 1. - color[0]);
+        glActiveTexture(GL_TEXTURE0);
+        glBindTexture(GL_TEXTURE_2D, glyph_texture(atlas));
+    }
+
+    unsigned int opengl_3::glyph_texture(const glyph_atlas &atlas) {
+        auto it = glyph_textures_.find(&atlas);
+        if (it != glyph_textures_.end()) {
+            return it->second;
+        }
+        // Nearest filtering copies unrotated glyphs exactly
+        unsigned int texture;
+        glGenTextures(1, &texture);
+        glBindTexture(GL_TEXTURE_2D, texture);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+        // Rows of one byte are not aligned to 4 bytes
+        glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+        glTexImage2D(GL_TEXTURE_2D, 0, GL_R8, static_cast<GLsizei>(atlas.width()),
+                     static_cast<GLsizei>(atlas.height()), 0, GL_RED, GL_UNSIGNED_BYTE, atlas.pixels().data());
+        glyph_textures_[&atlas] = texture;
+        return texture;
+    }
+
+    void opengl_3::draw_text(const std::string &text, double x, double y,
+                             const std::string &font, float font_size,
+                             const std::array<float, 4> &color, float angle) {
+        // The atlas has a single font
+        vertex_batch batch;
+        batch.add_text(glyph_atlas::shared(static_cast<unsigned int>(std::lround(font_size))), text, x, y, angle,
+                       color);
+        draw_batch(batch);
+    }
+
     void opengl_3::draw_markers(const std::vector<double> &x,
                                 const std::vector<double> &y,
                                 const std::vector<double> &z) {
@@ -28,9 +28,30 @@
 /// \see https://learnopengl.com/Getting-started/Creating-a-window
 #include <GLFW/glfw3.h>
 
+#include <map>
 #include <matplot/backend/backend_interface.h>
+#include <string>
 
 namespace matplot::backend {
+    class glyph_atlas;
+
+    /// \class opengl_3
+    /// A backend that draws vertices in the current OpenGL 3.3 context
+    ///
+    /// The application creates the context, usually with a GLFW window,
+    /// and calls figure::draw() in its render loop.
+    ///
+    /// Frames are drawn to an offscreen framebuffer that the backend
+    /// keeps between frames, and render_data() copies it to the
+    /// window. Because the last frame is kept, figures with
+    /// incremental redraws only repaint the axes that changed.
+    ///
+    /// If an output file is set, the framebuffer has width() x
+    /// height() pixels instead, and render_data() reads it back
+    /// with glReadPixels and saves it with CImg. Any context works
+    /// for that, including surfaceless EGL or OSMesa contexts with a
+    /// software renderer such as Mesa llvmpipe, so figures can be
+    /// exported on servers without a display.
     class opengl_3 : public backend_interface {
       public:
         opengl_3();
@@ -81,6 +102,18 @@ namespace matplot::backend {
         void draw_triangle(const std::vector<double> &x,
                            const std::vector<double> &y,
                            const std::vector<double> &z = {}) override;
+        void draw_triangles(const std::vector<double> &x,
+                            const std::vector<double> &y,
+                            const std::array<float, 4> &color) override;
+        void draw_text(const std::string &text, double x, double y,
+                       const std::string &font, float font_size,
+                       const std::array<float, 4> &color,
+                       float angle = 0.f) override;
+        bool supports_vertex_batch() override;
+        void draw_batch(const vertex_batch &batch) override;
+        bool supports_partial_repaint() override;
+        void repaint_region(const vertex_batch &batch, double x1, double x2,
+                            double y1, double y2) override;
 
       public:
         static constexpr unsigned int default_screen_width = 560;
@@ -96,12 +129,77 @@ namespace matplot::backend {
         /// this frame and react accordingly
         static void process_input(GLFWwindow *window);
 
+      private:
+        /// \brief Compile and link a vertex and a fragment shader
+        static unsigned int create_shader_program(const char *vertex_shader_source,
+                                                  const char *fragment_shader_source);
+
+        /// \brief Activate the single color program and set its uniforms
+        void use_2d_single_color_shader_program(const std::array<float, 4> &color);
+
+        /// \brief Activate the program for instanced commands
+        /// The color comes from each instance.
+        void use_2d_instanced_shader_program();
+
+        /// \brief Activate the program for glyphs and bind their atlas
+        void use_2d_glyph_shader_program(const glyph_atlas &atlas,
+                                         const std::array<float, 4> &color);
+
+        /// \brief Texture with the coverage of an atlas
+        /// The texture is uploaded the first time the atlas is used.
+        unsigned int glyph_texture(const glyph_atlas &atlas);
+
+        /// \brief Bind the offscreen framebuffer, resizing it if needed
+        void bind_offscreen_framebuffer();
+
+        /// \brief Read the offscreen framebuffer and save it to the output
+        bool save_offscreen_framebuffer();
+
+        /// \brief Copy the offscreen framebuffer to the window
+        void present_offscreen_framebuffer();
+
+        /// \brief Bind the framebuffer and viewport of the window again
+        void unbind_offscreen_framebuffer();
+
       private:
         GLFWwindow *window_{nullptr};
         unsigned int draw_2d_single_color_shader_program_;
+        // Uniform locations, which we look up only once
+        int window_height_location_;
+        int window_width_location_;
+        int color_location_;
+        unsigned int draw_2d_instanced_shader_program_;
+        int instanced_window_height_location_;
+        int instanced_window_width_location_;
+        unsigned int draw_2d_glyph_shader_program_;
+        int glyph_window_height_location_;
+        int glyph_window_width_location_;
+        int glyph_color_location_;
+        // Buffers for vertex batches, reused in every frame
+        unsigned int batch_vao_{0};
+        unsigned int batch_vbo_{0};
+        unsigned int batch_ebo_{0};
+        unsigned int batch_instance_vbo_{0};
+        unsigned int glyph_vao_{0};
+        unsigned int glyph_vbo_{0};
+        // Atlases are never destroyed, so their textures live as
+        // long as the backend
+        std::map<const glyph_atlas *, unsigned int> glyph_textures_;
         int n_vertex_attributes_available_;
         unsigned int height_{default_screen_height};
         unsigned int width_{default_screen_width};
+        // File we save the frames to and its format
+        std::string output_;
+        std::string output_format_;
+        // Offscreen framebuffer and the size of its storage
+        unsigned int framebuffer_{0};
+        unsigned int color_renderbuffer_{0};
+        unsigned int framebuffer_width_{0};
+        unsigned int framebuffer_height_{0};
+        // Framebuffer and viewport of the window while we draw offscreen
+        int window_framebuffer_{0};
+        int window_viewport_[4]{0, 0, 0, 0};
+        bool drawing_offscreen_{false};
     };
 } // namespace matplot::backend
 
@@ -0,0 +1,338 @@
+#include "vertex_batch.h"
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <matplot/backend/glyph_atlas.h>
+#include <matplot/util/common.h>
+
+namespace matplot::backend {
+    void vertex_batch::clear() {
+        vertices_.clear();
+        indices_.clear();
+        instances_.clear();
+        glyph_vertices_.clear();
+        commands_.clear();
+    }
+
+    void vertex_batch::reserve(size_t n_vertices, size_t n_indices) {
+        vertices_.reserve(2 * n_vertices);
+        indices_.reserve(n_indices);
+    }
+
+    void vertex_batch::add_path(const std::vector<double> &x,
+                                const std::vector<double> &y,
+                                const std::array<float, 4> &color) {
+        const size_t n = std::min(x.size(), y.size());
+        if (n < 2) {
+            return;
+        }
+        // Find the command only after we know the path has
+        // a segment, so we don't create empty commands
+        command *c = nullptr;
+        bool previous_is_valid = false;
+        uint32_t previous = 0;
+        for (size_t i = 0; i < n; ++i) {
+            if (!std::isfinite(x[i]) || !std::isfinite(y[i])) {
+                previous_is_valid = false;
+                continue;
+            }
+            const uint32_t current = push_vertex(x[i], y[i]);
+            if (previous_is_valid) {
+                if (!c) {
+                    c = &command_for(primitive::lines, color);
+                }
+                indices_.emplace_back(previous);
+                indices_.emplace_back(current);
+                c->n_indices += 2;
+            }
+            previous = current;
+            previous_is_valid = true;
+        }
+    }
+
+    void vertex_batch::add_rectangle(double x1, double x2, double y1,
+                                     double y2,
+                                     const std::array<float, 4> &color) {
+        if (!std::isfinite(x1) || !std::isfinite(x2) ||
+            !std::isfinite(y1) || !std::isfinite(y2)) {
+            return;
+        }
+        command &c = command_for(primitive::triangles, color);
+        const uint32_t bottom_left = push_vertex(x1, y1);
+        const uint32_t bottom_right = push_vertex(x2, y1);
+        const uint32_t top_right = push_vertex(x2, y2);
+        const uint32_t top_left = push_vertex(x1, y2);
+        indices_.insert(indices_.end(), {bottom_left, bottom_right, top_right,
+                                         bottom_left, top_right, top_left});
+        c.n_indices += 6;
+    }
+
+    void vertex_batch::add_triangles(const std::vector<double> &x,
+                                     const std::vector<double> &y,
+                                     const std::array<float, 4> &color) {
+        const size_t n = std::min(x.size(), y.size()) / 3 * 3;
+        command *c = nullptr;
+        for (size_t i = 0; i < n; i += 3) {
+            bool finite = true;
+            for (size_t j = i; j < i + 3; ++j) {
+                finite = finite && std::isfinite(x[j]) && std::isfinite(y[j]);
+            }
+            if (!finite) {
+                continue;
+            }
+            if (!c) {
+                c = &command_for(primitive::triangles, color);
+            }
+            for (size_t j = i; j < i + 3; ++j) {
+                indices_.emplace_back(push_vertex(x[j], y[j]));
+            }
+            c->n_indices += 3;
+        }
+    }
+
+    void vertex_batch::add_points(const std::vector<double> &x,
+                                  const std::vector<double> &y,
+                                  const std::array<float, 4> &color) {
+        const size_t n = std::min(x.size(), y.size());
+        command *c = nullptr;
+        for (size_t i = 0; i < n; ++i) {
+            if (!std::isfinite(x[i]) || !std::isfinite(y[i])) {
+                continue;
+            }
+            if (!c) {
+                c = &command_for(primitive::points, color);
+            }
+            indices_.emplace_back(push_vertex(x[i], y[i]));
+            ++c->n_indices;
+        }
+    }
+
+    void vertex_batch::add_instances(
+        primitive type, const std::vector<double> &mesh_x,
+        const std::vector<double> &mesh_y, const std::vector<double> &x,
+        const std::vector<double> &y, const std::vector<double> &sizes,
+        const std::vector<std::array<float, 4>> &colors) {
+        const size_t vertices_per_primitive =
+            type == primitive::triangles ? 3 : type == primitive::lines ? 2 : 1;
+        const size_t n_mesh = std::min(mesh_x.size(), mesh_y.size()) /
+                              vertices_per_primitive * vertices_per_primitive;
+        const size_t n = std::min(x.size(), y.size());
+        if (n_mesh == 0 || n == 0 || sizes.empty() || colors.empty()) {
+            return;
+        }
+        const size_t first_instance = instances_.size() / instance_size;
+        for (size_t i = 0; i < n; ++i) {
+            if (!std::isfinite(x[i]) || !std::isfinite(y[i])) {
+                continue;
+            }
+            const double size = sizes[std::min(i, sizes.size() - 1)];
+            const auto &color = colors[std::min(i, colors.size() - 1)];
+            instances_.insert(instances_.end(),
+                              {static_cast<float>(x[i]),
+                               static_cast<float>(y[i]),
+                               static_cast<float>(size), color[0], color[1],
+                               color[2], color[3]});
+        }
+        const size_t n_instances =
+            instances_.size() / instance_size - first_instance;
+        if (n_instances == 0) {
+            return;
+        }
+        command c{type, colors[0], indices_.size(), n_mesh};
+        c.first_instance = first_instance;
+        c.n_instances = n_instances;
+        for (size_t i = 0; i < n_mesh; ++i) {
+            indices_.emplace_back(push_vertex(mesh_x[i], mesh_y[i]));
+        }
+        commands_.emplace_back(c);
+    }
+
+    void vertex_batch::add_text(const glyph_atlas &atlas,
+                                const std::string &text, double x, double y,
+                                double angle,
+                                const std::array<float, 4> &color) {
+        if (text.empty() || !std::isfinite(x) || !std::isfinite(y)) {
+            return;
+        }
+        // Direction of the baseline and of the glyph heights
+        const double radians = angle * pi / 180.;
+        double dx = std::cos(radians);
+        double dy = std::sin(radians);
+        if (angle == 0.) {
+            dx = 1.;
+            dy = 0.;
+            x = std::round(x);
+            y = std::round(y);
+        }
+        const double atlas_width = atlas.width();
+        const double atlas_height = atlas.height();
+        command &c = command_for(primitive::glyphs, color, &atlas);
+        double advance = 0.;
+        for (uint32_t code_point : glyph_atlas::code_points(text)) {
+            const glyph_atlas::glyph &g = atlas.glyph_for(code_point);
+            // Corners of the quad
+            const double w = g.width;
+            const double h = g.height;
+            const double x0 = x + advance * dx;
+            const double y0 = y + advance * dy;
+            const double corners[4][2] = {{x0, y0},
+                                          {x0 + w * dx, y0 + w * dy},
+                                          {x0 + w * dx - h * dy,
+                                           y0 + w * dy + h * dx},
+                                          {x0 - h * dy, y0 + h * dx}};
+            // The bottom of the glyph is its last row in the atlas
+            const double u0 = g.x / atlas_width;
+            const double u1 = (g.x + g.width) / atlas_width;
+            const double v0 = (g.y + g.height) / atlas_height;
+            const double v1 = g.y / atlas_height;
+            const double uvs[4][2] = {{u0, v0}, {u1, v0}, {u1, v1}, {u0, v1}};
+            for (int k : {0, 1, 2, 0, 2, 3}) {
+                glyph_vertices_.insert(
+                    glyph_vertices_.end(),
+                    {static_cast<float>(corners[k][0]),
+                     static_cast<float>(corners[k][1]),
+                     static_cast<float>(uvs[k][0]),
+                     static_cast<float>(uvs[k][1])});
+            }
+            c.n_indices += 6;
+            advance += w;
+        }
+    }
+
+    void vertex_batch::append(const vertex_batch &other) {
+        const auto offset = static_cast<uint32_t>(n_vertices());
+        const size_t first_index = indices_.size();
+        const size_t first_instance = instances_.size() / instance_size;
+        const size_t first_glyph_vertex =
+            glyph_vertices_.size() / glyph_vertex_size;
+        vertices_.insert(vertices_.end(), other.vertices_.begin(),
+                         other.vertices_.end());
+        indices_.reserve(indices_.size() + other.indices_.size());
+        for (const uint32_t index : other.indices_) {
+            indices_.emplace_back(index + offset);
+        }
+        instances_.insert(instances_.end(), other.instances_.begin(),
+                          other.instances_.end());
+        glyph_vertices_.insert(glyph_vertices_.end(),
+                               other.glyph_vertices_.begin(),
+                               other.glyph_vertices_.end());
+        for (const command &c : other.commands_) {
+            if (c.n_instances != 0) {
+                // Instanced commands are never merged
+                command &target = commands_.emplace_back(c);
+                target.first_index += first_index;
+                target.first_instance += first_instance;
+                continue;
+            }
+            // Glyph commands count glyph vertices rather than indices
+            const size_t offset = c.type == primitive::glyphs
+                                      ? first_glyph_vertex
+                                      : first_index;
+            command &target = command_for(c.type, c.color, c.atlas);
+            if (target.n_indices == 0) {
+                target.first_index = offset + c.first_index;
+            }
+            target.n_indices += c.n_indices;
+        }
+    }
+
+    const std::vector<float> &vertex_batch::vertices() const {
+        return vertices_;
+    }
+
+    const std::vector<uint32_t> &vertex_batch::indices() const {
+        return indices_;
+    }
+
+    const std::vector<float> &vertex_batch::instances() const {
+        return instances_;
+    }
+
+    const std::vector<float> &vertex_batch::glyph_vertices() const {
+        return glyph_vertices_;
+    }
+
+    const std::vector<vertex_batch::command> &vertex_batch::commands() const {
+        return commands_;
+    }
+
+    size_t vertex_batch::n_vertices() const { return vertices_.size() / 2; }
+
+    bool vertex_batch::empty() const { return commands_.empty(); }
+
+    std::array<double, 4> vertex_batch::bounds() const {
+        std::array<double, 4> b = {
+            std::numeric_limits<double>::infinity(),
+            -std::numeric_limits<double>::infinity(),
+            std::numeric_limits<double>::infinity(),
+            -std::numeric_limits<double>::infinity()};
+        auto include = [&b](double x1, double x2, double y1, double y2) {
+            b[0] = std::min(b[0], x1);
+            b[1] = std::max(b[1], x2);
+            b[2] = std::min(b[2], y1);
+            b[3] = std::max(b[3], y2);
+        };
+        for (const command &c : commands_) {
+            if (c.type == primitive::glyphs) {
+                const float *v =
+                    glyph_vertices_.data() + c.first_index * glyph_vertex_size;
+                for (size_t i = 0; i < c.n_indices;
+                     ++i, v += glyph_vertex_size) {
+                    include(v[0], v[0], v[1], v[1]);
+                }
+                continue;
+            }
+            // Bounds of the vertices, or of the template
+            std::array<double, 4> t = {
+                std::numeric_limits<double>::infinity(),
+                -std::numeric_limits<double>::infinity(),
+                std::numeric_limits<double>::infinity(),
+                -std::numeric_limits<double>::infinity()};
+            for (size_t i = c.first_index; i < c.first_index + c.n_indices;
+                 ++i) {
+                const float *v = vertices_.data() + 2 * indices_[i];
+                t[0] = std::min(t[0], static_cast<double>(v[0]));
+                t[1] = std::max(t[1], static_cast<double>(v[0]));
+                t[2] = std::min(t[2], static_cast<double>(v[1]));
+                t[3] = std::max(t[3], static_cast<double>(v[1]));
+            }
+            if (c.n_instances == 0) {
+                include(t[0], t[1], t[2], t[3]);
+                continue;
+            }
+            const float *instance =
+                instances_.data() + c.first_instance * instance_size;
+            for (size_t i = 0; i < c.n_instances;
+                 ++i, instance += instance_size) {
+                const double s = instance[2];
+                include(instance[0] + s * t[0], instance[0] + s * t[1],
+                        instance[1] + s * t[2], instance[1] + s * t[3]);
+            }
+        }
+        return b;
+    }
+
+    vertex_batch::command &
+    vertex_batch::command_for(primitive type,
+                              const std::array<float, 4> &color,
+                              const glyph_atlas *atlas) {
+        if (commands_.empty() || commands_.back().n_instances != 0 ||
+            commands_.back().type != type ||
+            commands_.back().color != color ||
+            commands_.back().atlas != atlas) {
+            const size_t first = type == primitive::glyphs
+                                     ? glyph_vertices_.size() /
+                                           glyph_vertex_size
+                                     : indices_.size();
+            commands_.emplace_back(command{type, color, first, 0, atlas});
+        }
+        return commands_.back();
+    }
+
+    uint32_t vertex_batch::push_vertex(double x, double y) {
+        const auto index = static_cast<uint32_t>(vertices_.size() / 2);
+        vertices_.emplace_back(static_cast<float>(x));
+        vertices_.emplace_back(static_cast<float>(y));
+        return index;
+    }
+} // namespace matplot::backend
@@ -0,0 +1,187 @@
+#ifndef MATPLOTPLUSPLUS_VERTEX_BATCH_H
+#define MATPLOTPLUSPLUS_VERTEX_BATCH_H
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace matplot::backend {
+    class glyph_atlas;
+
+    /// \class vertex_batch
+    /// The vertices of a frame, grouped into a few draw commands
+    ///
+    /// Backends based on vertices pay a cost for each call to
+    /// draw_path or draw_rectangle, such as creating buffers and
+    /// setting uniforms. A figure with thousands of lines or markers
+    /// would pay this cost thousands of times.
+    ///
+    /// Instead, the figure can record the primitives of a frame in
+    /// a vertex_batch. All vertices go to one float32 array and all
+    /// indices go to one index array. Consecutive primitives with the
+    /// same type and color are merged into the same command, so the
+    /// backend can draw each command with a single call.
+    ///
+    /// Markers are instanced: a command can draw the same template
+    /// mesh many times, with a position, size and color for each
+    /// instance. Scatter plots with millions of markers then need
+    /// one template and a few floats per marker.
+    ///
+    /// Text is a list of textured quads, one per glyph, which sample
+    /// the coverage of the glyphs from a glyph_atlas.
+    ///
+    /// The batch is an arena: clear() keeps the memory, so a figure
+    /// that draws similar frames does not allocate again.
+    class vertex_batch {
+      public:
+        /// How the indices of a command are interpreted
+        enum class primitive {
+            /// Each pair of indices is a line segment
+            lines,
+            /// Each three indices are a filled triangle
+            triangles,
+            /// Each index is a point
+            points,
+            /// Each six glyph vertices are two triangles of a glyph
+            glyphs
+        };
+
+        /// A range of indices drawn with the same style
+        struct command {
+            primitive type;
+            /// Color as {transparency, red, green, blue}
+            std::array<float, 4> color;
+            /// Position of the first index in indices()
+            /// Glyph commands use no indices. Their range is in
+            /// glyph_vertices() instead.
+            size_t first_index;
+            /// Number of indices
+            size_t n_indices;
+            /// Atlas the glyphs sample from, if this is a glyph command
+            const glyph_atlas *atlas{nullptr};
+            /// Position of the first instance in instances()
+            size_t first_instance{0};
+            /// Number of instances, or 0 if the command is not instanced
+            /// The vertices of an instanced command are a template,
+            /// drawn once for each instance with the color of the
+            /// instance rather than the color of the command.
+            size_t n_instances{0};
+        };
+
+        /// Floats of each instance in instances():
+        /// x, y, scale, transparency, red, green, blue
+        static constexpr size_t instance_size = 7;
+
+        /// Floats of each vertex in glyph_vertices(): x, y, u, v
+        /// The texture coordinates u and v go from 0 to 1 over the
+        /// atlas, with v = 0 at its top row.
+        static constexpr size_t glyph_vertex_size = 4;
+
+      public:
+        /// \brief Remove all primitives, keeping the memory
+        void clear();
+
+        /// \brief Reserve memory for a number of vertices and indices
+        void reserve(size_t n_vertices, size_t n_indices);
+
+        /// \brief Add a path as line segments
+        /// Non-finite points break the path.
+        void add_path(const std::vector<double> &x,
+                      const std::vector<double> &y,
+                      const std::array<float, 4> &color);
+
+        /// \brief Add a filled rectangle as two triangles
+        void add_rectangle(double x1, double x2, double y1, double y2,
+                           const std::array<float, 4> &color);
+
+        /// \brief Add filled triangles
+        /// Each three points are a triangle. Triangles with
+        /// non-finite points are ignored.
+        void add_triangles(const std::vector<double> &x,
+                           const std::vector<double> &y,
+                           const std::array<float, 4> &color);
+
+        /// \brief Add points
+        /// Non-finite points are ignored.
+        void add_points(const std::vector<double> &x,
+                        const std::vector<double> &y,
+                        const std::array<float, 4> &color);
+
+        /// \brief Add instances of a template mesh
+        /// The template is a list of triangles or line segments
+        /// around the origin. Each instance draws the template scaled
+        /// by sizes[i] and translated to (x[i], y[i]). Points past the
+        /// end of sizes or colors use their last element, so a single
+        /// size or color is shared by all instances.
+        /// Instances at non-finite points are ignored.
+        void add_instances(primitive type, const std::vector<double> &mesh_x,
+                           const std::vector<double> &mesh_y,
+                           const std::vector<double> &x,
+                           const std::vector<double> &y,
+                           const std::vector<double> &sizes,
+                           const std::vector<std::array<float, 4>> &colors);
+
+        /// \brief Add a line of text
+        /// (x, y) is the bottom left corner of the text and the angle
+        /// rotates the text around it, in degrees counterclockwise.
+        /// Unrotated text is snapped to whole pixels, so its glyphs
+        /// are copied from the atlas exactly.
+        void add_text(const glyph_atlas &atlas, const std::string &text,
+                      double x, double y, double angle,
+                      const std::array<float, 4> &color);
+
+        /// \brief Add all primitives of another batch after ours
+        /// Batches recorded separately, such as the batches of each
+        /// axes, can be merged in the order they should be drawn.
+        void append(const vertex_batch &other);
+
+        /// \brief Coordinates of the vertices, as x0, y0, x1, y1, ...
+        const std::vector<float> &vertices() const;
+
+        /// \brief Indices of the vertices used by the commands
+        const std::vector<uint32_t> &indices() const;
+
+        /// \brief Position, scale and color of the instances
+        /// Each instance has instance_size floats.
+        const std::vector<float> &instances() const;
+
+        /// \brief Vertices of the glyph commands
+        /// Each vertex has glyph_vertex_size floats.
+        const std::vector<float> &glyph_vertices() const;
+
+        /// \brief Commands in the order they should be drawn
+        const std::vector<command> &commands() const;
+
+        /// \brief Number of vertices
+        size_t n_vertices() const;
+
+        /// \brief True if there is nothing to draw
+        bool empty() const;
+
+        /// \brief Smallest rectangle with all primitives
+        /// The rectangle is {x1, x2, y1, y2}. If the batch is
+        /// empty, x1 > x2 and y1 > y2.
+        std::array<double, 4> bounds() const;
+
+      private:
+        /// Get the last command if it has the same style and is not
+        /// instanced, or start a new command
+        command &command_for(primitive type,
+                             const std::array<float, 4> &color,
+                             const glyph_atlas *atlas = nullptr);
+
+        /// Store a vertex and return its index
+        uint32_t push_vertex(double x, double y);
+
+      private:
+        std::vector<float> vertices_;
+        std::vector<uint32_t> indices_;
+        std::vector<float> instances_;
+        std::vector<float> glyph_vertices_;
+        std::vector<command> commands_;
+    };
+} // namespace matplot::backend
+
+#endif // MATPLOTPLUSPLUS_VERTEX_BATCH_H
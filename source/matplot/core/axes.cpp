@@ -8,10 +8,12 @@
 #include <memory>
 #include <sstream>
 
+#include <matplot/backend/glyph_atlas.h>
 #include <matplot/core/axes.h>
 #include <matplot/core/axes_object.h>
 #include <matplot/core/figure.h>
 
+#include <matplot/util/adaptive_grid.h>
 #include <matplot/util/colors.h>
 #include <matplot/util/common.h>
 #include <matplot/util/concepts.h>
@@ -38,10 +40,24 @@
 #include <matplot/freestanding/histcounts.h>
 
 namespace matplot {
+    namespace {
+        /// Screens have 96 pixels per inch and fonts have 72 points
+        constexpr double pixels_per_point = 96. / 72.;
+
+        unsigned font_height_in_pixels(float font_size) {
+            return static_cast<unsigned>(
+                std::max(std::lround(font_size * pixels_per_point), 1l));
+        }
+    } // namespace
 
     void axes::draw() { parent_->draw(); }
 
-    void axes::touch() { parent_->touch(); }
+    void axes::touch() {
+        ++revision_;
+        parent_->draw_if_reactive();
+    }
+
+    size_t axes::revision() const { return revision_; }
 
     void axes::emplace_object(axes_object_handle obj) {
         if (next_plot_replace_) {
@@ -898,7 +914,11 @@ namespace matplot {
 
         // data commands
         for (const auto &child : children_) {
-            run_command(child->data_string());
+            if (child->use_binary_data_files()) {
+                // the plot command references the data files directly
+                continue;
+            }
+            run_data_command(child);
         }
 
         // unset variables command
@@ -910,6 +930,16 @@ namespace matplot {
     }
 
     void axes::run_commands() {
+        const bool incremental = parent_->incremental_redraw();
+        if (incremental && commands_cache_revision_ == revision_ + 1 &&
+            commands_cache_context_ == parent_->draw_context()) {
+            run_cached_commands();
+            return;
+        }
+
+        commands_cache_.clear();
+        commands_cache_revision_ = 0;
+        recording_commands_ = incremental;
         run_colormap_command();
         run_position_margin_command();
         run_title_command();
@@ -919,18 +949,92 @@ namespace matplot {
         run_labels_command();
         run_legend_command();
         run_background_command();
+        // Objects can ask for the size of a pixel, e.g. to choose
+        // how much detail to send
+        update_draw_transform();
         run_plot_objects_command();
+        if (recording_commands_) {
+            // objects might have been touched while generating
+            // their commands (e.g. the first color from the colororder)
+            recording_commands_ = false;
+            commands_cache_revision_ = revision_ + 1;
+            commands_cache_context_ = parent_->draw_context();
+        }
+    }
+
+    void axes::run_figure_command(const std::string &text, bool binary) {
+        if (recording_commands_) {
+            commands_cache_.push_back({text, binary, nullptr});
+        }
+        if (binary) {
+            parent_->run_binary_data(text);
+        } else {
+            parent_->run_command(text);
+        }
+    }
+
+    void axes::run_data_command(const axes_object_handle &child) {
+        const bool binary = child->use_binary_data();
+        if (!parent_->incremental_redraw() ||
+            !child->data_is_self_contained()) {
+            run_figure_command(binary ? child->binary_data_string()
+                                      : "    " + child->data_string(),
+                               binary);
+            return;
+        }
+        // The child keeps this data until it is touched, so we
+        // only record where it comes from
+        if (recording_commands_) {
+            commands_cache_.push_back({"", binary, child});
+        }
+        if (binary) {
+            parent_->run_binary_data(child->cached_data_string(true));
+        } else {
+            parent_->run_command("    " + child->cached_data_string(false));
+        }
+    }
+
+    void axes::run_cached_commands() {
+        for (const auto &command : commands_cache_) {
+            if (command.data_source) {
+                run_data_command(command.data_source);
+            } else if (command.binary) {
+                parent_->run_binary_data(command.text);
+            } else {
+                parent_->run_command(command.text);
+            }
+        }
+        // Tell the backend the data files of the children are
+        // still in use
+        for (const auto &child : children_) {
+            if (child->use_binary_data_files()) {
+                child->binary_data_file();
+            }
+        }
+    }
+
+    void axes::run_draw_commands(backend::vertex_batch &batch) {
+        recording_batch_ = &batch;
+        try {
+            run_draw_commands();
+        } catch (...) {
+            recording_batch_ = nullptr;
+            throw;
+        }
+        recording_batch_ = nullptr;
     }
 
     void axes::run_draw_commands() {
+        update_draw_transform();
         run_background_draw_commands();
         run_title_draw_commands();
         run_grid_draw_commands();
         run_box_draw_commands();
         run_axes_draw_commands();
         run_labels_draw_commands();
-        run_legend_draw_commands();
         run_plot_objects_draw_commands();
+        // The legend is opaque, so it goes over the objects
+        run_legend_draw_commands();
     }
 
     void axes::run_background_draw_commands() {
@@ -941,11 +1045,19 @@ namespace matplot {
         double view_height = parent_->backend_->height();
         double y1 = bm * view_height;
         double y2 = tm * view_height;
-        parent_->backend_->draw_rectangle(x1,x2,y1,y2,this->color_);
+        draw_pixel_rectangle(x1,x2,y1,y2,this->color_);
     }
 
     void axes::run_title_draw_commands() {
-        // This should draw the title on top of the axes
+        if (!title_visible_ || title_.empty()) {
+            return;
+        }
+        // Centered above the axes, half a line away from the box
+        const auto &[x1, x2, y1, y2] = draw_viewport_;
+        const float size = font_size() * title_font_size_multiplier_;
+        const double gap = font_height_in_pixels(size) / 2.;
+        draw_pixel_text(title_, (x1 + x2) / 2., y2 + gap, size, title_color_,
+                        0.5, 0.);
     }
 
     void axes::run_box_draw_commands() {
@@ -959,7 +1071,7 @@ namespace matplot {
         const std::array<float, 4> color = {0.,0.,0.,0.};
         std::vector<double> box_xs = {x1,x2,x2,x1,x1};
         std::vector<double> box_ys = {y1,y1,y2,y2,y1};
-        parent_->backend_->draw_path(box_xs, box_ys, color);
+        draw_pixel_path(box_xs, box_ys, color);
     }
 
     void axes::run_grid_draw_commands() {
@@ -971,11 +1083,160 @@ namespace matplot {
     }
 
     void axes::run_labels_draw_commands() {
-
+        // Labels leave room for the tick labels between them
+        // and the box
+        const auto &[x1, x2, y1, y2] = draw_viewport_;
+        const unsigned tick_height = font_height_in_pixels(font_size());
+        if (!x_axis_.label().empty()) {
+            const double y = y1 - 1.5 * tick_height;
+            draw_pixel_text(x_axis_.label(), (x1 + x2) / 2., y,
+                            x_axis_.label_font_size(), x_axis_.label_color(),
+                            0.5, 1.);
+        }
+        if (!y_axis_.label().empty()) {
+            const auto &atlas = backend::glyph_atlas::shared(tick_height);
+            const double x =
+                x1 - atlas.text_width("-0.00") - 0.5 * tick_height;
+            draw_pixel_text(y_axis_.label(), x, (y1 + y2) / 2.,
+                            y_axis_.label_font_size(), y_axis_.label_color(),
+                            0.5, 0., 90.f);
+        }
     }
 
     void axes::run_legend_draw_commands() {
-
+        if (legend_ == nullptr || !legend_->visible()) {
+            return;
+        }
+        // Entries follow the same rules as the gnuplot key: objects
+        // with a display name use it, and the other objects take
+        // the strings of the legend in order
+        std::vector<std::pair<std::string, line_spec>> entries;
+        auto legend_it = legend_->begin();
+        auto legend_end = legend_->end();
+        for (const auto &child : children_) {
+            if (!child->display_name().empty()) {
+                entries.emplace_back(child->display_name(),
+                                     child->legend_line_spec());
+            } else if (legend_it != legend_end) {
+                if (!legend_it->empty()) {
+                    entries.emplace_back(*legend_it,
+                                         child->legend_line_spec());
+                }
+                ++legend_it;
+            }
+        }
+        if (entries.empty()) {
+            return;
+        }
+        if (legend_->invert()) {
+            std::reverse(entries.begin(), entries.end());
+        }
+
+        // Layout of the entries in rows and columns, in pixels
+        const float size = legend_->font_size();
+        const double line_height = font_height_in_pixels(size);
+        const auto &atlas =
+            backend::glyph_atlas::shared(font_height_in_pixels(size));
+        const double gap = line_height / 2.;
+        const double sample_width = 2. * line_height;
+        const double row_height = 1.25 * line_height;
+        unsigned text_width = 0;
+        for (const auto &entry : entries) {
+            text_width = std::max(text_width, atlas.text_width(entry.first));
+        }
+        const double entry_width = sample_width + gap + text_width;
+        const size_t n = entries.size();
+        size_t n_rows = legend_->vertical() ? n : 1;
+        if (legend_->num_columns() != 0) {
+            n_rows = (n + legend_->num_columns() - 1) / legend_->num_columns();
+        } else if (legend_->num_rows() != 0) {
+            n_rows = std::min(legend_->num_rows(), n);
+        }
+        const size_t n_cols = (n + n_rows - 1) / n_rows;
+        const bool has_title = !legend_->title().empty();
+        const double title_width =
+            has_title ? atlas.text_width(legend_->title()) : 0.;
+        const double width =
+            std::max(n_cols * entry_width + (n_cols - 1) * gap, title_width) +
+            2. * gap;
+        const double height = (n_rows + has_title) * row_height + 2. * gap;
+
+        // Position of the box
+        const auto &[x1, x2, y1, y2] = draw_viewport_;
+        double left = 0.;
+        double bottom = 0.;
+        const auto h = legend_->horizontal_location();
+        const auto v = legend_->vertical_location();
+        const double fx = h == legend::horizontal_alignment::left    ? 0.
+                          : h == legend::horizontal_alignment::right ? 1.
+                                                                     : 0.5;
+        const double fy = v == legend::vertical_alignment::bottom ? 0.
+                          : v == legend::vertical_alignment::top  ? 1.
+                                                                  : 0.5;
+        if (legend_->manual_position()) {
+            // The position is a fraction of the figure
+            left = legend_->position()[0] * parent_->backend_->width() -
+                   fx * width;
+            bottom = legend_->position()[1] * parent_->backend_->height() -
+                     fy * height;
+        } else if (legend_->inside()) {
+            left = x1 + gap + fx * (x2 - x1 - width - 2. * gap);
+            bottom = y1 + gap + fy * (y2 - y1 - height - 2. * gap);
+        } else if (h != legend::horizontal_alignment::center) {
+            // Beside the axes
+            left = fx == 0. ? x1 - gap - width : x2 + gap;
+            bottom = y1 + fy * (y2 - y1 - height);
+        } else {
+            // Above or below the axes
+            left = x1 + fx * (x2 - x1 - width);
+            bottom = fy == 0. ? y1 - gap - height : y2 + gap;
+        }
+
+        // Box
+        const double right = left + width;
+        const double top = bottom + height;
+        draw_pixel_rectangle(left, right, bottom, top, color_);
+        if (legend_->box() && legend_->box_line().has_line()) {
+            draw_pixel_path({left, right, right, left, left},
+                            {bottom, bottom, top, top, bottom},
+                            legend_->box_line().color());
+        }
+
+        // Entries
+        const auto &text_color = legend_->text_color();
+        double y = top - gap - row_height / 2.;
+        if (has_title) {
+            draw_pixel_text(legend_->title(), (left + right) / 2., y, size,
+                            text_color, 0.5, 0.5);
+            y -= row_height;
+        }
+        const bool sample_first = legend_->label_after_sample();
+        for (size_t i = 0; i < n; ++i) {
+            // Vertical legends fill the columns first
+            const size_t row = legend_->vertical() ? i % n_rows : i / n_cols;
+            const size_t col = legend_->vertical() ? i / n_rows : i % n_cols;
+            const double entry_left = left + gap + col * (entry_width + gap);
+            const double entry_y = y - row * row_height;
+            const double sample_left =
+                sample_first ? entry_left : entry_left + text_width + gap;
+            const double text_left =
+                sample_first ? entry_left + sample_width + gap : entry_left;
+            draw_pixel_text(entries[i].first, text_left, entry_y, size,
+                            text_color, 0., 0.5);
+
+            line_spec &spec = entries[i].second;
+            if (spec.has_line()) {
+                draw_pixel_path({sample_left, sample_left + sample_width},
+                                {entry_y, entry_y}, spec.color());
+            }
+            if (spec.has_non_custom_marker()) {
+                draw_pixel_markers({sample_left + sample_width / 2.},
+                                   {entry_y}, spec.marker_style(),
+                                   {spec.marker_size()}, {spec.marker_color()},
+                                   spec.marker_face(),
+                                   {spec.marker_face_color()});
+            }
+        }
     }
 
 
@@ -986,11 +1247,11 @@ namespace matplot {
     }
 
     void axes::run_command(const std::string &command) {
-        parent_->run_command("    " + command);
+        run_figure_command("    " + command, false);
     }
 
     void axes::include_comment(const std::string &command) {
-        parent_->run_command("    # " + command);
+        run_figure_command("    # " + command, false);
     }
 
     bool axes::is_3d() {
@@ -1012,6 +1273,8 @@ namespace matplot {
     axes_handle axes::copy(figure_handle parent) {
         axes_handle new_axes = std::make_shared<class axes>(*this);
         new_axes->parent_ = parent.get();
+        new_axes->commands_cache_.clear();
+        new_axes->commands_cache_revision_ = 0;
         new_axes->parent_->add_axes(new_axes, false, false);
         return new_axes;
     }
@@ -2453,15 +2716,21 @@ namespace matplot {
                           line_spec);
     }
 
+    bool axes::parallel_evaluation() const { return parallel_evaluation_; }
+
+    void axes::parallel_evaluation(bool parallel_evaluation) {
+        parallel_evaluation_ = parallel_evaluation;
+    }
+
     line_handle axes::fimplicit(axes::implicit_function_type equation,
                                 const std::array<double, 4> &xy_interval,
                                 const std::string &line_spec) {
         axes_silencer temp_silencer_{this};
-        auto [X, Y] = meshgrid(linspace(xy_interval[0], xy_interval[1]),
-                               linspace(xy_interval[2], xy_interval[3]));
-        auto Z = transform(X, Y, equation);
+        adaptive_grid grid(equation, xy_interval, 64, 3,
+                           parallel_evaluation_);
+        grid.refine({0.});
         std::vector<std::pair<vector_1d, vector_1d>> c =
-            contourc(X, Y, Z, vector_1d{0.});
+            contourc(grid.x(), grid.y(), grid.z(), vector_1d{0.});
         if (!c.empty()) {
             auto l = this->plot(c[0].first, c[0].second, line_spec);
             return l;
@@ -4268,17 +4537,32 @@ namespace matplot {
                                    size_t n_levels) {
         axes_silencer temp_silencer_{this};
 
-        std::vector<double> x = linspace(xy_range[0], xy_range[1]);
-        std::vector<double> y = linspace(xy_range[2], xy_range[3]);
-        auto [X, Y] = meshgrid(x, y);
-        vector_2d Z(y.size(), vector_1d(x.size(), 0.));
-        for (size_t i = 0; i < y.size(); ++i) {
-            for (size_t j = 0; j < x.size(); ++j) {
-                Z[i][j] = fn(X[i][j], Y[i][j]);
+        // Refine the grid around the levels the contours will use
+        adaptive_grid grid(fn, xy_range, 64, 3, parallel_evaluation_);
+        if (levels.empty()) {
+            // Automatic levels come from the z range of the refined grid,
+            // which can be wider than the coarse one. Refine again if
+            // they are not the levels the grid was refined around.
+            auto automatic_levels = [&]() {
+                auto [z_min, z_max] = grid.z_limits();
+                return z_min <= z_max
+                           ? contours::determine_contour_levels(
+                                 z_min, z_max, n_levels != 0 ? n_levels : 9)
+                           : std::vector<double>{};
+            };
+            std::vector<double> coarse_levels = automatic_levels();
+            grid.refine(coarse_levels);
+            levels = automatic_levels();
+            if (levels != coarse_levels) {
+                grid.refine(levels);
             }
+        } else {
+            grid.refine(levels);
         }
 
-        contours_handle l = this->contour(X, Y, Z, levels, line_spec, n_levels);
+        contours_handle l =
+            this->contour(grid.x_rows(), grid.y_rows(), grid.z_rows(), levels,
+                          line_spec, n_levels);
 
         return l;
     }
@@ -5183,40 +5467,534 @@ namespace matplot {
         return h;
     }
 
-    void axes::draw_path(const std::vector<double> &x,
-                   const std::vector<double> &y,
-                   const std::array<float, 4> &color) {
-        // we still have to make limits calculate and return the
-        // automatic limits rather than the default limits
-        auto xlimits = x_axis_.limits();
-        auto ylimits = y_axis_.limits();
-        // clamp
-        std::vector<double> cx = transform(x, [&](double x) { return std::clamp(x,xlimits[0],xlimits[1]); });
-        std::vector<double> cy = transform(y, [&](double y) { return std::clamp(y,ylimits[0],ylimits[1]); });
-        // normalize
-        auto [w,h,lm,rm,bm,tm] = calculate_margins();
+    void axes::update_draw_transform() {
+        // Automatic limits, or the infinite ends of manual
+        // limits, come from the children
+        std::array<double, 4> limits = {x_axis_.limits_[0], x_axis_.limits_[1],
+                                        y_axis_.limits_[0], y_axis_.limits_[1]};
+        if (x_axis_.limits_mode_auto()) {
+            limits[0] = limits[1] = NaN;
+        }
+        if (y_axis_.limits_mode_auto()) {
+            limits[2] = limits[3] = NaN;
+        }
+        const bool all_finite =
+            std::all_of(limits.begin(), limits.end(),
+                        [](double v) { return std::isfinite(v); });
+        if (!all_finite) {
+            const std::array<double, 4> c = child_limits();
+            for (size_t i = 0; i < 4; ++i) {
+                if (!std::isfinite(limits[i])) {
+                    limits[i] = std::isfinite(c[i]) ? c[i] : (i % 2 ? 10 : -10);
+                }
+            }
+        }
+        // Polar plots map (theta, rho) to the plane, and the
+        // limits of the children are already in the plane
+        draw_polar_ = is_polar();
+        draw_r_min_ = draw_polar_ && r_axis_.limits_mode_manual() &&
+                              std::isfinite(r_axis_.limits_[0])
+                          ? r_axis_.limits_[0]
+                          : 0.;
+
+        // Log axes are linear on the log of the data
+        draw_x_log_ =
+            !draw_polar_ && x_axis_.scale() == axis::axis_scale::log;
+        draw_y_log_ =
+            !draw_polar_ && y_axis_.scale() == axis::axis_scale::log;
+        const std::array<bool, 2> log = {draw_x_log_, draw_y_log_};
+        for (size_t i = 0; i < 4; i += 2) {
+            if (!log[i / 2]) {
+                continue;
+            }
+            if (!(limits[i + 1] > 0.)) {
+                limits[i + 1] = 10.;
+            }
+            if (!(limits[i] > 0.)) {
+                limits[i] = limits[i + 1] / 1000.;
+            }
+            limits[i] = std::log10(limits[i]);
+            limits[i + 1] = std::log10(limits[i + 1]);
+        }
+
+        // Avoid empty ranges
+        for (size_t i = 0; i < 4; i += 2) {
+            if (!(limits[i] < limits[i + 1])) {
+                limits[i] -= 1.;
+                limits[i + 1] = limits[i] + 2.;
+            }
+        }
+        draw_limits_ = limits;
+
+        auto [w, h, lm, rm, bm, tm] = calculate_margins();
         double view_width = parent_->backend_->width();
-        double x1 = lm * view_width;
-        double x2 = rm * view_width;
         double view_height = parent_->backend_->height();
-        double y1 = bm * view_height;
-        double y2 = tm * view_height;
-        auto xrange = xlimits[1] - xlimits[0];
-        auto yrange = ylimits[1] - ylimits[0];
-        for (auto &v : cx) {
-            v -= xlimits[0];
-            v /= xrange;
-            v *= x2 - x1;
-            v += x1;
-        }
-        for (auto &v : cy) {
-            v -= ylimits[0];
-            v /= xrange;
-            v *= y2 - y1;
-            v += y1;
-        }
-        // draw the normalized path to the backend
-        parent_->backend_->draw_path(cx,cy,color);
+        draw_viewport_ = {lm * view_width, rm * view_width, bm * view_height,
+                          tm * view_height};
+    }
+
+    void axes::data_to_pixels(const std::vector<double> &x,
+                              const std::vector<double> &y,
+                              std::vector<double> &px,
+                              std::vector<double> &py) const {
+        // pixel = offset + clamp(value) * scale, where value is the
+        // data, its log, or its projection on the plane
+        const auto [xmin, xmax, ymin, ymax] = draw_limits_;
+        const auto [x1, x2, y1, y2] = draw_viewport_;
+        const double x_scale = (x2 - x1) / (xmax - xmin);
+        const double y_scale = (y2 - y1) / (ymax - ymin);
+        const double x_offset = x1 - xmin * x_scale;
+        const double y_offset = y1 - ymin * y_scale;
+        // min and max keep NaNs, which break paths
+        auto clamp = [](double v, double lo, double hi) {
+            return std::min(std::max(v, lo), hi);
+        };
+
+        const size_t n = std::min(x.size(), y.size());
+        px.resize(n);
+        py.resize(n);
+        const double *xs = x.data();
+        const double *ys = y.data();
+        double *pxs = px.data();
+        double *pys = py.data();
+        if (draw_polar_) {
+            const double r_min = draw_r_min_;
+            for (size_t i = 0; i < n; ++i) {
+                const double r = std::max(ys[i] - r_min, 0.);
+                pxs[i] = x_offset +
+                         clamp(r * std::cos(xs[i]), xmin, xmax) * x_scale;
+                pys[i] = y_offset +
+                         clamp(r * std::sin(xs[i]), ymin, ymax) * y_scale;
+            }
+        } else if (!draw_x_log_ && !draw_y_log_) {
+            // A single branchless pass the compiler can vectorize
+            for (size_t i = 0; i < n; ++i) {
+                pxs[i] = x_offset + clamp(xs[i], xmin, xmax) * x_scale;
+                pys[i] = y_offset + clamp(ys[i], ymin, ymax) * y_scale;
+            }
+        } else {
+            // Non-positive values have no log, so they break paths
+            auto log_value = [](double v) {
+                return v > 0. ? std::log10(v) : NaN;
+            };
+            const bool x_log = draw_x_log_;
+            const bool y_log = draw_y_log_;
+            for (size_t i = 0; i < n; ++i) {
+                const double vx = x_log ? log_value(xs[i]) : xs[i];
+                const double vy = y_log ? log_value(ys[i]) : ys[i];
+                pxs[i] = x_offset + clamp(vx, xmin, xmax) * x_scale;
+                pys[i] = y_offset + clamp(vy, ymin, ymax) * y_scale;
+            }
+        }
+    }
+
+    bool axes::is_inside_draw_limits(double x, double y) const {
+        if (draw_polar_) {
+            const double r = std::max(y - draw_r_min_, 0.);
+            const double theta = x;
+            x = r * std::cos(theta);
+            y = r * std::sin(theta);
+        } else {
+            if (draw_x_log_) {
+                x = x > 0. ? std::log10(x) : NaN;
+            }
+            if (draw_y_log_) {
+                y = y > 0. ? std::log10(y) : NaN;
+            }
+        }
+        const auto &[xmin, xmax, ymin, ymax] = draw_limits_;
+        return x >= xmin && x <= xmax && y >= ymin && y <= ymax;
+    }
+
+    std::array<double, 2> axes::pixel_size() const {
+        const auto &[xmin, xmax, ymin, ymax] = draw_limits_;
+        const auto &[x1, x2, y1, y2] = draw_viewport_;
+        return {(xmax - xmin) / std::max(x2 - x1, 1.),
+                (ymax - ymin) / std::max(y2 - y1, 1.)};
+    }
+
+    void axes::draw_arrows(const std::vector<double> &x,
+                           const std::vector<double> &y,
+                           const std::vector<double> &u,
+                           const std::vector<double> &v,
+                           const std::array<float, 4> &color,
+                           float head_size, bool filled) {
+        const size_t n = std::min({x.size(), y.size(), u.size(), v.size()});
+        std::vector<double> x2(n);
+        std::vector<double> y2(n);
+        for (size_t i = 0; i < n; ++i) {
+            x2[i] = x[i] + u[i];
+            y2[i] = y[i] + v[i];
+        }
+        std::vector<double> px1;
+        std::vector<double> py1;
+        std::vector<double> px2;
+        std::vector<double> py2;
+        data_to_pixels(x, y, px1, py1);
+        data_to_pixels(x2, y2, px2, py2);
+
+        // Shafts and heads go in a single path, broken by NaNs
+        std::vector<double> path_x;
+        std::vector<double> path_y;
+        std::vector<double> head_x;
+        std::vector<double> head_y;
+        for (size_t i = 0; i < n; ++i) {
+            const double dx = px2[i] - px1[i];
+            const double dy = py2[i] - py1[i];
+            const double length = std::sqrt(dx * dx + dy * dy);
+            if (!std::isfinite(length)) {
+                continue;
+            }
+            path_x.insert(path_x.end(), {px1[i], px2[i], NaN});
+            path_y.insert(path_y.end(), {py1[i], py2[i], NaN});
+            if (length == 0.) {
+                continue;
+            }
+            // Head points behind the tip, on both sides of the shaft
+            const double ux = dx / length;
+            const double uy = dy / length;
+            const double back_x = px2[i] - head_size * ux;
+            const double back_y = py2[i] - head_size * uy;
+            const double side_x = -uy * head_size * 0.4;
+            const double side_y = ux * head_size * 0.4;
+            if (filled) {
+                head_x.insert(head_x.end(),
+                              {back_x + side_x, px2[i], back_x - side_x});
+                head_y.insert(head_y.end(),
+                              {back_y + side_y, py2[i], back_y - side_y});
+            } else {
+                path_x.insert(path_x.end(),
+                              {back_x + side_x, px2[i], back_x - side_x, NaN});
+                path_y.insert(path_y.end(),
+                              {back_y + side_y, py2[i], back_y - side_y, NaN});
+            }
+        }
+        if (!path_x.empty()) {
+            draw_pixel_path(path_x, path_y, color);
+        }
+        if (!head_x.empty()) {
+            draw_pixel_triangles(head_x, head_y, color);
+        }
+    }
+
+    void axes::draw_pixel_path(const std::vector<double> &x,
+                               const std::vector<double> &y,
+                               const std::array<float, 4> &color) {
+        if (recording_batch_) {
+            recording_batch_->add_path(x, y, color);
+        } else {
+            parent_->draw_path(x, y, color);
+        }
+    }
+
+    void axes::draw_pixel_triangles(const std::vector<double> &x,
+                                    const std::vector<double> &y,
+                                    const std::array<float, 4> &color) {
+        if (recording_batch_) {
+            recording_batch_->add_triangles(x, y, color);
+        } else {
+            parent_->draw_triangles(x, y, color);
+        }
+    }
+
+    void axes::draw_pixel_instances(
+        backend::vertex_batch::primitive type,
+        const std::vector<double> &mesh_x, const std::vector<double> &mesh_y,
+        const std::vector<double> &x, const std::vector<double> &y,
+        const std::vector<double> &sizes,
+        const std::vector<std::array<float, 4>> &colors) {
+        if (recording_batch_) {
+            recording_batch_->add_instances(type, mesh_x, mesh_y, x, y, sizes,
+                                            colors);
+        } else {
+            parent_->draw_instances(type, mesh_x, mesh_y, x, y, sizes,
+                                    colors);
+        }
+    }
+
+    void axes::draw_pixel_rectangle(double x1, double x2, double y1,
+                                    double y2,
+                                    const std::array<float, 4> &color) {
+        if (recording_batch_) {
+            recording_batch_->add_rectangle(x1, x2, y1, y2, color);
+        } else {
+            parent_->draw_rectangle(x1, x2, y1, y2, color);
+        }
+    }
+
+    void axes::draw_pixel_text(const std::string &text, double x, double y,
+                               float font_size,
+                               const std::array<float, 4> &color,
+                               double horizontal_alignment,
+                               double vertical_alignment, float angle) {
+        if (text.empty()) {
+            return;
+        }
+        // Move the anchor to the bottom left corner of the text,
+        // along the baseline and its normal
+        const unsigned font_height = font_height_in_pixels(font_size);
+        const auto &atlas = backend::glyph_atlas::shared(font_height);
+        const double dx = horizontal_alignment * atlas.text_width(text);
+        const double dy = vertical_alignment * font_height;
+        const double c = std::cos(angle * pi / 180.);
+        const double s = std::sin(angle * pi / 180.);
+        x -= dx * c - dy * s;
+        y -= dx * s + dy * c;
+        if (recording_batch_) {
+            recording_batch_->add_text(atlas, text, x, y, angle, color);
+        } else {
+            parent_->draw_text(text, x, y, font(),
+                               static_cast<float>(font_height), color, angle);
+        }
+    }
+
+    std::pair<double, double> axes::colormap_range(double data_min,
+                                                   double data_max) const {
+        if (cb_axis_.limits_mode_manual()) {
+            auto [cb_min, cb_max] = color_box_range();
+            if (cb_min < cb_max) {
+                return {cb_min, cb_max};
+            }
+        }
+        return {data_min, data_max};
+    }
+
+    void axes::draw_path(const std::vector<double> &x,
+                         const std::vector<double> &y,
+                         const std::array<float, 4> &color) {
+        data_to_pixels(x, y, pixel_x_, pixel_y_);
+        draw_pixel_path(pixel_x_, pixel_y_, color);
+    }
+
+    void axes::draw_triangles(const std::vector<double> &x,
+                              const std::vector<double> &y,
+                              const std::array<float, 4> &color) {
+        data_to_pixels(x, y, pixel_x_, pixel_y_);
+        draw_pixel_triangles(pixel_x_, pixel_y_, color);
+    }
+
+    void axes::draw_rectangle(double x1, double x2, double y1, double y2,
+                              const std::array<float, 4> &color) {
+        // Rectangles are areas, such as bars, so they are not projected
+        // on polar axes, and their non-positive sides on log axes go to
+        // the lower limit instead of breaking them
+        const auto [xmin, xmax, ymin, ymax] = draw_limits_;
+        const auto [vx1, vx2, vy1, vy2] = draw_viewport_;
+        auto to_pixel = [](double v, bool log, double lo, double hi,
+                           double p1, double p2) {
+            if (log) {
+                v = v > 0. ? std::log10(v) : lo;
+            }
+            v = std::min(std::max(v, lo), hi);
+            return p1 + (v - lo) * (p2 - p1) / (hi - lo);
+        };
+        const double px1 = to_pixel(x1, draw_x_log_, xmin, xmax, vx1, vx2);
+        const double px2 = to_pixel(x2, draw_x_log_, xmin, xmax, vx1, vx2);
+        const double py1 = to_pixel(y1, draw_y_log_, ymin, ymax, vy1, vy2);
+        const double py2 = to_pixel(y2, draw_y_log_, ymin, ymax, vy1, vy2);
+        if (!std::isfinite(px1) || !std::isfinite(px2) ||
+            !std::isfinite(py1) || !std::isfinite(py2)) {
+            return;
+        }
+        draw_pixel_rectangle(std::min(px1, px2), std::max(px1, px2),
+                             std::min(py1, py2), std::max(py1, py2), color);
+    }
+
+    void axes::draw_text(double x, double y, const std::string &text,
+                         float font_size, const std::array<float, 4> &color,
+                         double horizontal_alignment,
+                         double vertical_alignment, float angle) {
+        if (!is_inside_draw_limits(x, y)) {
+            return;
+        }
+        std::vector<double> px;
+        std::vector<double> py;
+        data_to_pixels({x}, {y}, px, py);
+        draw_pixel_text(text, px[0], py[0], font_size, color,
+                        horizontal_alignment, vertical_alignment, angle);
+    }
+
+    namespace {
+        /// Outline of a marker with radius 1, or the pairs of
+        /// points of its segments if the marker is made of strokes
+        struct marker_shape {
+            std::vector<double> x;
+            std::vector<double> y;
+            bool strokes{false};
+        };
+
+        marker_shape regular_polygon(size_t n, double rotation,
+                                     double inner_radius = 1.) {
+            // Stars alternate between the outer and inner radius
+            const bool star = inner_radius != 1.;
+            const size_t n_points = star ? 2 * n : n;
+            marker_shape shape;
+            for (size_t i = 0; i < n_points; ++i) {
+                const double r = star && i % 2 == 1 ? inner_radius : 1.;
+                const double a = rotation + 2. * pi * i / n_points;
+                shape.x.emplace_back(r * std::cos(a));
+                shape.y.emplace_back(r * std::sin(a));
+            }
+            return shape;
+        }
+
+        marker_shape shape_of(enum line_spec::marker_style marker) {
+            using ms = enum line_spec::marker_style;
+            const double d = std::sqrt(0.5);
+            switch (marker) {
+            case ms::circle:
+            case ms::point:
+                return regular_polygon(16, 0.);
+            case ms::square:
+                return regular_polygon(4, pi / 4);
+            case ms::diamond:
+                return regular_polygon(4, 0.);
+            case ms::upward_pointing_triangle:
+                return regular_polygon(3, pi / 2);
+            case ms::downward_pointing_triangle:
+                return regular_polygon(3, -pi / 2);
+            case ms::right_pointing_triangle:
+                return regular_polygon(3, 0.);
+            case ms::left_pointing_triangle:
+                return regular_polygon(3, pi);
+            case ms::pentagram:
+                return regular_polygon(5, pi / 2, 0.4);
+            case ms::hexagram:
+                return regular_polygon(6, pi / 2, 0.55);
+            case ms::plus_sign:
+                return {{-1, 1, 0, 0}, {0, 0, -1, 1}, true};
+            case ms::cross:
+                return {{-d, d, -d, d}, {-d, d, d, -d}, true};
+            case ms::asterisk:
+                return {{-1, 1, 0, 0, -d, d, -d, d},
+                        {0, 0, -1, 1, -d, d, d, -d},
+                        true};
+            default:
+                // Custom markers are text
+                return {};
+            }
+        }
+    } // namespace
+
+    void axes::draw_markers(const std::vector<double> &x,
+                            const std::vector<double> &y,
+                            enum line_spec::marker_style marker, float size,
+                            const std::array<float, 4> &edge_color,
+                            bool filled,
+                            const std::array<float, 4> &face_color) {
+        draw_markers(x, y, marker, std::vector<double>{size}, {edge_color},
+                     filled, {face_color});
+    }
+
+    void axes::draw_markers(
+        const std::vector<double> &x, const std::vector<double> &y,
+        enum line_spec::marker_style marker, const std::vector<double> &sizes,
+        const std::vector<std::array<float, 4>> &edge_colors, bool filled,
+        const std::vector<std::array<float, 4>> &face_colors) {
+        if (sizes.empty() || edge_colors.empty()) {
+            return;
+        }
+        // Markers whose centers are inside the axes, with their own
+        // sizes and colors if there is more than one
+        std::vector<double> cx;
+        std::vector<double> cy;
+        std::vector<double> kept_sizes;
+        std::vector<std::array<float, 4>> edges;
+        std::vector<std::array<float, 4>> faces;
+        const size_t n = std::min(x.size(), y.size());
+        for (size_t i = 0; i < n; ++i) {
+            if (!is_inside_draw_limits(x[i], y[i])) {
+                continue;
+            }
+            cx.emplace_back(x[i]);
+            cy.emplace_back(y[i]);
+            if (sizes.size() > 1 || kept_sizes.empty()) {
+                kept_sizes.emplace_back(sizes[std::min(i, sizes.size() - 1)]);
+            }
+            if (edge_colors.size() > 1 || edges.empty()) {
+                edges.emplace_back(
+                    edge_colors[std::min(i, edge_colors.size() - 1)]);
+            }
+            if (!face_colors.empty() &&
+                (face_colors.size() > 1 || faces.empty())) {
+                faces.emplace_back(
+                    face_colors[std::min(i, face_colors.size() - 1)]);
+            }
+        }
+        if (cx.empty()) {
+            return;
+        }
+        std::vector<double> px;
+        std::vector<double> py;
+        data_to_pixels(cx, cy, px, py);
+        draw_pixel_markers(px, py, marker, kept_sizes, edges, filled, faces);
+    }
+
+    void axes::draw_pixel_markers(
+        const std::vector<double> &x, const std::vector<double> &y,
+        enum line_spec::marker_style marker, const std::vector<double> &sizes,
+        const std::vector<std::array<float, 4>> &edge_colors, bool filled,
+        const std::vector<std::array<float, 4>> &face_colors) {
+        marker_shape shape = shape_of(marker);
+        if (shape.x.empty() || x.empty() || sizes.empty() ||
+            edge_colors.empty()) {
+            return;
+        }
+        // The template has radius 1, so the scale of each
+        // instance is its radius
+        double radius_factor = 0.5;
+        if (marker == line_spec::marker_style::point) {
+            // Points are small filled circles
+            radius_factor /= 3.;
+            filled = true;
+        }
+        filled = filled && !shape.strokes && !face_colors.empty();
+        std::vector<double> radii(sizes.size());
+        for (size_t i = 0; i < sizes.size(); ++i) {
+            radii[i] = radius_factor * sizes[i];
+        }
+
+        // One template for the faces and one for the edges.
+        // Batches draw all markers of each template at once.
+        using primitive = backend::vertex_batch::primitive;
+        const size_t m = shape.x.size();
+        if (filled) {
+            // Our shapes are star-shaped around the center,
+            // so a fan of triangles covers them
+            std::vector<double> mesh_x;
+            std::vector<double> mesh_y;
+            for (size_t j = 0; j < m; ++j) {
+                const size_t k = (j + 1) % m;
+                mesh_x.insert(mesh_x.end(), {0., shape.x[j], shape.x[k]});
+                mesh_y.insert(mesh_y.end(), {0., shape.y[j], shape.y[k]});
+            }
+            draw_pixel_instances(primitive::triangles, mesh_x, mesh_y, x, y,
+                                 radii, face_colors);
+        }
+        if (shape.strokes) {
+            draw_pixel_instances(primitive::lines, shape.x, shape.y, x, y,
+                                 radii, edge_colors);
+        } else if (!filled || edge_colors != face_colors) {
+            // Edges come after all faces. If they have the color of
+            // the faces, they would only show over other markers.
+            std::vector<double> mesh_x;
+            std::vector<double> mesh_y;
+            for (size_t j = 0; j < m; ++j) {
+                const size_t k = (j + 1) % m;
+                mesh_x.insert(mesh_x.end(), {shape.x[j], shape.x[k]});
+                mesh_y.insert(mesh_y.end(), {shape.y[j], shape.y[k]});
+            }
+            draw_pixel_instances(primitive::lines, mesh_x, mesh_y, x, y,
+                                 radii, edge_colors);
+        }
+    }
+
+    void axes::draw_markers(const std::vector<double> &x,
+                            const std::vector<double> &y,
+                            const class line_spec &style) {
+        draw_markers(x, y, style.marker_style(), style.marker_size(),
+                     style.marker_color(), style.marker_face(),
+                     style.marker_face_color());
     }
 
 } // namespace matplot
\ No newline at end of file
@@ -7,6 +7,7 @@
 
 #include <optional>
 
+#include <matplot/backend/vertex_batch.h>
 #include <matplot/util/colors.h>
 #include <matplot/util/handle_types.h>
 #include <matplot/util/keywords.h>
@@ -48,6 +49,11 @@ namespace matplot {
         /// Touch parent figure
         void touch();
 
+        /// Number of times the axes or any of its objects were touched
+        /// The commands of the axes can be reused while this
+        /// does not change
+        size_t revision() const;
+
         /// Put an object in the axes
         void emplace_object(axes_object_handle obj);
 
@@ -63,6 +69,11 @@ namespace matplot {
         void run_commands();
         void run_draw_commands();
 
+        /// Run the draw commands, recording the primitives in a batch
+        /// rather than sending them to the parent figure. Axes that
+        /// record their own batches can be drawn concurrently.
+        void run_draw_commands(backend::vertex_batch &batch);
+
         /// Run command on the parent figure
         void run_command(const std::string &command);
 
@@ -982,7 +993,15 @@ namespace matplot {
 
         using implicit_function_type = std::function<double(double, double)>;
 
+        /// True if fimplicit and fcontour call their function from
+        /// several threads at once
+        /// This is false by default because the function might not be
+        /// safe to call concurrently.
+        bool parallel_evaluation() const;
+        void parallel_evaluation(bool parallel_evaluation);
+
         /// Implicit lambda function line plot (one-level={0} contour)
+        /// The function is sampled on a grid refined around the line.
         line_handle
         fimplicit(implicit_function_type equation,
                   const std::array<double, 4> &xy_interval = {-5, 5, -5, 5},
@@ -1381,6 +1400,7 @@ namespace matplot {
 
         /// Lambda function contour - Manual levels (or empty list for
         /// automatic) / Manual number of levels (or 0 for automatic)
+        /// The function is sampled on a grid refined around the levels.
         contours_handle fcontour(fcontour_function_type fn,
                                  const std::array<double, 4> &xy_range,
                                  std::vector<double> levels = {},
@@ -2695,6 +2715,14 @@ namespace matplot {
         void run_unset_objects_command();
         void run_empty_plot_command();
 
+        // Send text or binary data to the parent figure,
+        // recording it if we are caching the commands
+        void run_figure_command(const std::string &text, bool binary);
+        // Send the data of a child to the parent figure
+        void run_data_command(const axes_object_handle &child);
+        // Send the commands recorded in the last draw again
+        void run_cached_commands();
+
       private /* run draw commands */:
         void run_background_draw_commands();
         void run_title_draw_commands();
@@ -2716,6 +2744,126 @@ namespace matplot {
                                  const std::vector<double> &y,
                                  const std::array<float, 4> &color);
 
+        /// \brief Draw filled triangles
+        /// Each three points are a triangle.
+        void draw_triangles(const std::vector<double> &x,
+                            const std::vector<double> &y,
+                            const std::array<float, 4> &color);
+
+        /// \brief Draw a filled rectangle
+        /// Rectangles are not projected on polar axes. On log axes,
+        /// sides at non-positive values are at the lower limit.
+        void draw_rectangle(double x1, double x2, double y1, double y2,
+                            const std::array<float, 4> &color);
+
+        /// \brief Draw markers centered at the points
+        /// The size is the diameter of the markers in pixels.
+        /// Markers whose centers are outside the axes are not drawn.
+        void draw_markers(const std::vector<double> &x,
+                          const std::vector<double> &y,
+                          enum line_spec::marker_style marker, float size,
+                          const std::array<float, 4> &edge_color,
+                          bool filled = false,
+                          const std::array<float, 4> &face_color = {});
+
+        /// \brief Draw markers with a size and colors for each point
+        /// Points past the end of sizes or colors use their last
+        /// element. Backends that draw batches get a single template
+        /// for all markers, with the position, size and color of
+        /// each marker as an instance.
+        void draw_markers(const std::vector<double> &x,
+                          const std::vector<double> &y,
+                          enum line_spec::marker_style marker,
+                          const std::vector<double> &sizes,
+                          const std::vector<std::array<float, 4>> &edge_colors,
+                          bool filled,
+                          const std::vector<std::array<float, 4>> &face_colors);
+
+        /// \brief Draw the markers of a line_spec at the points
+        void draw_markers(const std::vector<double> &x,
+                          const std::vector<double> &y,
+                          const class line_spec &style);
+
+        /// \brief Draw a line of text anchored at (x, y)
+        /// The font size is in points. The alignments place the
+        /// anchor on the text: 0 is the left or bottom, 0.5 is
+        /// the center, and 1 is the right or top. The angle rotates
+        /// the text around the anchor, in degrees counterclockwise.
+        /// Text whose anchor is outside the axes is not drawn.
+        void draw_text(double x, double y, const std::string &text,
+                       float font_size, const std::array<float, 4> &color,
+                       double horizontal_alignment = 0.5,
+                       double vertical_alignment = 0.5, float angle = 0.f);
+
+        /// \brief Draw arrows from (x, y) to (x + u, y + v)
+        /// The size of the heads is in pixels.
+        void draw_arrows(const std::vector<double> &x,
+                         const std::vector<double> &y,
+                         const std::vector<double> &u,
+                         const std::vector<double> &v,
+                         const std::array<float, 4> &color,
+                         float head_size = 8.f, bool filled = false);
+
+        /// \brief Range of values the colormap represents while drawing
+        /// This is the range of the color box if the user set it, or
+        /// [data_min, data_max] otherwise.
+        std::pair<double, double> colormap_range(double data_min,
+                                                 double data_max) const;
+
+        /// \brief Size of a pixel in data units {x, y}
+        /// On log axes, the size is in units of the log of the data.
+        /// Objects use this for elements whose size is defined on
+        /// the screen, such as error bar caps and arrow heads, and
+        /// to choose how much detail to draw. Gnuplot backends get
+        /// the size of a pixel of the 2D view.
+        std::array<double, 2> pixel_size() const;
+
+      private /* transform data to the screen */:
+        /// Calculate the limits and the viewport for this frame
+        void update_draw_transform();
+
+        /// Convert points to pixels in a single pass
+        /// Points are projected on polar axes, and we use their log
+        /// on log axes. They are then clamped to the limits.
+        void data_to_pixels(const std::vector<double> &x,
+                            const std::vector<double> &y,
+                            std::vector<double> &px,
+                            std::vector<double> &py) const;
+
+        /// True if the point is inside the limits, after the log
+        /// or polar transform of the axes
+        bool is_inside_draw_limits(double x, double y) const;
+
+        /// Draw primitives in pixel coordinates, on the batch we are
+        /// recording or on the parent figure
+        void draw_pixel_path(const std::vector<double> &x,
+                             const std::vector<double> &y,
+                             const std::array<float, 4> &color);
+        void draw_pixel_triangles(const std::vector<double> &x,
+                                  const std::vector<double> &y,
+                                  const std::array<float, 4> &color);
+        void draw_pixel_rectangle(double x1, double x2, double y1, double y2,
+                                  const std::array<float, 4> &color);
+        void draw_pixel_text(const std::string &text, double x, double y,
+                             float font_size,
+                             const std::array<float, 4> &color,
+                             double horizontal_alignment,
+                             double vertical_alignment, float angle = 0.f);
+        void draw_pixel_markers(
+            const std::vector<double> &x, const std::vector<double> &y,
+            enum line_spec::marker_style marker,
+            const std::vector<double> &sizes,
+            const std::vector<std::array<float, 4>> &edge_colors, bool filled,
+            const std::vector<std::array<float, 4>> &face_colors);
+        void
+        draw_pixel_instances(backend::vertex_batch::primitive type,
+                             const std::vector<double> &mesh_x,
+                             const std::vector<double> &mesh_y,
+                             const std::vector<double> &x,
+                             const std::vector<double> &y,
+                             const std::vector<double> &sizes,
+                             const std::vector<std::array<float, 4>> &colors);
+
       private /* members */:
         // axes
         class axis x_axis_ {
@@ -2792,6 +2940,9 @@ namespace matplot {
 
         // complete box around the axes
         bool box_{true};
+
+        // Whether fimplicit and fcontour evaluate in parallel
+        bool parallel_evaluation_{false};
         bool box_full_{false};
         std::array<float, 4> box_color_{.0, .0, .0, .0};
 
@@ -2836,6 +2987,38 @@ namespace matplot {
         // we don't need a shared_ptr here because there is no
         // relationship of ownership
         class figure *parent_;
+
+        // dirty tracking
+        size_t revision_{0};
+        // Commands sent in the last draw. An entry with a data source
+        // stands for the data of that object, which caches it itself.
+        struct cached_command {
+            std::string text;
+            bool binary{false};
+            axes_object_handle data_source{nullptr};
+        };
+        std::vector<cached_command> commands_cache_;
+        // We store revision + 1, so zero means there is no cache
+        size_t commands_cache_revision_{0};
+        std::string commands_cache_context_;
+        bool recording_commands_{false};
+
+        // Data limits {xmin, xmax, ymin, ymax} and viewport
+        // {x1, x2, y1, y2} in pixels of the frame we are drawing.
+        // The limits of log axes are the log of the data limits.
+        std::array<double, 4> draw_limits_{-10, +10, -10, +10};
+        std::array<double, 4> draw_viewport_{0, 1, 0, 1};
+        bool draw_x_log_{false};
+        bool draw_y_log_{false};
+        bool draw_polar_{false};
+        double draw_r_min_{0.};
+
+        // Pixels of the last path, reused between paths
+        std::vector<double> pixel_x_;
+        std::vector<double> pixel_y_;
+
+        // Batch we record primitives to, if any
+        backend::vertex_batch *recording_batch_{nullptr};
     };
 
 } // namespace matplot
@@ -28,7 +28,12 @@ namespace matplot {
         return parent_;
     }
 
-    void axes_object::touch() { parent_->touch(); }
+    void axes_object::touch() {
+        ++revision_;
+        parent_->touch();
+    }
+
+    size_t axes_object::revision() const { return revision_; }
 
     void axes_object::parent(class axes *&parent) { parent_ = parent; }
 
@@ -36,6 +41,101 @@ namespace matplot {
 
     std::string axes_object::set_variables_string() { return ""; }
 
+    bool axes_object::supports_binary_data() { return false; }
+
+    bool axes_object::use_binary_data() {
+        return supports_binary_data() &&
+               parent_->parent()->backend()->binary_data();
+    }
+
+    std::string axes_object::binary_data_string() { return ""; }
+
+    bool axes_object::use_binary_data_files() {
+        return use_binary_data() &&
+               parent_->parent()->backend()->binary_data_files();
+    }
+
+    bool axes_object::data_is_self_contained() { return false; }
+
+    std::string axes_object::data_cache_key() { return ""; }
+
+    const std::string &axes_object::cached_data_string(bool binary) {
+        const int format =
+            binary ? (binary_data_single_precision() ? 2 : 1) : 0;
+        const int precision = binary ? 0 : text_data_precision();
+        std::string key = data_cache_key();
+        // We store revision + 1, so zero means there is no cache
+        if (data_cache_revision_ != revision_ + 1 ||
+            data_cache_format_ != format ||
+            data_cache_precision_ != precision || data_cache_key_ != key) {
+            data_cache_ = binary ? binary_data_string() : data_string();
+            data_cache_revision_ = revision_ + 1;
+            data_cache_format_ = format;
+            data_cache_precision_ = precision;
+            data_cache_key_ = std::move(key);
+        }
+        return data_cache_;
+    }
+
+    std::string axes_object::binary_data_file() {
+        auto &backend = parent_->parent()->backend();
+        const std::string key =
+            num2str(reinterpret_cast<std::uintptr_t>(this));
+        const bool single_precision = binary_data_single_precision();
+        std::string data_key = data_cache_key();
+        // We store revision + 1, so zero means we never wrote the file.
+        // New objects at the address of old objects don't reuse their files.
+        const bool file_is_up_to_date =
+            binary_data_file_revision_ == revision_ + 1 &&
+            binary_data_file_single_precision_ == single_precision &&
+            binary_data_file_key_ == data_key;
+        if (file_is_up_to_date) {
+            std::string path = backend->binary_data_file(key);
+            if (!path.empty()) {
+                return path;
+            }
+        }
+        binary_data_file_revision_ = revision_ + 1;
+        binary_data_file_single_precision_ = single_precision;
+        binary_data_file_key_ = std::move(data_key);
+        return backend->write_binary_data_file(key, binary_data_string());
+    }
+
+    std::string axes_object::binary_format_string(size_t n_records,
+                                                  size_t n_columns,
+                                                  size_t skip_bytes) {
+        const std::string value_format =
+            binary_data_single_precision() ? "%float32" : "%float64";
+        std::string format;
+        for (size_t i = 0; i < n_columns; ++i) {
+            format += value_format;
+        }
+        std::string res = " binary record=" + num2str(n_records);
+        if (skip_bytes != 0) {
+            res += " skip=" + num2str(skip_bytes);
+        }
+        return res + " format=\"" + format + "\"";
+    }
+
+    bool axes_object::binary_data_single_precision() {
+        return parent_->parent()->backend()->binary_data_single_precision();
+    }
+
+    int axes_object::text_data_precision() {
+        return parent_->parent()->backend()->text_data_precision();
+    }
+
+    void axes_object::append_binary_value(std::string &data, double value,
+                                          bool single_precision) {
+        if (single_precision) {
+            const float v = static_cast<float>(value);
+            data.append(reinterpret_cast<const char *>(&v), sizeof(float));
+        } else {
+            data.append(reinterpret_cast<const char *>(&value),
+                        sizeof(double));
+        }
+    }
+
     std::string axes_object::legend_string(const std::string &title) {
         return "keyentry with boxes title \"" + escape(title) + "\"";
     }
@@ -109,4 +209,11 @@ namespace matplot {
 
     void axes_object::run_draw_commands() {}
 
+    line_spec axes_object::legend_line_spec() {
+        line_spec spec;
+        spec.line_style(line_spec::line_style::none);
+        spec.marker_style(line_spec::marker_style::none);
+        return spec;
+    }
+
 } // namespace matplot
\ No newline at end of file
@@ -11,11 +11,14 @@
 
 namespace matplot {
     class axes;
+    class line_spec;
     using axes_handle = std::shared_ptr<class axes>;
 
     /// Abstract class for the objects we put in the xlim
     class axes_object {
       public:
+        friend class axes;
+
         enum class axes_category {
             two_dimensional,
             three_dimensional,
@@ -47,6 +50,10 @@ namespace matplot {
       public /* for the backend */:
         virtual void run_draw_commands();
 
+        // Style of the sample next to the legend entry of this object
+        // By default, the entry has no sample.
+        virtual line_spec legend_line_spec();
+
       public /* for gnuplot backend only */:
         virtual std::string set_variables_string();
 
@@ -69,22 +76,90 @@ namespace matplot {
         virtual std::string data_string();
         virtual std::string unset_variables_string();
 
+        // True if this object can send its data as inline binary records
+        virtual bool supports_binary_data();
+
+        // True if the object supports binary data and the backend wants it
+        bool use_binary_data();
+
+        // Raw records for the inline binary data blocks of this object
+        // This replaces data_string() when use_binary_data() is true
+        virtual std::string binary_data_string();
+
+        // True if the plot command references the binary data in a file
+        // In this case, the object sends no data through the pipe
+        bool use_binary_data_files();
+
+        // True if data_string() and binary_data_string() only depend on
+        // the object itself and on data_cache_key(). In this case, they
+        // can be reused until the object is touched.
+        virtual bool data_is_self_contained();
+
+        // Anything other than the object that its data depends on
+        // Cached data (and binary data files) are only reused while
+        // this does not change.
+        virtual std::string data_cache_key();
+
+        // data_string() or binary_data_string(), reusing the last
+        // result if the object did not change since then
+        const std::string &cached_data_string(bool binary);
+
       public:
         const class axes *parent() const;
         class axes *&parent();
         void parent(class axes *&parent);
         void touch();
 
+        // Number of times this object has been touched
+        // Caches derived from this object are valid while
+        // the revision does not change
+        size_t revision() const;
+
         // Objects might have their own display name
         // In this case, we use the display name for legends
         // instead of the strings in the legends object
         const std::string &display_name() const;
         void display_name(const std::string &display_name);
 
+      protected:
+        // The `binary record=... format=...` part of a plot command
+        std::string binary_format_string(size_t n_records, size_t n_columns,
+                                         size_t skip_bytes = 0);
+
+        // Path of the file with the binary_data_string() of this object
+        // The file is only rewritten if the object changed since
+        // the last time we wrote it
+        std::string binary_data_file();
+
+        // True if the backend expects float32 rather than float64 records
+        bool binary_data_single_precision();
+
+        // Significant digits the backend wants in text data
+        // data_string() should format its numbers with a
+        // text_writer with this precision
+        int text_data_precision();
+
+        // Append a value to a binary data block in the format
+        // described by binary_format_string
+        static void append_binary_value(std::string &data, double value,
+                                        bool single_precision);
+
       protected:
         std::string tag_{"axes_object"};
         std::string display_name_{""};
         class axes *parent_;
+
+      private:
+        size_t revision_{0};
+        size_t binary_data_file_revision_{0};
+        bool binary_data_file_single_precision_{false};
+        std::string binary_data_file_key_;
+        std::string data_cache_;
+        size_t data_cache_revision_{0};
+        std::string data_cache_key_;
+        // 0: text, 1: float64 records, 2: float32 records
+        int data_cache_format_{0};
+        int data_cache_precision_{0};
     };
 
 } // namespace matplot
@@ -0,0 +1,117 @@
+#include <algorithm>
+#include <exception>
+#include <matplot/core/batch_exporter.h>
+#include <matplot/core/figure.h>
+
+namespace matplot {
+    batch_exporter::batch_exporter(size_t n_threads) {
+        if (n_threads == 0) {
+            n_threads = std::max(std::thread::hardware_concurrency(), 1u);
+        }
+        for (size_t i = 0; i < n_threads; ++i) {
+            threads_.emplace_back([this] { worker_loop(); });
+        }
+    }
+
+    batch_exporter::~batch_exporter() {
+        {
+            std::lock_guard<std::mutex> lock(jobs_mutex_);
+            stop_ = true;
+        }
+        jobs_available_.notify_all();
+        for (auto &thread : threads_) {
+            thread.join();
+        }
+    }
+
+    std::future<save_result> batch_exporter::save(figure_handle f,
+                                                  const std::string &filename,
+                                                  const std::string &format) {
+        auto job = std::make_shared<std::packaged_task<save_result()>>(
+            [this, f, filename, format] {
+                return run_job(f, filename, format);
+            });
+        std::future<save_result> result = job->get_future();
+        {
+            std::lock_guard<std::mutex> lock(jobs_mutex_);
+            jobs_.emplace([job] { (*job)(); });
+        }
+        jobs_available_.notify_one();
+        return result;
+    }
+
+    std::vector<save_result> batch_exporter::save(
+        const std::vector<std::pair<figure_handle, std::string>> &jobs) {
+        std::vector<std::future<save_result>> futures;
+        futures.reserve(jobs.size());
+        for (const auto &[f, filename] : jobs) {
+            futures.emplace_back(save(f, filename));
+        }
+        std::vector<save_result> results;
+        results.reserve(futures.size());
+        for (auto &future : futures) {
+            results.emplace_back(future.get());
+        }
+        return results;
+    }
+
+    size_t batch_exporter::n_threads() const { return threads_.size(); }
+
+    save_result batch_exporter::run_job(const figure_handle &f,
+                                        const std::string &filename,
+                                        const std::string &format) {
+        save_result result{filename, ""};
+        if (!f) {
+            result.error = "There is no figure to save";
+            return result;
+        }
+        // Elements of a map do not move, so the mutex stays where it
+        // is until we remove it
+        figure_mutex *m = nullptr;
+        {
+            std::lock_guard<std::mutex> lock(figure_mutexes_mutex_);
+            m = &figure_mutexes_[f.get()];
+            ++m->n_jobs;
+        }
+        {
+            std::lock_guard<std::mutex> lock(m->mutex);
+            try {
+                f->save_or_throw(filename, format);
+            } catch (const std::exception &e) {
+                result.error = e.what();
+            } catch (...) {
+                result.error = "Unknown error saving " + filename;
+            }
+        }
+        std::lock_guard<std::mutex> lock(figure_mutexes_mutex_);
+        if (--m->n_jobs == 0) {
+            figure_mutexes_.erase(f.get());
+        }
+        return result;
+    }
+
+    void batch_exporter::worker_loop() {
+        while (true) {
+            std::function<void()> job;
+            {
+                std::unique_lock<std::mutex> lock(jobs_mutex_);
+                jobs_available_.wait(
+                    lock, [this] { return stop_ || !jobs_.empty(); });
+                if (jobs_.empty()) {
+                    // stop_ is true and there is nothing else to do
+                    return;
+                }
+                job = std::move(jobs_.front());
+                jobs_.pop();
+            }
+            job();
+        }
+    }
+
+    std::future<save_result> save_async(figure_handle f,
+                                        const std::string &filename,
+                                        const std::string &format) {
+        static batch_exporter default_exporter;
+        return default_exporter.save(std::move(f), filename, format);
+    }
+} // namespace matplot
@@ -0,0 +1,100 @@
+#ifndef MATPLOTPLUSPLUS_BATCH_EXPORTER_H
+#define MATPLOTPLUSPLUS_BATCH_EXPORTER_H
+
+#include <condition_variable>
+#include <functional>
+#include <future>
+#include <map>
+#include <matplot/util/handle_types.h>
+#include <mutex>
+#include <queue>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+namespace matplot {
+    /// Result of saving a figure to a file
+    struct save_result {
+        /// File we tried to save
+        std::string filename;
+
+        /// Why we could not save the file (empty if we saved it)
+        std::string error;
+
+        /// True if we saved the file
+        explicit operator bool() const { return error.empty(); }
+    };
+
+    /// \class batch_exporter
+    /// Save many figures concurrently on a pool of threads.
+    ///
+    /// Each thread drives the backend of the figure it is saving,
+    /// so figures with gnuplot backends are rendered by their own
+    /// gnuplot processes in parallel (or by the shared processes,
+    /// if backend::gnuplot::shared_processes() is not zero).
+    ///
+    /// Saves of the same figure run one after the other, but a figure
+    /// should not be changed until all of its saves are done.
+    class batch_exporter {
+      public:
+        /// \brief Create an exporter with n_threads threads
+        /// If n_threads is zero, we use one thread per core.
+        explicit batch_exporter(size_t n_threads = 0);
+
+        batch_exporter(batch_exporter const &) = delete;
+        void operator=(batch_exporter const &) = delete;
+
+        /// \brief Wait for all saves and stop the threads
+        ~batch_exporter();
+
+        /// \brief Save a figure on one of the threads
+        /// If the format is empty, it is inferred from the extension.
+        std::future<save_result> save(figure_handle f,
+                                      const std::string &filename,
+                                      const std::string &format = "");
+
+        /// \brief Save many figures and wait for all of them
+        /// \return The result for each job, in the same order
+        std::vector<save_result>
+        save(const std::vector<std::pair<figure_handle, std::string>> &jobs);
+
+        /// \brief Number of threads saving figures
+        size_t n_threads() const;
+
+      private:
+        /// Save a figure, holding the lock of this figure
+        save_result run_job(const figure_handle &f,
+                            const std::string &filename,
+                            const std::string &format);
+
+        /// Threads take jobs from the queue until we stop
+        void worker_loop();
+
+      private:
+        std::vector<std::thread> threads_;
+        std::queue<std::function<void()>> jobs_;
+        std::mutex jobs_mutex_;
+        std::condition_variable jobs_available_;
+        bool stop_{false};
+
+        // One mutex for each figure, so saves of the
+        // same figure do not run concurrently. We remove it when
+        // the last job of the figure finishes, so a new figure at
+        // the same address gets a new mutex.
+        struct figure_mutex {
+            std::mutex mutex;
+            size_t n_jobs{0};
+        };
+        std::map<const class figure *, figure_mutex> figure_mutexes_;
+        std::mutex figure_mutexes_mutex_;
+    };
+
+    /// \brief Save a figure on a thread of the default batch exporter
+    std::future<save_result> save_async(figure_handle f,
+                                        const std::string &filename,
+                                        const std::string &format = "");
+
+} // namespace matplot
+
+#endif // MATPLOTPLUSPLUS_BATCH_EXPORTER_H
@@ -3,11 +3,16 @@
 //
 
 #include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <future>
 #include <map>
 #include <matplot/backend/backend_registry.h>
+#include <matplot/backend/glyph_atlas.h>
 #include <matplot/core/axes.h>
 #include <matplot/core/figure.h>
 #include <matplot/util/common.h>
+#include <matplot/util/thread_pool.h>
 #include <sstream>
 
 namespace matplot {
@@ -36,6 +41,10 @@ namespace matplot {
         backend_->run_command(command);
     }
 
+    void figure::run_binary_data(const std::string &data) {
+        backend_->run_binary_data(data);
+    }
+
     void figure::draw() {
         // we cannot call draw if we are already drawing
         // this could create infinite loops
@@ -43,6 +52,13 @@ namespace matplot {
             return;
         }
 
+        // Gnuplot keeps showing the last plot, so there is nothing
+        // to send if nothing changed since then
+        if (incremental_redraw_ && backend_->consumes_gnuplot_commands() &&
+            !changed_since_last_draw()) {
+            return;
+        }
+
         // Avoid infinite loops if the draw function calls
         // "touch" for some reason
         is_plotting_ = true;
@@ -57,7 +73,13 @@ namespace matplot {
         } else {
             send_gnuplot_draw_commands();
         }
-        backend_->render_data();
+        rendered_ = backend_->render_data();
+
+        drawn_context_ = draw_context();
+        drawn_axes_.clear();
+        for (const auto &axes : children_) {
+            drawn_axes_.emplace_back(axes.get(), axes->revision());
+        }
 
         is_plotting_ = false;
     }
@@ -66,17 +88,262 @@ namespace matplot {
         // This mode is not completely implemented yet
         // We'll get there little by little
 
+        // Record the primitives of the axes in a single batch
+        // if the backend can draw it at once
+        const bool batches = backend_->supports_vertex_batch();
+        vertex_batch_.clear();
+
+        // Incremental redraws keep the batch of each axes. If only
+        // some axes changed, the backend keeps the last frame and
+        // repaints the regions of these axes.
+        const bool keep_axes_batches = batches && incremental_redraw_ &&
+                                       backend_->supports_partial_repaint();
+        if (keep_axes_batches && axes_batches_kept_ && only_axes_changed()) {
+            repaint_changed_axes();
+            return;
+        }
+        axes_batches_kept_ = false;
+
         // Tell the backend we're starting a new frame
         // Draw background
         backend_->draw_background(color_);
+        batching_ = batches;
+
+        const bool parallel = batching_ && parallel_tessellation_ &&
+                              children_.size() > 1 &&
+                              thread_pool::shared().n_threads() > 1;
+        if (parallel || keep_axes_batches) {
+            std::vector<size_t> all_axes(children_.size());
+            for (size_t i = 0; i < all_axes.size(); ++i) {
+                all_axes[i] = i;
+            }
+            record_axes_batches(all_axes);
+            for (const auto &batch : axes_batches_) {
+                vertex_batch_.append(batch);
+            }
+            axes_batches_kept_ = keep_axes_batches;
+        } else {
+            // Iterate children axes
+            for (const auto &ax : children_) {
+                ax->run_draw_commands();
+            }
+        }
 
-        // Iterate children axes
-        for (const auto &ax : children_) {
-            ax->run_draw_commands();
+        if (batching_) {
+            batching_ = false;
+            backend_->draw_batch(vertex_batch_);
         }
+    }
 
-        // Finalize
-        backend_->render_data();
+    void figure::record_axes_batches(const std::vector<size_t> &indices) {
+        axes_batches_.resize(children_.size());
+        axes_bounds_.resize(children_.size());
+        const bool parallel = parallel_tessellation_ && indices.size() > 1 &&
+                              thread_pool::shared().n_threads() > 1;
+        if (parallel) {
+            // Each axes records its own batch on the thread pool.
+            // The batches are merged in order, so the axes are drawn
+            // in the same order as they would be one by one.
+            std::vector<std::future<void>> futures;
+            futures.reserve(indices.size());
+            for (size_t i : indices) {
+                axes_batches_[i].clear();
+                futures.emplace_back(thread_pool::shared().submit(
+                    [ax = children_[i].get(), batch = &axes_batches_[i]] {
+                        ax->run_draw_commands(*batch);
+                    }));
+            }
+            // Wait for all tasks before rethrowing any exception,
+            // because the tasks use the axes
+            for (auto &future : futures) {
+                future.wait();
+            }
+            for (auto &future : futures) {
+                future.get();
+            }
+        } else {
+            for (size_t i : indices) {
+                axes_batches_[i].clear();
+                children_[i]->run_draw_commands(axes_batches_[i]);
+            }
+        }
+        for (size_t i : indices) {
+            axes_bounds_[i] = axes_batches_[i].bounds();
+        }
+    }
+
+    namespace {
+        using region = std::array<double, 4>;
+
+        bool intersects(const region &a, const region &b) {
+            return a[0] <= b[1] && b[0] <= a[1] && a[2] <= b[3] &&
+                   b[2] <= a[3];
+        }
+
+        /// Add a region to a list of disjoint regions, merging it
+        /// with the regions it intersects
+        void add_region(std::vector<region> &regions, region r,
+                        double width, double height) {
+            // Whole pixels, with a pixel around the primitives
+            // for the rounding of the rasterizer
+            r = {std::max(std::floor(r[0]) - 1., 0.),
+                 std::min(std::ceil(r[1]) + 1., width),
+                 std::max(std::floor(r[2]) - 1., 0.),
+                 std::min(std::ceil(r[3]) + 1., height)};
+            if (!(r[0] < r[1] && r[2] < r[3])) {
+                return;
+            }
+            for (auto it = regions.begin(); it != regions.end();) {
+                if (intersects(*it, r)) {
+                    r = {std::min(r[0], (*it)[0]), std::max(r[1], (*it)[1]),
+                         std::min(r[2], (*it)[2]), std::max(r[3], (*it)[3])};
+                    regions.erase(it);
+                    // The larger region might touch the others now
+                    it = regions.begin();
+                } else {
+                    ++it;
+                }
+            }
+            regions.emplace_back(r);
+        }
+    } // namespace
+
+    bool figure::only_axes_changed() {
+        if (drawn_context_ != draw_context() ||
+            drawn_axes_.size() != children_.size() ||
+            axes_batches_.size() != children_.size()) {
+            return false;
+        }
+        for (size_t i = 0; i < children_.size(); ++i) {
+            if (drawn_axes_[i].first != children_[i].get()) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    void figure::repaint_changed_axes() {
+        std::vector<size_t> changed;
+        for (size_t i = 0; i < children_.size(); ++i) {
+            if (drawn_axes_[i].second != children_[i]->revision()) {
+                changed.emplace_back(i);
+            }
+        }
+        if (changed.empty()) {
+            return;
+        }
+
+        // Repaint where the axes were and where they are now
+        const double width = backend_->width();
+        const double height = backend_->height();
+        std::vector<region> regions;
+        for (size_t i : changed) {
+            add_region(regions, axes_bounds_[i], width, height);
+        }
+        record_axes_batches(changed);
+        for (size_t i : changed) {
+            add_region(regions, axes_bounds_[i], width, height);
+        }
+
+        // Each region gets the background and all axes that
+        // overlap it, in order, so they overlap as before
+        for (const region &r : regions) {
+            vertex_batch_.clear();
+            vertex_batch_.add_rectangle(r[0], r[1], r[2], r[3], color_);
+            for (size_t i = 0; i < children_.size(); ++i) {
+                if (intersects(axes_bounds_[i], r)) {
+                    vertex_batch_.append(axes_batches_[i]);
+                }
+            }
+            backend_->repaint_region(vertex_batch_, r[0], r[1], r[2], r[3]);
+        }
+    }
+
+    void figure::draw_path(const std::vector<double> &x,
+                           const std::vector<double> &y,
+                           const std::array<float, 4> &color) {
+        if (batching_) {
+            vertex_batch_.add_path(x, y, color);
+        } else {
+            backend_->draw_path(x, y, color);
+        }
+    }
+
+    void figure::draw_rectangle(double x1, double x2, double y1, double y2,
+                                const std::array<float, 4> &color) {
+        if (batching_) {
+            vertex_batch_.add_rectangle(x1, x2, y1, y2, color);
+        } else {
+            backend_->draw_rectangle(x1, x2, y1, y2, color);
+        }
+    }
+
+    void figure::draw_triangles(const std::vector<double> &x,
+                                const std::vector<double> &y,
+                                const std::array<float, 4> &color) {
+        if (batching_) {
+            vertex_batch_.add_triangles(x, y, color);
+        } else {
+            backend_->draw_triangles(x, y, color);
+        }
+    }
+
+    void figure::draw_instances(
+        backend::vertex_batch::primitive type,
+        const std::vector<double> &mesh_x, const std::vector<double> &mesh_y,
+        const std::vector<double> &x, const std::vector<double> &y,
+        const std::vector<double> &sizes,
+        const std::vector<std::array<float, 4>> &colors) {
+        if (batching_) {
+            vertex_batch_.add_instances(type, mesh_x, mesh_y, x, y, sizes,
+                                        colors);
+            return;
+        }
+        if (sizes.empty() || colors.empty()) {
+            return;
+        }
+        const bool triangles =
+            type == backend::vertex_batch::primitive::triangles;
+        const size_t n_mesh = std::min(mesh_x.size(), mesh_y.size());
+        const size_t n = std::min(x.size(), y.size());
+        std::vector<double> vx;
+        std::vector<double> vy;
+        for (size_t i = 0; i < n; ++i) {
+            const double size = sizes[std::min(i, sizes.size() - 1)];
+            for (size_t j = 0; j < n_mesh; ++j) {
+                vx.emplace_back(x[i] + size * mesh_x[j]);
+                vy.emplace_back(y[i] + size * mesh_y[j]);
+                // Line segments are separate paths
+                if (!triangles && j % 2 == 1) {
+                    vx.emplace_back(NaN);
+                    vy.emplace_back(NaN);
+                }
+            }
+            // Send the run of instances when the color changes
+            const auto &color = colors[std::min(i, colors.size() - 1)];
+            if (i + 1 == n || colors[std::min(i + 1, colors.size() - 1)] !=
+                                  color) {
+                if (triangles) {
+                    backend_->draw_triangles(vx, vy, color);
+                } else {
+                    backend_->draw_path(vx, vy, color);
+                }
+                vx.clear();
+                vy.clear();
+            }
+        }
+    }
+
+    void figure::draw_text(const std::string &text, double x, double y,
+                           const std::string &font, float font_size,
+                           const std::array<float, 4> &color, float angle) {
+        if (batching_) {
+            const auto &atlas = backend::glyph_atlas::shared(
+                static_cast<unsigned>(std::lround(font_size)));
+            vertex_batch_.add_text(atlas, text, x, y, angle, color);
+        } else {
+            backend_->draw_text(text, x, y, font, font_size, color, angle);
+        }
     }
 
     void figure::send_gnuplot_draw_commands() {
@@ -125,41 +392,85 @@ namespace matplot {
     }
 
     void figure::touch() {
+        ++revision_;
+        draw_if_reactive();
+    }
+
+    void figure::draw_if_reactive() {
         if (!quiet_mode_) {
             draw();
         }
     }
 
-    void figure::flush_commands() {
+    std::string figure::draw_context() {
+        // The backend might have changed without touching the figure,
+        // as in save()
+        return std::to_string(revision_) + " " +
+               std::to_string(
+                   reinterpret_cast<std::uintptr_t>(backend_.get())) +
+               " " + backend_->output() + " " + backend_->output_format() +
+               " " + std::to_string(backend_->width()) + " " +
+               std::to_string(backend_->height()) + " " +
+               std::to_string(backend_->binary_data()) +
+               std::to_string(backend_->binary_data_files()) +
+               std::to_string(backend_->binary_data_single_precision()) +
+               " " + std::to_string(backend_->text_data_precision());
+    }
+
+    bool figure::changed_since_last_draw() {
+        if (drawn_context_ != draw_context() ||
+            drawn_axes_.size() != children_.size()) {
+            return true;
+        }
+        for (size_t i = 0; i < children_.size(); ++i) {
+            if (drawn_axes_[i].first != children_[i].get() ||
+                drawn_axes_[i].second != children_[i]->revision()) {
+                return true;
+            }
+        }
+        return false;
+    }
+
+    bool figure::flush_commands() {
         // render data
-        backend_->render_data();
+        return backend_->render_data();
     }
 
     bool figure::save(const std::string &filename, const std::string &format) {
         try {
-            auto poutput = backend_->output();
-            auto pformat = backend_->output_format();
-            if (backend_->output(filename, format)) {
-                draw();
-            }
-            backend_->output(poutput, pformat);
+            save_or_throw(filename, format);
             return true;
         } catch (...) {
             return false;
         }
     }
 
-    bool figure::save(const std::string &filename) {
+    bool figure::save(const std::string &filename) { return save(filename, ""); }
+
+    void figure::save_or_throw(const std::string &filename,
+                               const std::string &format) {
+        auto poutput = backend_->output();
+        auto pformat = backend_->output_format();
+        const bool output_is_ok = format.empty()
+                                      ? backend_->output(filename)
+                                      : backend_->output(filename, format);
+        if (!output_is_ok) {
+            backend_->output(poutput, pformat);
+            throw std::runtime_error("The backend cannot save " + filename +
+                                     (format.empty() ? std::string()
+                                                     : " as " + format));
+        }
+        rendered_ = true;
         try {
-            auto pout = backend_->output();
-            auto pformat = backend_->output_format();
-            if (backend_->output(filename)) {
-                draw();
-            }
-            backend_->output(pout, pformat);
-            return true;
+            draw();
         } catch (...) {
-            return false;
+            backend_->output(poutput, pformat);
+            throw;
+        }
+        backend_->output(poutput, pformat);
+        if (!rendered_) {
+            throw std::runtime_error("The backend could not render " +
+                                     filename);
         }
     }
 
@@ -709,6 +1020,20 @@ namespace matplot {
         touch();
     }
 
+    bool figure::incremental_redraw() const { return incremental_redraw_; }
+
+    void figure::incremental_redraw(bool incremental_redraw) {
+        incremental_redraw_ = incremental_redraw;
+    }
+
+    bool figure::parallel_tessellation() const {
+        return parallel_tessellation_;
+    }
+
+    void figure::parallel_tessellation(bool parallel_tessellation) {
+        parallel_tessellation_ = parallel_tessellation;
+    }
+
     bool figure::quiet_mode() const { return quiet_mode_; }
 
     void figure::quiet_mode(bool quiet_mode) { quiet_mode_ = quiet_mode; }
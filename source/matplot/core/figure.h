@@ -6,6 +6,7 @@
 #include <iostream>
 #include <matplot/backend/backend_interface.h>
 #include <matplot/backend/gnuplot.h>
+#include <matplot/backend/vertex_batch.h>
 #include <matplot/util/colors.h>
 #include <matplot/util/handle_types.h>
 #include <matplot/util/popen.h>
@@ -33,6 +34,7 @@ namespace matplot {
     class figure {
       public:
         friend class axes;
+        friend class batch_exporter;
         // Remove the copy operators because users are not
         // supposed to use this object directly.
         // Users will use a figure_handle which can be copied
@@ -157,6 +159,29 @@ namespace matplot {
         /// performance.
         void touch();
 
+        /// \brief True if draw() only regenerates what changed
+        /// Axes reuse the commands they generated in the last draw
+        /// while neither they nor their objects are touched, and
+        /// objects whose data only depends on themselves reuse their
+        /// data. If nothing changed at all, draw() sends nothing.
+        /// Backends that keep the last frame only repaint the
+        /// regions of the axes that changed.
+        /// This assumes all changes go through functions that call
+        /// touch(), so it is off by default.
+        bool incremental_redraw() const;
+
+        /// \brief Set if draw() should only regenerate what changed
+        void incremental_redraw(bool incremental_redraw);
+
+        /// \brief True if the axes are tessellated concurrently
+        /// When the backend draws vertex batches, each axes records
+        /// its primitives on a thread of a shared pool and the
+        /// batches are submitted in order. This is on by default.
+        bool parallel_tessellation() const;
+
+        /// \brief Set if the axes should be tessellated concurrently
+        void parallel_tessellation(bool parallel_tessellation);
+
         /// True if in quiet mode (not reactive)
         bool quiet_mode() const;
 
@@ -257,18 +282,68 @@ namespace matplot {
         void send_draw_commands();
         void send_gnuplot_draw_commands();
 
+        /// \brief Record the primitives of some axes in axes_batches_
+        /// The axes are tessellated concurrently if we should.
+        void record_axes_batches(const std::vector<size_t> &indices);
+
+        /// \brief Repaint the regions of the axes that changed
+        /// This needs the batches of all axes from the last frame.
+        void repaint_changed_axes();
+
+      protected /* draw primitives on a backend based on vertices */:
+        /// \brief Draw a path in pixel coordinates
+        /// This goes to the vertex batch of the frame if the backend
+        /// supports batches, or straight to the backend otherwise.
+        void draw_path(const std::vector<double> &x,
+                       const std::vector<double> &y,
+                       const std::array<float, 4> &color);
+
+        /// \brief Draw a filled rectangle in pixel coordinates
+        void draw_rectangle(double x1, double x2, double y1, double y2,
+                            const std::array<float, 4> &color);
+
+        /// \brief Draw filled triangles in pixel coordinates
+        void draw_triangles(const std::vector<double> &x,
+                            const std::vector<double> &y,
+                            const std::array<float, 4> &color);
+
+        /// \brief Draw instances of a template mesh in pixel coordinates
+        /// \see backend::vertex_batch::add_instances
+        /// Backends that do not draw batches get the instances
+        /// as triangles or paths, one call for each run of
+        /// instances with the same color.
+        void draw_instances(backend::vertex_batch::primitive type,
+                            const std::vector<double> &mesh_x,
+                            const std::vector<double> &mesh_y,
+                            const std::vector<double> &x,
+                            const std::vector<double> &y,
+                            const std::vector<double> &sizes,
+                            const std::vector<std::array<float, 4>> &colors);
+
+        /// \brief Draw a line of text in pixel coordinates
+        /// \see backend::backend_interface::draw_text
+        /// Batches get the glyphs of the shared atlas with this
+        /// font size, which is the height of a line in pixels.
+        void draw_text(const std::string &text, double x, double y,
+                       const std::string &font, float font_size,
+                       const std::array<float, 4> &color, float angle = 0.f);
+
       protected /* run commands on a gnuplot pipe if that's our backend */:
         /// \brief Send line and newline to gnu plot pipe and flush
         /// We can buffer the lines until the end of data is sent
         void run_command(const std::string &text);
 
+        /// \brief Send raw bytes of an inline binary data block to the pipe
+        void run_binary_data(const std::string &data);
+
         /// \brief Include a comment in the gnuplot code
         /// This is useful when tracing the gnuplot commands
         /// and when generating a gnuplot file.
         void include_comment(const std::string &text);
 
         /// \brief Send commands to gnuplots
-        void flush_commands();
+        /// \return False if the backend could not render them
+        bool flush_commands();
 
         /// Plots an empty plot command
         void plot_empty_plot();
@@ -281,13 +356,55 @@ namespace matplot {
         void run_unset_window_color_command();
         void run_multiplot_command();
 
+      private:
+        // Save the figure, throwing an exception that describes why
+        // we could not. If the format is empty, we infer it from
+        // the extension.
+        void save_or_throw(const std::string &filename,
+                           const std::string &format);
+
+        // Draw if not in quiet mode
+        // Axes call this when they are touched, so that changes
+        // in the axes do not count as changes in the figure itself
+        void draw_if_reactive();
+
+        // Everything, other than the axes, that the gnuplot commands
+        // of an axes depend on. The cached commands of an axes are
+        // invalid if this changes.
+        std::string draw_context();
+
+        // True if anything changed since the last draw
+        bool changed_since_last_draw();
+
+        // True if nothing but the contents of the axes changed
+        // since the last draw
+        bool only_axes_changed();
+
       private:
         // The default backend for this figure
         std::shared_ptr<backend::backend_interface> backend_{nullptr};
 
+        // Primitives of the frame we are drawing, if the backend
+        // draws batches. We keep it between frames to reuse its memory.
+        backend::vertex_batch vertex_batch_;
+        bool batching_{false};
+
+        // Primitives of each axes, when they are tessellated
+        // concurrently, and if we should do that
+        std::vector<backend::vertex_batch> axes_batches_;
+        bool parallel_tessellation_{true};
+
+        // Region each axes covers, as {x1, x2, y1, y2} pixels, and if
+        // the batches of all axes are still those of the last frame
+        std::vector<std::array<double, 4>> axes_bounds_;
+        bool axes_batches_kept_{false};
+
         // Figure properties
         bool quiet_mode_ = true;
         bool is_plotting_{false};
+        // Whether the backend rendered the last frame we drew
+        bool rendered_{true};
+        bool incremental_redraw_{false};
         std::string name_;
         std::string title_;
         color_array title_color_{0, 0, 0, 0};
@@ -309,6 +426,13 @@ namespace matplot {
         size_t tiledlayout_rows_ = 1;
         size_t tiledlayout_cols_ = 1;
         bool tiledlayout_flow_ = true;
+
+        // Dirty tracking
+        // Number of times the figure itself has been touched
+        size_t revision_{0};
+        // State of the figure and its axes in the last draw
+        std::string drawn_context_;
+        std::vector<std::pair<const class axes *, size_t>> drawn_axes_;
     };
 
     using figure_handle = std::shared_ptr<figure>;
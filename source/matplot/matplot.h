@@ -15,12 +15,14 @@
 // Backends
 #include <matplot/backend/backend_interface.h>
 #include <matplot/backend/backend_registry.h>
+#include <matplot/backend/cimg_raster.h>
 #include <matplot/backend/gnuplot.h>
 // #include <matplot/backend/opengl_3.h> // Don't include opengl by default
 
 // Figure and axes
 #include <matplot/core/axes.h>
 #include <matplot/core/axis.h>
+#include <matplot/core/batch_exporter.h>
 #include <matplot/core/figure.h>
 
 // Axes objects
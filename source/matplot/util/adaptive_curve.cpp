@@ -0,0 +1,261 @@
+#include <algorithm>
+#include <cmath>
+#include <iterator>
+#include <matplot/util/adaptive_curve.h>
+#include <matplot/util/common.h>
+#include <matplot/util/thread_pool.h>
+
+namespace matplot {
+    namespace {
+        // Largest distance from the chord, relative to the windows.
+        // This is about half a pixel of a 500 pixel wide plot.
+        constexpr double tolerance = 1e-3;
+
+        // Cosine of the largest angle between consecutive intervals
+        const double min_cos_angle = std::cos(10. * pi / 180.);
+
+        // Intervals of the smallest width that still move this much,
+        // relative to the windows, are discontinuities
+        constexpr double jump_threshold = 0.1;
+
+        // We do not refine the curve where it is this many window
+        // sizes away from its window, such as close to asymptotes
+        constexpr double far_from_window = 8.;
+
+        // Samples each task evaluates
+        constexpr size_t samples_per_task = 64;
+    } // namespace
+
+    adaptive_curve::adaptive_curve(const std::vector<function_type> &fns,
+                                   const std::array<double, 2> &t_range,
+                                   size_t initial_points, size_t max_depth,
+                                   bool parallel)
+        : fns_(fns), parallel_(parallel) {
+        initial_points = std::max(initial_points, size_t(2));
+        t_ = linspace(t_range[0], t_range[1], initial_points);
+        values_ = evaluate(t_);
+        init_windows();
+        if (max_depth == 0) {
+            return;
+        }
+
+        const double min_width = std::abs(t_range[1] - t_range[0]) /
+                                 static_cast<double>(initial_points - 1) /
+                                 std::pow(2., static_cast<double>(max_depth));
+        for (size_t round = 0; round < max_depth; ++round) {
+            const std::vector<bool> split = intervals_to_split(min_width);
+            std::vector<double> midpoints;
+            for (size_t i = 0; i < split.size(); ++i) {
+                if (split[i]) {
+                    midpoints.emplace_back((t_[i] + t_[i + 1]) / 2);
+                }
+            }
+            if (midpoints.empty()) {
+                break;
+            }
+            const std::vector<std::vector<double>> midpoint_values =
+                evaluate(midpoints);
+
+            // Merge the midpoints after the start of their intervals
+            std::vector<double> t;
+            std::vector<std::vector<double>> values(fns_.size());
+            t.reserve(t_.size() + midpoints.size());
+            for (auto &v : values) {
+                v.reserve(t.capacity());
+            }
+            size_t m = 0;
+            for (size_t i = 0; i < t_.size(); ++i) {
+                t.emplace_back(t_[i]);
+                for (size_t k = 0; k < fns_.size(); ++k) {
+                    values[k].emplace_back(values_[k][i]);
+                }
+                if (i < split.size() && split[i]) {
+                    t.emplace_back(midpoints[m]);
+                    for (size_t k = 0; k < fns_.size(); ++k) {
+                        values[k].emplace_back(midpoint_values[k][m]);
+                    }
+                    ++m;
+                }
+            }
+            t_ = std::move(t);
+            values_ = std::move(values);
+        }
+        break_at_jumps(min_width);
+    }
+
+    const std::vector<double> &adaptive_curve::t() const { return t_; }
+
+    const std::vector<double> &adaptive_curve::values(size_t k) const {
+        return values_[k];
+    }
+
+    std::pair<double, double> adaptive_curve::window(size_t k) const {
+        return windows_[k];
+    }
+
+    bool adaptive_curve::has_asymptotes() const { return has_asymptotes_; }
+
+    size_t adaptive_curve::n_evaluations() const { return n_evaluations_; }
+
+    std::vector<std::vector<double>>
+    adaptive_curve::evaluate(const std::vector<double> &t) {
+        std::vector<std::vector<double>> values(fns_.size(),
+                                                std::vector<double>(t.size()));
+        const size_t n_tasks =
+            (t.size() + samples_per_task - 1) / samples_per_task;
+        auto run_task = [&](size_t task) {
+            const size_t last =
+                std::min(t.size(), (task + 1) * samples_per_task);
+            for (size_t i = task * samples_per_task; i < last; ++i) {
+                for (size_t k = 0; k < fns_.size(); ++k) {
+                    values[k][i] = fns_[k](t[i]);
+                }
+            }
+        };
+        if (parallel_ && n_tasks > 1) {
+            thread_pool::shared().run_all(n_tasks, run_task);
+        } else {
+            for (size_t task = 0; task < n_tasks; ++task) {
+                run_task(task);
+            }
+        }
+        n_evaluations_ += t.size();
+        return values;
+    }
+
+    void adaptive_curve::init_windows() {
+        windows_.clear();
+        scales_.clear();
+        for (const std::vector<double> &v : values_) {
+            std::vector<double> finite;
+            std::copy_if(v.begin(), v.end(), std::back_inserter(finite),
+                         [](double x) { return std::isfinite(x); });
+            if (finite.empty()) {
+                windows_.emplace_back(-1., 1.);
+                scales_.emplace_back(1.);
+                continue;
+            }
+            std::sort(finite.begin(), finite.end());
+            const size_t last = finite.size() - 1;
+            const double low = finite[last / 20];
+            const double high = finite[last - last / 20];
+            double extent = high - low;
+            if (extent <= 0.) {
+                extent = std::max(std::abs(low), 1.);
+            }
+            windows_.emplace_back(low - extent, high + extent);
+            scales_.emplace_back(1. / extent);
+        }
+    }
+
+    std::vector<bool>
+    adaptive_curve::intervals_to_split(double min_width) const {
+        const size_t n = t_.size();
+        std::vector<bool> split(n - 1, false);
+        std::vector<bool> finite(n, true);
+        for (size_t i = 0; i < n; ++i) {
+            for (const std::vector<double> &v : values_) {
+                finite[i] = finite[i] && std::isfinite(v[i]);
+            }
+        }
+
+        // Intervals at the edge of the domain or jumping across the
+        // windows
+        for (size_t i = 0; i + 1 < n; ++i) {
+            if (finite[i] != finite[i + 1] ||
+                (finite[i] && distance(i, i + 1) > jump_threshold)) {
+                split[i] = true;
+            }
+        }
+
+        // Intervals around samples where the curve bends
+        for (size_t i = 1; i + 1 < n; ++i) {
+            if (!finite[i - 1] || !finite[i] || !finite[i + 1]) {
+                continue;
+            }
+            const double u_length = distance(i - 1, i);
+            const double v_length = distance(i, i + 1);
+            if (std::max(u_length, v_length) <= tolerance) {
+                continue;
+            }
+            double uv = 0.;
+            double uw = 0.;
+            double ww = 0.;
+            for (size_t k = 0; k < values_.size(); ++k) {
+                const double uk =
+                    (values_[k][i] - values_[k][i - 1]) * scales_[k];
+                const double vk =
+                    (values_[k][i + 1] - values_[k][i]) * scales_[k];
+                uv += uk * vk;
+                uw += uk * (uk + vk);
+                ww += (uk + vk) * (uk + vk);
+            }
+            const bool bends = u_length > 0. && v_length > 0. &&
+                               uv < min_cos_angle * u_length * v_length;
+            // Distance from sample i to the chord between its neighbors
+            const double deviation =
+                ww > 0. ? std::sqrt(std::max(
+                              0., u_length * u_length - uw * uw / ww))
+                        : u_length;
+            if (bends || deviation > tolerance) {
+                split[i - 1] = true;
+                split[i] = true;
+            }
+        }
+
+        // Intervals that are already as small as they can get, or far
+        // from where most of the curve is
+        for (size_t i = 0; i + 1 < n; ++i) {
+            if (std::abs(t_[i + 1] - t_[i]) < 1.5 * min_width ||
+                is_beyond_windows(i, i + 1, far_from_window)) {
+                split[i] = false;
+            }
+        }
+        return split;
+    }
+
+    double adaptive_curve::distance(size_t i, size_t j) const {
+        double sum = 0.;
+        for (size_t k = 0; k < values_.size(); ++k) {
+            const double d = (values_[k][j] - values_[k][i]) * scales_[k];
+            sum += d * d;
+        }
+        return std::sqrt(sum);
+    }
+
+    bool adaptive_curve::is_beyond_windows(size_t i, size_t j,
+                                           double margin) const {
+        for (size_t k = 0; k < values_.size(); ++k) {
+            const double low = windows_[k].first - margin / scales_[k];
+            const double high = windows_[k].second + margin / scales_[k];
+            if ((values_[k][i] < low && values_[k][j] < low) ||
+                (values_[k][i] > high && values_[k][j] > high)) {
+                return true;
+            }
+        }
+        return false;
+    }
+
+    void adaptive_curve::break_at_jumps(double min_width) {
+        std::vector<double> t;
+        std::vector<std::vector<double>> values(values_.size());
+        for (size_t i = 0; i < t_.size(); ++i) {
+            t.emplace_back(t_[i]);
+            for (size_t k = 0; k < values_.size(); ++k) {
+                values[k].emplace_back(values_[k][i]);
+            }
+            if (i + 1 < t_.size() &&
+                std::abs(t_[i + 1] - t_[i]) < 1.5 * min_width &&
+                distance(i, i + 1) > jump_threshold &&
+                !is_beyond_windows(i, i + 1, 0.)) {
+                t.emplace_back(NaN);
+                for (auto &v : values) {
+                    v.emplace_back(NaN);
+                }
+                has_asymptotes_ = true;
+            }
+        }
+        t_ = std::move(t);
+        values_ = std::move(values);
+    }
+} // namespace matplot
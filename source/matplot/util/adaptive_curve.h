@@ -0,0 +1,96 @@
+#ifndef MATPLOTPLUSPLUS_ADAPTIVE_CURVE_H
+#define MATPLOTPLUSPLUS_ADAPTIVE_CURVE_H
+
+#include <array>
+#include <cstddef>
+#include <functional>
+#include <utility>
+#include <vector>
+
+namespace matplot {
+    /// \class adaptive_curve
+    /// Samples of a curve t -> (f_0(t), f_1(t), ...) refined where it bends
+    ///
+    /// Uniform samples waste points where the curve is straight and
+    /// miss corners, spikes and discontinuities between samples.
+    ///
+    /// We start from uniform samples and split the intervals around
+    /// each sample where the curve bends by more than a small angle
+    /// or strays from the chord by more than the tolerance. Each
+    /// round of splits halves the intervals, up to max_depth rounds.
+    /// Distances are measured relative to the range where most of
+    /// each function is, so the tolerance is a fraction of the plot
+    /// rather than of the data units.
+    ///
+    /// Intervals that still jump across a large part of that range
+    /// after max_depth rounds are asymptotes or discontinuities. We
+    /// break the curve there with NaN.
+    ///
+    /// The functions are evaluated from several threads at once if
+    /// parallel is true, so they should be safe to call concurrently.
+    class adaptive_curve {
+      public:
+        using function_type = std::function<double(double)>;
+
+      public:
+        /// \brief Sample the functions over t_range
+        /// With max_depth = 0, the samples are uniform and the curve
+        /// is not broken at discontinuities.
+        adaptive_curve(const std::vector<function_type> &fns,
+                       const std::array<double, 2> &t_range,
+                       size_t initial_points = 65, size_t max_depth = 10,
+                       bool parallel = false);
+
+        /// \brief Parameter of each sample
+        const std::vector<double> &t() const;
+
+        /// \brief Values of function k at each sample
+        const std::vector<double> &values(size_t k) const;
+
+        /// \brief Range where most values of function k are
+        /// This is the range of the central 90% of the initial
+        /// samples, extended by its own size on both sides. Plots can
+        /// use it as limits when the curve has asymptotes.
+        std::pair<double, double> window(size_t k) const;
+
+        /// \brief True if we broke the curve at an asymptote
+        bool has_asymptotes() const;
+
+        /// \brief Number of times each function was called
+        size_t n_evaluations() const;
+
+      private:
+        /// Evaluate the functions at these values of t
+        std::vector<std::vector<double>>
+        evaluate(const std::vector<double> &t);
+
+        /// Find the windows and scales from the initial samples
+        void init_windows();
+
+        /// Mark the intervals to split in the next round
+        std::vector<bool> intervals_to_split(double min_width) const;
+
+        /// Distance between samples i and j relative to the windows
+        double distance(size_t i, size_t j) const;
+
+        /// True if samples i and j are on the same side of a window,
+        /// more than margin window sizes away from it
+        bool is_beyond_windows(size_t i, size_t j, double margin) const;
+
+        /// Break the curve where it jumps across the windows
+        void break_at_jumps(double min_width);
+
+      private:
+        std::vector<function_type> fns_;
+        bool parallel_;
+        std::vector<double> t_;
+        std::vector<std::vector<double>> values_;
+        std::vector<std::pair<double, double>> windows_;
+        /// 1 / size of the central range of each function
+        std::vector<double> scales_;
+        bool has_asymptotes_{false};
+        size_t n_evaluations_{0};
+    };
+} // namespace matplot
+
+#endif // MATPLOTPLUSPLUS_ADAPTIVE_CURVE_H
@@ -0,0 +1,263 @@
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <matplot/util/adaptive_grid.h>
+#include <matplot/util/thread_pool.h>
+
+namespace matplot {
+    namespace {
+        // Linear interpolation of a smooth function is off by up to
+        // 1/8 of its second difference. We use 1/2, so features
+        // narrower than a cell are also refined.
+        constexpr double deviation_per_second_difference = 0.5;
+
+        // Points each task evaluates
+        constexpr size_t points_per_task = 64;
+
+        void include(double &deviation, double second_difference) {
+            if (std::isfinite(second_difference)) {
+                deviation =
+                    std::max(deviation, deviation_per_second_difference *
+                                            std::abs(second_difference));
+            }
+        }
+    } // namespace
+
+    adaptive_grid::adaptive_grid(const function_type &fn,
+                                 const std::array<double, 4> &xy_range,
+                                 size_t base_cells, size_t max_depth,
+                                 bool parallel)
+        : fn_(fn), parallel_(parallel),
+          base_cells_(std::max(base_cells, size_t(1))),
+          base_size_(size_t(1) << max_depth),
+          n_(base_cells_ * base_size_ + 1),
+          z_min_(std::numeric_limits<double>::infinity()),
+          z_max_(-std::numeric_limits<double>::infinity()) {
+        x_.resize(n_ * n_);
+        y_.resize(n_ * n_);
+        const double x_step = (xy_range[1] - xy_range[0]) / (n_ - 1);
+        const double y_step = (xy_range[3] - xy_range[2]) / (n_ - 1);
+        for (size_t i = 0; i < n_; ++i) {
+            for (size_t j = 0; j < n_; ++j) {
+                x_[index(i, j)] =
+                    j + 1 == n_ ? xy_range[1] : xy_range[0] + j * x_step;
+                y_[index(i, j)] =
+                    i + 1 == n_ ? xy_range[3] : xy_range[2] + i * y_step;
+            }
+        }
+        z_.assign(n_ * n_, NaN);
+        evaluated_.assign(n_ * n_, false);
+
+        std::vector<size_t> corners;
+        corners.reserve((base_cells_ + 1) * (base_cells_ + 1));
+        for (size_t i = 0; i < n_; i += base_size_) {
+            for (size_t j = 0; j < n_; j += base_size_) {
+                corners.emplace_back(index(i, j));
+            }
+        }
+        evaluate(corners);
+    }
+
+    void adaptive_grid::refine(const std::vector<double> &levels) {
+        auto z_at = [this](size_t i, size_t j) { return z_[index(i, j)]; };
+
+        // The curvature of the coarse cells comes from the second
+        // differences of the coarse grid around their corners
+        std::vector<cell> cells;
+        cells.reserve(base_cells_ * base_cells_);
+        const size_t s = base_size_;
+        for (size_t i = 0; i + 1 < n_; i += s) {
+            for (size_t j = 0; j + 1 < n_; j += s) {
+                double deviation = 0.;
+                for (size_t ci : {i, i + s}) {
+                    for (size_t cj : {j, j + s}) {
+                        if (cj >= s && cj + s < n_) {
+                            include(deviation, z_at(ci, cj - s) -
+                                                   2 * z_at(ci, cj) +
+                                                   z_at(ci, cj + s));
+                        }
+                        if (ci >= s && ci + s < n_) {
+                            include(deviation, z_at(ci - s, cj) -
+                                                   2 * z_at(ci, cj) +
+                                                   z_at(ci + s, cj));
+                        }
+                    }
+                }
+                cells.emplace_back(cell{i, j, s, deviation});
+            }
+        }
+
+        std::vector<cell> leaves;
+        std::vector<cell> refined;
+        std::vector<size_t> midpoints;
+        while (!cells.empty()) {
+            refined.clear();
+            midpoints.clear();
+            for (const cell &c : cells) {
+                if (c.size > 1 && should_refine(c, levels)) {
+                    refined.emplace_back(c);
+                    const size_t h = c.size / 2;
+                    midpoints.emplace_back(index(c.i + h, c.j + h));
+                    midpoints.emplace_back(index(c.i, c.j + h));
+                    midpoints.emplace_back(index(c.i + c.size, c.j + h));
+                    midpoints.emplace_back(index(c.i + h, c.j));
+                    midpoints.emplace_back(index(c.i + h, c.j + c.size));
+                } else {
+                    leaves.emplace_back(c);
+                }
+            }
+            evaluate(midpoints);
+
+            // The deviation of the children is the deviation of the
+            // parent at half the size, or what the new points show
+            cells.clear();
+            for (const cell &c : refined) {
+                const size_t h = c.size / 2;
+                double deviation = c.deviation / 4;
+                for (size_t k = 0; k < 3; ++k) {
+                    include(deviation, z_at(c.i + k * h, c.j) -
+                                           2 * z_at(c.i + k * h, c.j + h) +
+                                           z_at(c.i + k * h, c.j + c.size));
+                    include(deviation, z_at(c.i, c.j + k * h) -
+                                           2 * z_at(c.i + h, c.j + k * h) +
+                                           z_at(c.i + c.size, c.j + k * h));
+                }
+                for (size_t ci : {c.i, c.i + h}) {
+                    for (size_t cj : {c.j, c.j + h}) {
+                        cells.emplace_back(cell{ci, cj, h, deviation});
+                    }
+                }
+            }
+        }
+        interpolate(std::move(leaves));
+    }
+
+    std::pair<double, double> adaptive_grid::z_limits() const {
+        return {z_min_, z_max_};
+    }
+
+    grid_view adaptive_grid::x() const { return {x_.data(), n_, n_}; }
+
+    grid_view adaptive_grid::y() const { return {y_.data(), n_, n_}; }
+
+    grid_view adaptive_grid::z() const { return {z_.data(), n_, n_}; }
+
+    vector_2d adaptive_grid::x_rows() const { return rows(x_); }
+
+    vector_2d adaptive_grid::y_rows() const { return rows(y_); }
+
+    vector_2d adaptive_grid::z_rows() const { return rows(z_); }
+
+    size_t adaptive_grid::n_points_per_side() const { return n_; }
+
+    size_t adaptive_grid::n_evaluations() const { return n_evaluations_; }
+
+    void adaptive_grid::evaluate(const std::vector<size_t> &points) {
+        std::vector<size_t> unknown;
+        unknown.reserve(points.size());
+        for (size_t p : points) {
+            if (!evaluated_[p]) {
+                evaluated_[p] = true;
+                unknown.emplace_back(p);
+            }
+        }
+        const size_t n_tasks =
+            (unknown.size() + points_per_task - 1) / points_per_task;
+        auto run_task = [&](size_t task) {
+            const size_t last =
+                std::min(unknown.size(), (task + 1) * points_per_task);
+            for (size_t k = task * points_per_task; k < last; ++k) {
+                const size_t p = unknown[k];
+                z_[p] = fn_(x_[p], y_[p]);
+            }
+        };
+        if (parallel_ && n_tasks > 1) {
+            thread_pool::shared().run_all(n_tasks, run_task);
+        } else {
+            for (size_t task = 0; task < n_tasks; ++task) {
+                run_task(task);
+            }
+        }
+        for (size_t p : unknown) {
+            if (std::isfinite(z_[p])) {
+                z_min_ = std::min(z_min_, z_[p]);
+                z_max_ = std::max(z_max_, z_[p]);
+            }
+        }
+        n_evaluations_ += unknown.size();
+    }
+
+    bool adaptive_grid::should_refine(const cell &c,
+                                      const std::vector<double> &levels) const {
+        double lowest = std::numeric_limits<double>::infinity();
+        double highest = -std::numeric_limits<double>::infinity();
+        size_t n_finite = 0;
+        for (size_t i : {c.i, c.i + c.size}) {
+            for (size_t j : {c.j, c.j + c.size}) {
+                const double z = z_[index(i, j)];
+                if (std::isfinite(z)) {
+                    lowest = std::min(lowest, z);
+                    highest = std::max(highest, z);
+                    ++n_finite;
+                }
+            }
+        }
+        if (n_finite == 0) {
+            return false;
+        }
+        // Contours count non-finite values as below all levels, so
+        // they follow the edge of the domain where it is above one
+        if (n_finite < 4) {
+            return std::any_of(levels.begin(), levels.end(),
+                               [&](double level) { return level < highest; });
+        }
+        return std::any_of(levels.begin(), levels.end(), [&](double level) {
+            return level >= lowest - c.deviation &&
+                   level <= highest + c.deviation;
+        });
+    }
+
+    void adaptive_grid::interpolate(std::vector<cell> leaves) {
+        // Smaller cells go first, so the points on the edges of larger
+        // cells come from their smaller neighbors
+        std::stable_sort(leaves.begin(), leaves.end(),
+                         [](const cell &a, const cell &b) {
+                             return a.size < b.size;
+                         });
+        std::vector<bool> known = evaluated_;
+        for (const cell &c : leaves) {
+            if (c.size <= 1) {
+                continue;
+            }
+            const double z00 = z_[index(c.i, c.j)];
+            const double z01 = z_[index(c.i, c.j + c.size)];
+            const double z10 = z_[index(c.i + c.size, c.j)];
+            const double z11 = z_[index(c.i + c.size, c.j + c.size)];
+            for (size_t a = 0; a <= c.size; ++a) {
+                const double v = static_cast<double>(a) / c.size;
+                for (size_t b = 0; b <= c.size; ++b) {
+                    const size_t p = index(c.i + a, c.j + b);
+                    if (!known[p]) {
+                        const double u = static_cast<double>(b) / c.size;
+                        z_[p] = (1 - v) * ((1 - u) * z00 + u * z01) +
+                                v * ((1 - u) * z10 + u * z11);
+                        known[p] = true;
+                    }
+                }
+            }
+        }
+    }
+
+    size_t adaptive_grid::index(size_t i, size_t j) const {
+        return i * n_ + j;
+    }
+
+    vector_2d adaptive_grid::rows(const std::vector<double> &values) const {
+        vector_2d result(n_);
+        for (size_t i = 0; i < n_; ++i) {
+            result[i].assign(values.begin() + i * n_,
+                             values.begin() + (i + 1) * n_);
+        }
+        return result;
+    }
+} // namespace matplot
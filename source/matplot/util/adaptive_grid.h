@@ -0,0 +1,112 @@
+#ifndef MATPLOTPLUSPLUS_ADAPTIVE_GRID_H
+#define MATPLOTPLUSPLUS_ADAPTIVE_GRID_H
+
+#include <array>
+#include <cstddef>
+#include <functional>
+#include <matplot/util/common.h>
+#include <matplot/util/contourc.h>
+#include <utility>
+#include <vector>
+
+namespace matplot {
+    /// \class adaptive_grid
+    /// Samples of f(x, y) on a grid refined near contour levels
+    ///
+    /// Implicit and contour plots only need fine samples where the
+    /// contour lines are. A uniform grid fine enough to resolve thin
+    /// features evaluates the function everywhere else too.
+    ///
+    /// We start from a coarse grid of cells and split a cell in four
+    /// only if a level crosses its corners, or if the curvature of
+    /// the function is high enough for it to reach a level inside the
+    /// cell. Refined cells are split again up to max_depth times.
+    ///
+    /// The result is a regular grid with the resolution of the finest
+    /// cells, so it can be contoured like any other grid. Points that
+    /// were not evaluated are interpolated from the corners of their
+    /// cell, which no level crosses.
+    ///
+    /// The function is evaluated from several threads at once if
+    /// parallel is true, so it should be safe to call concurrently.
+    class adaptive_grid {
+      public:
+        using function_type = std::function<double(double, double)>;
+
+      public:
+        /// \brief Evaluate the corners of the coarse cells
+        /// The grid has base_cells * 2^max_depth cells per side.
+        adaptive_grid(const function_type &fn,
+                      const std::array<double, 4> &xy_range,
+                      size_t base_cells = 64, size_t max_depth = 3,
+                      bool parallel = false);
+
+        /// \brief Refine the cells around these levels
+        /// This interpolates the points we did not evaluate, so the
+        /// grid is complete after the first call. Further calls only
+        /// evaluate the points the new levels need.
+        void refine(const std::vector<double> &levels);
+
+        /// \brief Lowest and highest finite value we evaluated
+        std::pair<double, double> z_limits() const;
+
+        /// \brief Coordinates and values as row-major grids
+        grid_view x() const;
+        grid_view y() const;
+        grid_view z() const;
+
+        /// \brief Coordinates and values as rows, like meshgrid
+        vector_2d x_rows() const;
+        vector_2d y_rows() const;
+        vector_2d z_rows() const;
+
+        /// \brief Number of rows and columns of points
+        size_t n_points_per_side() const;
+
+        /// \brief Number of times the function was called
+        size_t n_evaluations() const;
+
+      private:
+        /// A square of the fine grid, from point (i, j) to point
+        /// (i + size, j + size)
+        struct cell {
+            size_t i;
+            size_t j;
+            size_t size;
+            /// Estimated error of bilinear interpolation in the cell
+            double deviation;
+        };
+
+        /// Evaluate the points we do not know yet
+        void evaluate(const std::vector<size_t> &points);
+
+        /// True if a level might cross the cell
+        bool should_refine(const cell &c,
+                           const std::vector<double> &levels) const;
+
+        /// Interpolate the points of the cells we did not refine
+        void interpolate(std::vector<cell> leaves);
+
+        size_t index(size_t i, size_t j) const;
+
+        vector_2d rows(const std::vector<double> &values) const;
+
+      private:
+        function_type fn_;
+        bool parallel_;
+        size_t base_cells_;
+        size_t base_size_;
+        /// Points per side
+        size_t n_;
+        std::vector<double> x_;
+        std::vector<double> y_;
+        std::vector<double> z_;
+        /// Points whose value came from the function
+        std::vector<bool> evaluated_;
+        size_t n_evaluations_{0};
+        double z_min_;
+        double z_max_;
+    };
+} // namespace matplot
+
+#endif // MATPLOTPLUSPLUS_ADAPTIVE_GRID_H
@@ -8,6 +8,7 @@
 #include <iostream>
 #include <matplot/util/colors.h>
 #include <matplot/util/common.h>
+#include <numeric>
 #include <random>
 #include <regex>
 #include <set>
@@ -120,6 +121,79 @@ namespace matplot {
         }
     }
 
+    std::vector<size_t> m4_indices(const std::vector<double> &x,
+                                   const std::vector<double> &y,
+                                   double x_min, double x_max,
+                                   size_t n_columns, bool log_x) {
+        if (log_x) {
+            x_min = std::log10(x_min);
+            x_max = std::log10(x_max);
+        }
+        const double x_width = x_max - x_min;
+        std::vector<size_t> result;
+        if (n_columns == 0 || !std::isfinite(x_width) || x_width <= 0) {
+            result.resize(y.size());
+            std::iota(result.begin(), result.end(), size_t(0));
+            return result;
+        }
+        // Points outside the range go to columns -1 and n_columns,
+        // so we still keep their extremes for autoscaling
+        auto column_of = [&](double x_value) {
+            const double c = std::floor((x_value - x_min) / x_width *
+                                        static_cast<double>(n_columns));
+            return static_cast<long long>(
+                truncate(c, -1., static_cast<double>(n_columns)));
+        };
+
+        size_t first = 0;
+        size_t min_index = 0;
+        size_t max_index = 0;
+        long long column = 0;
+        bool in_run = false;
+        auto close_run = [&](size_t last) {
+            std::array<size_t, 4> run{first, min_index, max_index, last};
+            std::sort(run.begin(), run.end());
+            auto run_end = std::unique(run.begin(), run.end());
+            result.insert(result.end(), run.begin(), run_end);
+            in_run = false;
+        };
+
+        for (size_t i = 0; i < y.size(); ++i) {
+            double x_value = x.empty() ? static_cast<double>(i + 1) : x[i];
+            if (log_x) {
+                x_value = std::log10(x_value);
+            }
+            if (!std::isfinite(x_value) || !std::isfinite(y[i])) {
+                // keep the gap in the line
+                if (in_run) {
+                    close_run(i - 1);
+                }
+                result.emplace_back(i);
+                continue;
+            }
+            const long long c = column_of(x_value);
+            if (in_run && c == column) {
+                if (y[i] < y[min_index]) {
+                    min_index = i;
+                }
+                if (y[i] > y[max_index]) {
+                    max_index = i;
+                }
+                continue;
+            }
+            if (in_run) {
+                close_run(i - 1);
+            }
+            first = min_index = max_index = i;
+            column = c;
+            in_run = true;
+        }
+        if (in_run) {
+            close_run(y.size() - 1);
+        }
+        return result;
+    }
+
     std::vector<double> transform(const std::vector<double> &x,
                                   const std::vector<double> &y,
                                   std::function<double(double, double)> fn) {
@@ -248,6 +248,16 @@ namespace matplot {
 
     double truncate(double x, double lower_bound, double upper_bound);
 
+    /// \brief Indices of the points that draw the same line on n_columns
+    /// pixel columns between x_min and x_max (M4 decimation)
+    /// For each run of consecutive points in the same column, we keep
+    /// the first, last, minimum, and maximum points. Non-finite points
+    /// are always kept. If x is empty, the x values are the indices + 1.
+    std::vector<size_t> m4_indices(const std::vector<double> &x,
+                                   const std::vector<double> &y,
+                                   double x_min, double x_max,
+                                   size_t n_columns, bool log_x = false);
+
     template <class Arg1, class TUPLE>
     void reorder_parameter_pack_in_tuple(TUPLE &t, Arg1 x) {
         std::get<Arg1>(t) = x;
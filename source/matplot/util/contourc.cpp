@@ -16,8 +16,10 @@
 // https://github.com/matplotlib/matplotlib/blob/master/src/mplutils.cpp
 #include <algorithm>
 #include <cassert>
+#include <limits>
 #include <matplot/axes_objects/contours.h>
 #include <matplot/util/contourc.h>
+#include <matplot/util/thread_pool.h>
 
 namespace matplot {
 
@@ -305,34 +307,111 @@ namespace matplot {
                                                     : &contour_line);
     }
 
-    QuadContourGenerator::QuadContourGenerator(const CoordinateArray &x,
-                                               const CoordinateArray &y,
-                                               const CoordinateArray &z,
+    grid_view::grid_view(const double *data, size_t n_rows, size_t n_cols)
+        : grid_view(data, n_rows, n_cols, n_cols) {}
+
+    grid_view::grid_view(const double *data, size_t n_rows, size_t n_cols,
+                         size_t row_stride, size_t col_stride)
+        : data(data), n_rows(n_rows), n_cols(n_cols), row_stride(row_stride),
+          col_stride(col_stride) {}
+
+    const double &grid_view::operator()(size_t i, size_t j) const {
+        return data[i * row_stride + j * col_stride];
+    }
+
+    bool grid_view::is_contiguous() const {
+        return (col_stride == 1 || n_cols <= 1) &&
+               (row_stride == n_cols || n_rows <= 1);
+    }
+
+    QuadContourGenerator::QuadContourGenerator(long nx, long ny,
                                                bool corner_mask,
                                                long chunk_size)
-        : _x(x), _y(y), _z(z), _nx(static_cast<long>(_x[0].size())),
-          _ny(static_cast<long>(_x.size())), _n(_nx * _ny),
-          _corner_mask(corner_mask),
+        : _nx(nx), _ny(ny), _n(_nx * _ny), _corner_mask(corner_mask),
           _chunk_size(chunk_size > 0
                           ? std::min(chunk_size, std::max(_nx, _ny) - 1)
                           : std::max(_nx, _ny) - 1),
           _nxchunk(calc_chunk_count(_nx)), _nychunk(calc_chunk_count(_ny)),
           _chunk_count(_nxchunk * _nychunk), _cache(std::vector<CacheItem>(_n)),
           _parent_cache(_nx, chunk_size > 0 ? chunk_size + 1 : _nx,
-                        chunk_size > 0 ? chunk_size + 1 : _ny) {
-        assert(!_x.empty() && !_y.empty() && !_z.empty() && "Empty array");
-        assert(_y.size() == _x.size() && _y[0].size() == _x[0].size() &&
+                        chunk_size > 0 ? chunk_size + 1 : _ny) {}
+
+    QuadContourGenerator::QuadContourGenerator(const CoordinateArray &x,
+                                               const CoordinateArray &y,
+                                               const CoordinateArray &z,
+                                               bool corner_mask,
+                                               long chunk_size)
+        : QuadContourGenerator(x.empty() ? 0 : static_cast<long>(x[0].size()),
+                               static_cast<long>(x.size()), corner_mask,
+                               chunk_size) {
+        assert(!x.empty() && !y.empty() && !z.empty() && "Empty array");
+        assert(y.size() == x.size() && y[0].size() == x[0].size() &&
                "Different-sized y and x arrays");
-        assert(_z.size() == _x.size() && _z[0].size() == _x[0].size() &&
+        assert(z.size() == x.size() && z[0].size() == x[0].size() &&
                "Different-sized z and x arrays");
 
+        // Copy the rows to a single buffer, so that points can be indexed
+        // directly. Missing values in short rows are NaN.
+        const size_t nx = static_cast<size_t>(_nx);
+        const size_t n = static_cast<size_t>(_n);
+        auto storage = std::make_shared<std::vector<double>>(3 * n, NaN);
+        const CoordinateArray *arrays[] = {&x, &y, &z};
+        for (size_t k = 0; k < 3; ++k) {
+            for (size_t i = 0; i < static_cast<size_t>(_ny); ++i) {
+                const vector_1d &row = (*arrays[k])[i];
+                std::copy_n(row.begin(), std::min(row.size(), nx),
+                            storage->begin() + k * n + i * nx);
+            }
+        }
+        _storage = storage;
+        _x = grid_view(_storage->data(), _ny, nx);
+        _y = grid_view(_storage->data() + n, _ny, nx);
+        _z = _storage->data() + 2 * n;
+
+        init_cache_grid();
+        init_quad_row_z_ranges();
+    }
+
+    QuadContourGenerator::QuadContourGenerator(const grid_view &x,
+                                               const grid_view &y,
+                                               const grid_view &z,
+                                               bool corner_mask,
+                                               long chunk_size)
+        : QuadContourGenerator(static_cast<long>(x.n_cols),
+                               static_cast<long>(x.n_rows), corner_mask,
+                               chunk_size) {
+        assert(x.n_rows != 0 && x.n_cols != 0 && "Empty array");
+        assert(y.n_rows == x.n_rows && y.n_cols == x.n_cols &&
+               "Different-sized y and x arrays");
+        assert(z.n_rows == x.n_rows && z.n_cols == x.n_cols &&
+               "Different-sized z and x arrays");
+
+        // Use x, y and contiguous z in place and copy the other z
+        _x = x;
+        _y = y;
+        if (z.is_contiguous()) {
+            _z = z.data;
+        } else {
+            std::vector<double> copy;
+            copy.reserve(_n);
+            for (size_t i = 0; i < z.n_rows; ++i) {
+                for (size_t j = 0; j < z.n_cols; ++j) {
+                    copy.push_back(z(i, j));
+                }
+            }
+            _storage =
+                std::make_shared<const std::vector<double>>(std::move(copy));
+            _z = _storage->data();
+        }
+
         init_cache_grid();
+        init_quad_row_z_ranges();
     }
 
     void QuadContourGenerator::append_contour_line_to_vertices(
         ContourLine &contour_line, vertices_list_type &vertices_list) const {
-        double x_diff = std::abs(_x[0][1] - _x[0][0]);
-        double y_diff = std::abs(_y[1][0] - _y[0][0]);
+        double x_diff = _nx > 1 ? std::abs(_x(0, 1) - _x(0, 0)) : 0.;
+        double y_diff = _ny > 1 ? std::abs(_y(1, 0) - _y(0, 0)) : 0.;
         // Convert ContourLine to vertices_list
         size_t i = 0;
         size_t inserted = 0;
@@ -516,6 +595,8 @@ namespace matplot {
                              jend);
 
             for (long j = jstart; j < jend; ++j) {
+                if (!quad_row_crosses(j, level))
+                    continue;
                 long quad_end = iend + j * _nx;
                 for (long quad = istart + j * _nx; quad < quad_end; ++quad) {
                     if (EXISTS_NONE(quad) || VISITED(quad, 1))
@@ -569,6 +650,8 @@ namespace matplot {
                              jend);
 
             for (long j = jstart; j < jend; ++j) {
+                if (!quad_row_crosses(j, level))
+                    continue;
                 long quad_end = iend + j * _nx;
                 for (long quad = istart + j * _nx; quad < quad_end; ++quad) {
                     if (EXISTS_NONE(quad) || VISITED(quad, 1))
@@ -652,6 +735,56 @@ namespace matplot {
         return std::make_pair(vertices, codes);
     }
 
+    std::vector<QuadContourGenerator::vertices_list_type>
+    QuadContourGenerator::create_contours(const std::vector<double> &levels) {
+        std::vector<vertices_list_type> result(levels.size());
+        thread_pool &pool = thread_pool::shared();
+        const size_t n_workers = std::min(levels.size(), pool.n_threads() + 1);
+        if (n_workers <= 1) {
+            for (size_t i = 0; i < levels.size(); ++i) {
+                result[i] = create_contour(levels[i]);
+            }
+            return result;
+        }
+        // Each worker takes every n_workers-th level, so the work is
+        // balanced even if some levels have many more lines
+        pool.run_all(n_workers, [&](size_t worker) {
+            QuadContourGenerator generator(*this);
+            for (size_t i = worker; i < levels.size(); i += n_workers) {
+                result[i] = generator.create_contour(levels[i]);
+            }
+        });
+        return result;
+    }
+
+    std::vector<std::pair<QuadContourGenerator::vertices_list_type,
+                          QuadContourGenerator::codes_list_type>>
+    QuadContourGenerator::create_filled_contours(
+        const std::vector<double> &lower_levels,
+        const std::vector<double> &upper_levels) {
+        const size_t n_levels =
+            std::min(lower_levels.size(), upper_levels.size());
+        std::vector<std::pair<vertices_list_type, codes_list_type>> result(
+            n_levels);
+        thread_pool &pool = thread_pool::shared();
+        const size_t n_workers = std::min(n_levels, pool.n_threads() + 1);
+        if (n_workers <= 1) {
+            for (size_t i = 0; i < n_levels; ++i) {
+                result[i] =
+                    create_filled_contour(lower_levels[i], upper_levels[i]);
+            }
+            return result;
+        }
+        pool.run_all(n_workers, [&](size_t worker) {
+            QuadContourGenerator generator(*this);
+            for (size_t i = worker; i < n_levels; i += n_workers) {
+                result[i] = generator.create_filled_contour(lower_levels[i],
+                                                            upper_levels[i]);
+            }
+        });
+        return result;
+    }
+
     XY QuadContourGenerator::edge_interp(const QuadEdge &quad_edge,
                                          const double &level) {
         assert(quad_edge.quad >= 0 && quad_edge.quad < _n &&
@@ -1185,13 +1318,14 @@ namespace matplot {
 
     XY QuadContourGenerator::get_point_xy(long point) const {
         assert(point >= 0 && point < _n && "Point index out of bounds.");
-        return XY(_x[0].data()[static_cast<size_t>(point)],
-                  _y[0].data()[static_cast<size_t>(point)]);
+        const size_t i = static_cast<size_t>(point / _nx);
+        const size_t j = static_cast<size_t>(point % _nx);
+        return XY(_x(i, j), _y(i, j));
     }
 
     const double &QuadContourGenerator::get_point_z(long point) const {
         assert(point >= 0 && point < _n && "Point index out of bounds.");
-        return _z[0].data()[static_cast<size_t>(point)];
+        return _z[point];
     }
 
     Edge
@@ -1292,6 +1426,32 @@ namespace matplot {
         }
     }
 
+    void QuadContourGenerator::init_quad_row_z_ranges() {
+        _quad_row_z_ranges.assign(
+            static_cast<size_t>(_ny),
+            {std::numeric_limits<double>::infinity(),
+             -std::numeric_limits<double>::infinity()});
+        for (long j = 0; j < _ny - 1; ++j) {
+            auto &[lowest, highest] = _quad_row_z_ranges[j];
+            const double *z_ptr = _z + j * _nx;
+            for (const double *end = z_ptr + 2 * _nx; z_ptr != end; ++z_ptr) {
+                if (std::isnan(*z_ptr)) {
+                    lowest = -std::numeric_limits<double>::infinity();
+                } else {
+                    lowest = std::min(lowest, *z_ptr);
+                    highest = std::max(highest, *z_ptr);
+                }
+            }
+        }
+    }
+
+    bool QuadContourGenerator::quad_row_crosses(long j,
+                                                const double &level) const {
+        // Contour lines go between points above the level and the others
+        const auto &[lowest, highest] = _quad_row_z_ranges[j];
+        return highest > level && lowest <= level;
+    }
+
     void QuadContourGenerator::init_cache_levels(const double &lower_level,
                                                  const double &upper_level) {
         assert(upper_level >= lower_level &&
@@ -1304,7 +1464,7 @@ namespace matplot {
                  : MASK_EXISTS_QUAD | MASK_BOUNDARY_S | MASK_BOUNDARY_W);
 
         if (two_levels) {
-            const double *z_ptr = _z[0].data();
+            const double *z_ptr = _z;
             for (long quad = 0; quad < _n; ++quad, ++z_ptr) {
                 _cache[quad] &= keep_mask;
                 if (*z_ptr > upper_level)
@@ -1313,7 +1473,7 @@ namespace matplot {
                     _cache[quad] |= MASK_Z_LEVEL_1;
             }
         } else {
-            const double *z_ptr = _z[0].data();
+            const double *z_ptr = _z;
             for (long quad = 0; quad < _n; ++quad, ++z_ptr) {
                 _cache[quad] &= keep_mask;
                 if (*z_ptr > lower_level)
@@ -1926,11 +2086,8 @@ namespace matplot {
                                             const vector_2d &y,
                                             const vector_2d &z,
                                             const vector_1d &levels) {
-        std::vector<contour_line_type> lines;
-        for (const double &level : levels) {
-            lines.emplace_back(contour_line(x, y, z, level));
-        }
-        return lines;
+        QuadContourGenerator contour_generator(x, y, z, false, 0);
+        return contour_generator.create_contours(levels);
     }
 
     std::vector<contour_line_type> contourc(const vector_2d &x,
@@ -1964,4 +2121,23 @@ namespace matplot {
         return contourc(x, y, z, n_levels);
     }
 
+    std::vector<contour_line_type> contourc(const grid_view &x,
+                                            const grid_view &y,
+                                            const grid_view &z,
+                                            const vector_1d &levels) {
+        QuadContourGenerator contour_generator(x, y, z, false, 0);
+        return contour_generator.create_contours(levels);
+    }
+
+    std::vector<contour_line_type> contourc(const grid_view &z,
+                                            const vector_1d &levels) {
+        // x and y are the column and row numbers, repeated down the rows
+        // and across the columns
+        const vector_1d x = iota(1, 1, static_cast<double>(z.n_cols));
+        const vector_1d y = iota(1, 1, static_cast<double>(z.n_rows));
+        return contourc(grid_view(x.data(), z.n_rows, z.n_cols, 0, 1),
+                        grid_view(y.data(), z.n_rows, z.n_cols, 1, 0), z,
+                        levels);
+    }
+
 } // namespace matplot
@@ -159,6 +159,7 @@
 #include <matplot/core/axes.h>
 #include <matplot/util/common.h>
 #include <matplot/util/handle_types.h>
+#include <memory>
 #include <numeric>
 #include <stdint.h>
 #include <vector>
@@ -302,6 +303,32 @@ namespace matplot {
         long _istart, _jstart;
     };
 
+    // A read-only view of a grid of doubles, like the numpy array views
+    // of the original code. Element (i, j) is
+    // data[i * row_stride + j * col_stride]. A stride of 0 repeats the
+    // same row or column, so a vector of n_cols x values with a row
+    // stride of 0 describes the x of a whole meshgrid. The view does not
+    // own the data.
+    struct grid_view {
+        grid_view() = default;
+
+        // Contiguous row-major grid
+        grid_view(const double *data, size_t n_rows, size_t n_cols);
+
+        grid_view(const double *data, size_t n_rows, size_t n_cols,
+                  size_t row_stride, size_t col_stride = 1);
+
+        const double &operator()(size_t i, size_t j) const;
+
+        bool is_contiguous() const;
+
+        const double *data{nullptr};
+        size_t n_rows{0};
+        size_t n_cols{0};
+        size_t row_stride{0};
+        size_t col_stride{1};
+    };
+
     // See overview of algorithm at top of file.
     class QuadContourGenerator {
       public:
@@ -326,6 +353,14 @@ namespace matplot {
                              const vector_2d &z, bool corner_mask,
                              long chunk_size);
 
+        // Constructor for grids in views. The x and y views and
+        // contiguous z views are not copied, so their data should outlive
+        // the generator. Strided z views are copied into a contiguous
+        // buffer.
+        QuadContourGenerator(const grid_view &x, const grid_view &y,
+                             const grid_view &z, bool corner_mask,
+                             long chunk_size);
+
         // Create and return polygons for a line (i.e. non-filled) contour at
         // the specified level.
         using vertices_list_type = std::pair<vector_1d, vector_1d>;
@@ -338,7 +373,23 @@ namespace matplot {
         create_filled_contour(const double &lower_level,
                               const double &upper_level);
 
+        // Create the line contours of many levels. The result is the same
+        // as calling create_contour for each level, but the levels are
+        // contoured in parallel, each thread with its own copy of the cache.
+        std::vector<vertices_list_type>
+        create_contours(const std::vector<double> &levels);
+
+        // Create the filled contours between many pairs of levels, in
+        // parallel like create_contours.
+        std::vector<std::pair<vertices_list_type, codes_list_type>>
+        create_filled_contours(const std::vector<double> &lower_levels,
+                               const std::vector<double> &upper_levels);
+
       private:
+        // Set the sizes and chunks of a grid with nx by ny points.
+        QuadContourGenerator(long nx, long ny, bool corner_mask,
+                             long chunk_size);
+
         // Typedef for following either a boundary of the domain or the
         // interior; clearer than using a boolean.
         typedef enum { Boundary, Interior } BoundaryOrInterior;
@@ -468,6 +519,13 @@ namespace matplot {
         // to create_contour() and create_filled_contour().
         void init_cache_grid();
 
+        // Find the range of z of each row of quads.
+        void init_quad_row_z_ranges();
+
+        // Return true if a line contour at the specified level might cross
+        // the quads in row j.
+        bool quad_row_crosses(long j, const double &level) const;
+
         // Initialise the cache with information that is specific to contouring
         // the specified two levels.  The levels are the same for contour lines,
         // different for filled contours.
@@ -534,7 +592,18 @@ namespace matplot {
 
         // Note that mask is not stored as once it has been used to initialise
         // the cache it is no longer needed.
-        CoordinateArray _x, _y, _z;
+        // Grids of _ny rows of _nx points. They view the buffers of the
+        // caller or _storage, which is shared by the copies that contour
+        // levels in parallel. z is always a contiguous row-major array.
+        grid_view _x;
+        grid_view _y;
+        const double *_z{nullptr};
+        std::shared_ptr<const std::vector<double>> _storage;
+
+        // Lowest and highest z of the points of each row of quads. NaN
+        // counts as lowest, because it is never above a level. Line
+        // contours skip the rows that no level crossing can start in.
+        std::vector<std::pair<double, double>> _quad_row_z_ranges;
         long _nx, _ny; // Number of points in each direction.
         long _n;       // Total number of points (and hence quads).
 
@@ -609,6 +678,16 @@ namespace matplot {
     std::vector<contour_line_type> contourc(const vector_2d &z,
                                             size_t n_levels = 7);
 
+    /// \brief Compute contour lines of grids in row-major buffers
+    /// The buffers are not copied if their rows are contiguous.
+    std::vector<contour_line_type> contourc(const grid_view &x,
+                                            const grid_view &y,
+                                            const grid_view &z,
+                                            const vector_1d &levels);
+
+    std::vector<contour_line_type> contourc(const grid_view &z,
+                                            const vector_1d &levels);
+
 } // namespace matplot
 
 #endif // MATPLOTPLUSPLUS_CONTOURC_H
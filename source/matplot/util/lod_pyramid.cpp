@@ -0,0 +1,97 @@
+#include <algorithm>
+#include <cmath>
+#include <matplot/util/lod_pyramid.h>
+
+namespace matplot {
+    namespace {
+        // Halve the rows and columns of a grid with the mean of
+        // the finite values in each 2x2 block
+        vector_2d halve(const vector_2d &grid) {
+            vector_2d result((grid.size() + 1) / 2);
+            for (size_t i = 0; i < result.size(); ++i) {
+                const size_t first_row = 2 * i;
+                const size_t last_row = std::min(2 * i + 2, grid.size());
+                size_t n_cols = 0;
+                for (size_t r = first_row; r < last_row; ++r) {
+                    n_cols = std::max(n_cols, grid[r].size());
+                }
+                vector_1d &row = result[i];
+                row.resize((n_cols + 1) / 2);
+                for (size_t j = 0; j < row.size(); ++j) {
+                    double sum = 0.;
+                    size_t n = 0;
+                    for (size_t r = first_row; r < last_row; ++r) {
+                        const size_t last_col =
+                            std::min(2 * j + 2, grid[r].size());
+                        for (size_t c = 2 * j; c < last_col; ++c) {
+                            if (std::isfinite(grid[r][c])) {
+                                sum += grid[r][c];
+                                ++n;
+                            }
+                        }
+                    }
+                    row[j] = n != 0 ? sum / n : NaN;
+                }
+            }
+            return result;
+        }
+
+        // Indices of every other element, and of the last one
+        std::vector<size_t> every_other(size_t n) {
+            std::vector<size_t> result;
+            for (size_t i = 0; i < n; i += 2) {
+                result.emplace_back(i);
+            }
+            if (n % 2 == 0 && n != 0) {
+                result.emplace_back(n - 1);
+            }
+            return result;
+        }
+
+        // Keep every other row and column of a grid
+        vector_2d subsample(const vector_2d &grid) {
+            vector_2d result;
+            for (size_t i : every_other(grid.size())) {
+                vector_1d &row = result.emplace_back();
+                for (size_t j : every_other(grid[i].size())) {
+                    row.emplace_back(grid[i][j]);
+                }
+            }
+            return result;
+        }
+    } // namespace
+
+    lod_pyramid::lod_pyramid(reduction r) : reduction_(r) {}
+
+    const vector_2d &lod_pyramid::level(const vector_2d &grid, size_t k) {
+        if (k == 0) {
+            return grid;
+        }
+        while (levels_.size() < k) {
+            const vector_2d &previous =
+                levels_.empty() ? grid : levels_.back();
+            // Grids with a single cell (or the two vertices of
+            // each edge) do not get any smaller
+            const size_t smallest = reduction_ == reduction::mean ? 1 : 2;
+            if (previous.size() <= smallest &&
+                (previous.empty() || previous[0].size() <= smallest)) {
+                return previous;
+            }
+            levels_.emplace_back(reduction_ == reduction::mean
+                                     ? halve(previous)
+                                     : subsample(previous));
+        }
+        return levels_[k - 1];
+    }
+
+    void lod_pyramid::clear() { levels_.clear(); }
+
+    size_t lod_pyramid::level_for(double cells_per_pixel) {
+        size_t k = 0;
+        while (std::isfinite(cells_per_pixel) && cells_per_pixel >= 2.) {
+            cells_per_pixel /= 2.;
+            ++k;
+        }
+        return k;
+    }
+} // namespace matplot
@@ -0,0 +1,59 @@
+#ifndef MATPLOTPLUSPLUS_LOD_PYRAMID_H
+#define MATPLOTPLUSPLUS_LOD_PYRAMID_H
+
+#include <cstddef>
+#include <matplot/util/common.h>
+#include <vector>
+
+namespace matplot {
+    /// \class lod_pyramid
+    /// Copies of a grid at lower levels of detail
+    ///
+    /// A 4096x4096 image on a 500 pixel wide axes has about 8 rows
+    /// and columns of data in each pixel. Sending or drawing all of
+    /// them costs much more than it shows. Each level of the pyramid
+    /// halves the rows and columns of the level above, so objects can
+    /// use the level with about one row and column per pixel.
+    ///
+    /// Levels are built the first time they are needed and kept
+    /// until clear() is called, which objects do when their data
+    /// changes.
+    class lod_pyramid {
+      public:
+        /// How a level is made from the level above
+        enum class reduction {
+            /// Each cell is the mean of the finite values in a 2x2
+            /// block, or NaN if there are none. The last row and
+            /// column of odd grids become blocks of their own. This
+            /// is for grids of cells, such as images.
+            mean,
+            /// Keep every other row and column, and always the last
+            /// ones. This is for grids of vertices, such as surfaces,
+            /// whose edges should not move.
+            subsample
+        };
+
+      public:
+        explicit lod_pyramid(reduction r = reduction::mean);
+
+        /// \brief Level k of a grid, building it if needed
+        /// Level 0 is the grid itself. The grid should be the same
+        /// in all calls until clear().
+        const vector_2d &level(const vector_2d &grid, size_t k);
+
+        /// \brief Remove the levels we built
+        void clear();
+
+        /// \brief Level whose cells are closest to one pixel
+        /// This is the largest k such that 2^k cells still fit in a
+        /// pixel, or 0 if cells are larger than pixels.
+        static size_t level_for(double cells_per_pixel);
+
+      private:
+        reduction reduction_;
+        /// Levels 1, 2, ... that we built so far
+        std::vector<vector_2d> levels_;
+    };
+} // namespace matplot
+
+#endif // MATPLOTPLUSPLUS_LOD_PYRAMID_H
@@ -0,0 +1,153 @@
+#ifndef MATPLOTPLUSPLUS_TEXT_WRITER_H
+#define MATPLOTPLUSPLUS_TEXT_WRITER_H
+
+#include <algorithm>
+#include <charconv>
+#include <cstdio>
+#include <limits>
+#include <string>
+#include <string_view>
+#include <type_traits>
+#include <utility>
+
+namespace matplot {
+    /// \class text_writer
+    /// Format numbers and text into a string buffer.
+    ///
+    /// This replaces std::stringstream in the functions that generate
+    /// data for gnuplot. Numbers are formatted with std::to_chars,
+    /// which does not depend on the locale and does not allocate, so
+    /// the only allocations are when the buffer grows. The buffer can
+    /// be cleared and reused, and str() moves it out without a copy.
+    ///
+    /// With the default precision, numbers are formatted exactly as
+    /// std::ostream formats them (like printf's %g with precision 6).
+    class text_writer {
+      public:
+        /// Same precision as std::ostream
+        static constexpr int default_precision = 6;
+
+        /// Digits we need to represent any double exactly
+        static constexpr int max_precision =
+            std::numeric_limits<double>::max_digits10;
+
+        /// \brief Create a writer with a number of significant digits
+        /// A precision of 0 means the shortest representation that
+        /// parses back to the same number (round-trip).
+        explicit text_writer(int precision = default_precision)
+            : precision_(std::clamp(precision, 0, max_precision)) {}
+
+        text_writer &operator<<(double value) {
+            char buffer[max_chars];
+            return append(buffer, to_chars(buffer, value));
+        }
+
+        text_writer &operator<<(float value) {
+            char buffer[max_chars];
+            return append(buffer, to_chars(buffer, value));
+        }
+
+        template <class INTEGER,
+                  std::enable_if_t<std::is_integral_v<INTEGER> &&
+                                       !std::is_same_v<INTEGER, bool> &&
+                                       !std::is_same_v<INTEGER, char>,
+                                   int> = 0>
+        text_writer &operator<<(INTEGER value) {
+            char buffer[max_chars];
+            auto result = std::to_chars(buffer, buffer + max_chars, value);
+            return append(buffer, result.ptr);
+        }
+
+        text_writer &operator<<(bool value) {
+            buffer_ += value ? '1' : '0';
+            return *this;
+        }
+
+        text_writer &operator<<(char c) {
+            buffer_ += c;
+            return *this;
+        }
+
+        text_writer &operator<<(std::string_view text) {
+            buffer_ += text;
+            return *this;
+        }
+
+        text_writer &operator<<(const char *text) {
+            buffer_ += text;
+            return *this;
+        }
+
+        text_writer &operator<<(const std::string &text) {
+            buffer_ += text;
+            return *this;
+        }
+
+        /// \brief Write text between double quotes, like std::quoted
+        text_writer &quoted(std::string_view text) {
+            buffer_ += '"';
+            for (char c : text) {
+                if (c == '"' || c == '\\') {
+                    buffer_ += '\\';
+                }
+                buffer_ += c;
+            }
+            buffer_ += '"';
+            return *this;
+        }
+
+        /// Significant digits of floating point numbers
+        int precision() const { return precision_; }
+
+        /// Reserve space for a number of characters
+        void reserve(size_t n) { buffer_.reserve(n); }
+
+        /// Number of characters in the buffer
+        size_t size() const { return buffer_.size(); }
+
+        /// Clear the buffer, keeping its memory for reuse
+        void clear() { buffer_.clear(); }
+
+        /// View of the buffer, which can be written straight to a pipe
+        std::string_view view() const { return buffer_; }
+
+        /// Move the buffer out of the writer, leaving the writer empty
+        std::string str() {
+            std::string result = std::move(buffer_);
+            buffer_.clear();
+            return result;
+        }
+
+      private:
+        // Enough for a sign, 17 digits, the point, and the exponent
+        static constexpr int max_chars = 32;
+
+        text_writer &append(const char *first, const char *last) {
+            buffer_.append(first, last);
+            return *this;
+        }
+
+        template <class FLOAT> char *to_chars(char *buffer, FLOAT value) {
+#if defined(__cpp_lib_to_chars) && __cpp_lib_to_chars >= 201611L
+            auto result =
+                precision_ == 0
+                    ? std::to_chars(buffer, buffer + max_chars, value)
+                    : std::to_chars(buffer, buffer + max_chars, value,
+                                    std::chars_format::general, precision_);
+            return result.ptr;
+#else
+            // Standard libraries without floating point to_chars
+            const int precision = precision_ == 0 ? max_precision : precision_;
+            const int n = std::snprintf(buffer, max_chars, "%.*g", precision,
+                                        static_cast<double>(value));
+            return buffer + std::clamp(n, 0, max_chars - 1);
+#endif
+        }
+
+      private:
+        std::string buffer_;
+        int precision_;
+    };
+} // namespace matplot
+
+#endif // MATPLOTPLUSPLUS_TEXT_WRITER_H
@@ -0,0 +1,110 @@
+#include <algorithm>
+#include <atomic>
+#include <matplot/util/thread_pool.h>
+#include <memory>
+
+namespace matplot {
+    thread_pool::thread_pool(size_t n_threads) {
+        if (n_threads == 0) {
+            n_threads = std::max(std::thread::hardware_concurrency(), 1u);
+        }
+        for (size_t i = 0; i < n_threads; ++i) {
+            threads_.emplace_back([this] { worker_loop(); });
+        }
+    }
+
+    thread_pool::~thread_pool() {
+        {
+            std::lock_guard<std::mutex> lock(tasks_mutex_);
+            stop_ = true;
+        }
+        tasks_available_.notify_all();
+        for (auto &thread : threads_) {
+            thread.join();
+        }
+    }
+
+    std::future<void> thread_pool::submit(std::function<void()> task) {
+        std::packaged_task<void()> job(std::move(task));
+        std::future<void> result = job.get_future();
+        {
+            std::lock_guard<std::mutex> lock(tasks_mutex_);
+            tasks_.emplace(std::move(job));
+        }
+        tasks_available_.notify_one();
+        return result;
+    }
+
+    void thread_pool::run_all(size_t n,
+                              const std::function<void(size_t)> &task) {
+        if (n == 0) {
+            return;
+        }
+        // Tasks of the pool might start after we return, when there
+        // is nothing left to do, so they share the state with us
+        struct shared_state {
+            std::function<void(size_t)> task;
+            size_t n;
+            std::atomic<size_t> next{0};
+            size_t n_done{0};
+            std::exception_ptr error;
+            std::mutex mutex;
+            std::condition_variable all_done;
+        };
+        auto state = std::make_shared<shared_state>();
+        state->task = task;
+        state->n = n;
+        auto run_tasks = [state] {
+            for (size_t i = state->next++; i < state->n; i = state->next++) {
+                std::exception_ptr error;
+                try {
+                    state->task(i);
+                } catch (...) {
+                    error = std::current_exception();
+                }
+                std::lock_guard<std::mutex> lock(state->mutex);
+                if (error && !state->error) {
+                    state->error = error;
+                }
+                if (++state->n_done == state->n) {
+                    state->all_done.notify_all();
+                }
+            }
+        };
+        const size_t n_helpers = std::min(n, threads_.size() + 1) - 1;
+        for (size_t i = 0; i < n_helpers; ++i) {
+            submit(run_tasks);
+        }
+        run_tasks();
+        std::unique_lock<std::mutex> lock(state->mutex);
+        state->all_done.wait(lock, [&] { return state->n_done == n; });
+        if (state->error) {
+            std::rethrow_exception(state->error);
+        }
+    }
+
+    size_t thread_pool::n_threads() const { return threads_.size(); }
+
+    thread_pool &thread_pool::shared() {
+        static thread_pool pool;
+        return pool;
+    }
+
+    void thread_pool::worker_loop() {
+        while (true) {
+            std::packaged_task<void()> task;
+            {
+                std::unique_lock<std::mutex> lock(tasks_mutex_);
+                tasks_available_.wait(
+                    lock, [this] { return stop_ || !tasks_.empty(); });
+                if (tasks_.empty()) {
+                    // stop_ is true and there is nothing else to do
+                    return;
+                }
+                task = std::move(tasks_.front());
+                tasks_.pop();
+            }
+            task();
+        }
+    }
+} // namespace matplot
@@ -0,0 +1,61 @@
+#ifndef MATPLOTPLUSPLUS_THREAD_POOL_H
+#define MATPLOTPLUSPLUS_THREAD_POOL_H
+
+#include <condition_variable>
+#include <cstddef>
+#include <functional>
+#include <future>
+#include <mutex>
+#include <queue>
+#include <thread>
+#include <vector>
+
+namespace matplot {
+    /// \class thread_pool
+    /// A fixed number of threads running tasks from a queue
+    ///
+    /// Tasks should not wait for other tasks of the same pool,
+    /// or all threads might end up waiting.
+    class thread_pool {
+      public:
+        /// \brief Create a pool with n_threads threads
+        /// If n_threads is zero, we use one thread per core.
+        explicit thread_pool(size_t n_threads = 0);
+
+        thread_pool(thread_pool const &) = delete;
+        void operator=(thread_pool const &) = delete;
+
+        /// \brief Run the remaining tasks and stop the threads
+        ~thread_pool();
+
+        /// \brief Run a task on one of the threads
+        /// The future rethrows the exceptions of the task.
+        std::future<void> submit(std::function<void()> task);
+
+        /// \brief Run task(0), ..., task(n - 1) and wait for them
+        /// The calling thread runs tasks too. If all threads of the
+        /// pool are busy, it runs all of them by itself, so this can
+        /// also be called from a task of the same pool. The first
+        /// exception of the tasks is rethrown here.
+        void run_all(size_t n, const std::function<void(size_t)> &task);
+
+        /// \brief Number of threads running tasks
+        size_t n_threads() const;
+
+        /// \brief A pool with one thread per core, shared by the library
+        static thread_pool &shared();
+
+      private:
+        /// Threads take tasks from the queue until we stop
+        void worker_loop();
+
+      private:
+        std::vector<std::thread> threads_;
+        std::queue<std::packaged_task<void()>> tasks_;
+        std::mutex tasks_mutex_;
+        std::condition_variable tasks_available_;
+        bool stop_{false};
+    };
+} // namespace matplot
+
+#endif // MATPLOTPLUSPLUS_THREAD_POOL_H
@@ -0,0 +1,139 @@
+#include <glad/glad.h>
+
+#include <EGL/egl.h>
+#include <EGL/eglext.h>
+
+#include <CImg.h>
+#include <matplot/backend/opengl_3.h>
+#include <matplot/matplot.h>
+
+#include <cstring>
+#include <iostream>
+
+// Draw a figure with the OpenGL backend on a headless machine
+// and check the files it saves.
+//
+// There is no window. We create a surfaceless EGL context, which
+// Mesa supports with its software renderer (llvmpipe), and the
+// backend draws to an offscreen framebuffer.
+
+// ctest skips the test if there is no OpenGL 3.3 implementation
+constexpr int skip_test = 77;
+
+EGLDisplay get_display() {
+    // Prefer the surfaceless platform, which needs no X server,
+    // no Wayland compositor, and no GPU
+    const char *extensions =
+        eglQueryString(EGL_NO_DISPLAY, EGL_EXTENSIONS);
+    if (extensions != nullptr &&
+        std::strstr(extensions, "EGL_MESA_platform_surfaceless") != nullptr) {
+        auto get_platform_display =
+            reinterpret_cast<PFNEGLGETPLATFORMDISPLAYEXTPROC>(
+                eglGetProcAddress("eglGetPlatformDisplayEXT"));
+        if (get_platform_display != nullptr) {
+            EGLDisplay display = get_platform_display(
+                EGL_PLATFORM_SURFACELESS_MESA, EGL_DEFAULT_DISPLAY, nullptr);
+            if (display != EGL_NO_DISPLAY) {
+                return display;
+            }
+        }
+    }
+    return eglGetDisplay(EGL_DEFAULT_DISPLAY);
+}
+
+bool create_context(EGLDisplay display) {
+    if (display == EGL_NO_DISPLAY ||
+        !eglInitialize(display, nullptr, nullptr) ||
+        !eglBindAPI(EGL_OPENGL_API)) {
+        return false;
+    }
+    // We need no window surface. The default would only
+    // accept configs for windows.
+    const EGLint config_attributes[] = {EGL_SURFACE_TYPE, EGL_PBUFFER_BIT,
+                                        EGL_RENDERABLE_TYPE, EGL_OPENGL_BIT,
+                                        EGL_NONE};
+    EGLConfig config;
+    EGLint n_configs = 0;
+    if (!eglChooseConfig(display, config_attributes, &config, 1,
+                         &n_configs) ||
+        n_configs == 0) {
+        return false;
+    }
+    const EGLint context_attributes[] = {
+        EGL_CONTEXT_MAJOR_VERSION,
+        3,
+        EGL_CONTEXT_MINOR_VERSION,
+        3,
+        EGL_CONTEXT_OPENGL_PROFILE_MASK,
+        EGL_CONTEXT_OPENGL_CORE_PROFILE_BIT,
+        EGL_NONE};
+    EGLContext context =
+        eglCreateContext(display, config, EGL_NO_CONTEXT, context_attributes);
+    return context != EGL_NO_CONTEXT &&
+           eglMakeCurrent(display, EGL_NO_SURFACE, EGL_NO_SURFACE, context);
+}
+
+int main() {
+    using namespace matplot;
+
+    EGLDisplay display = get_display();
+    if (!create_context(display)) {
+        std::cerr << "Could not create an OpenGL 3.3 context with EGL"
+                  << std::endl;
+        return skip_test;
+    }
+    if (!gladLoadGLLoader((GLADloadproc)eglGetProcAddress)) {
+        std::cerr << "Failed to initialize GLAD" << std::endl;
+        return EXIT_FAILURE;
+    }
+
+    // Create figure with backend
+    auto opengl3 = create_backend<backend::opengl_3>();
+    auto f = figure(true);
+    f->backend(opengl3);
+    f->size(400, 300);
+    auto ax = f->current_axes();
+    std::vector<double> x = linspace(0., 2. * pi);
+    std::vector<double> y = transform(x, [](auto x) { return sin(x); });
+    ax->plot(x, y, "r");
+
+    // Save the same frame as PNG and as PPM, which CImg can read
+    // without any other library
+    if (!f->save("offscreen/sine.png") || !f->save("offscreen/sine.ppm")) {
+        std::cerr << "Could not save the offscreen frames" << std::endl;
+        return EXIT_FAILURE;
+    }
+    if (!opengl3->output().empty() || !opengl3->is_interactive()) {
+        std::cerr << "The output was not restored after saving" << std::endl;
+        return EXIT_FAILURE;
+    }
+
+    cimg_library::CImg<unsigned char> image("offscreen/sine.ppm");
+    if (image.width() != 400 || image.height() != 300 ||
+        image.spectrum() != 3) {
+        std::cerr << "The image has the wrong size" << std::endl;
+        return EXIT_FAILURE;
+    }
+
+    // The line is red and goes up on the left. The rows of the
+    // image go down, so the curve should be above the middle there.
+    size_t n_red = 0;
+    size_t n_red_on_top_left = 0;
+    cimg_forXY(image, i, j) {
+        if (image(i, j, 0, 0) > 200 && image(i, j, 0, 1) < 100 &&
+            image(i, j, 0, 2) < 100) {
+            ++n_red;
+            if (i < image.width() / 3 && j < image.height() / 2) {
+                ++n_red_on_top_left;
+            }
+        }
+    }
+    if (n_red == 0 || n_red_on_top_left == 0) {
+        std::cerr << "The line is not where it should be" << std::endl;
+        return EXIT_FAILURE;
+    }
+
+    std::cout << "Saved offscreen/sine.png and offscreen/sine.ppm"
+              << std::endl;
+    return EXIT_SUCCESS;
+}